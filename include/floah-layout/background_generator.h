@@ -0,0 +1,152 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-layout/block.h"
+#include "floah-layout/layout.h"
+#include "floah-layout/layout_snapshot.h"
+
+namespace floah
+{
+    /**
+     * \brief Result of generating a snapshot.
+     */
+    struct GeneratedBlocks
+    {
+        /**
+         * \brief Snapshot the blocks were generated from.
+         */
+        std::shared_ptr<const LayoutSnapshot> snapshot;
+
+        /**
+         * \brief List of blocks.
+         */
+        std::vector<Block> blocks;
+
+        /**
+         * \brief Table from element identifier to block index.
+         */
+        BlockIndex index;
+    };
+
+    /**
+     * \brief Generates layout snapshots on a worker thread. Results are double-buffered: the worker fills a back buffer
+     * and atomically publishes it once complete, so readers never wait for generation and always see a complete
+     * result. Buffers that are no longer referenced by any reader are reused for later results.
+     */
+    class BackgroundGenerator
+    {
+    public:
+        ////////////////////////////////////////////////////////////////
+        // Constructors.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Construct and start the worker thread.
+         */
+        BackgroundGenerator();
+
+        BackgroundGenerator(const BackgroundGenerator&) = delete;
+
+        BackgroundGenerator(BackgroundGenerator&&) noexcept = delete;
+
+        /**
+         * \brief Stop the worker thread. Snapshots that were submitted but not yet started are discarded.
+         */
+        ~BackgroundGenerator() noexcept;
+
+        BackgroundGenerator& operator=(const BackgroundGenerator&) = delete;
+
+        BackgroundGenerator& operator=(BackgroundGenerator&&) noexcept = delete;
+
+        ////////////////////////////////////////////////////////////////
+        // Getters.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Get the most recently published result. Never waits for the worker.
+         * \return Result, or nullptr if nothing was published yet.
+         */
+        [[nodiscard]] std::shared_ptr<const GeneratedBlocks> getResult() const noexcept;
+
+        /**
+         * \brief Get the error thrown while generating the most recent snapshot, if any.
+         * \return Exception or nullptr.
+         */
+        [[nodiscard]] std::exception_ptr getError() const;
+
+        ////////////////////////////////////////////////////////////////
+        // ...
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Queue a snapshot for generation. Replaces any queued snapshot that was not yet started.
+         * \param snapshot Snapshot.
+         */
+        void submit(std::shared_ptr<const LayoutSnapshot> snapshot);
+
+        /**
+         * \brief Block until all submitted snapshots have been generated.
+         */
+        void wait();
+
+    private:
+        void run();
+
+        ////////////////////////////////////////////////////////////////
+        // Member variables.
+        ////////////////////////////////////////////////////////////////
+
+        mutable std::mutex mutex;
+
+        /**
+         * \brief Notified when a snapshot is submitted or the worker must stop.
+         */
+        std::condition_variable submitted;
+
+        /**
+         * \brief Notified when the worker becomes idle.
+         */
+        std::condition_variable idle;
+
+        /**
+         * \brief Queued snapshot.
+         */
+        std::shared_ptr<const LayoutSnapshot> pending;
+
+        /**
+         * \brief Error of last generate.
+         */
+        std::exception_ptr error;
+
+        bool busy = false;
+
+        bool stopping = false;
+
+        /**
+         * \brief Published (front) buffer.
+         */
+        std::atomic<std::shared_ptr<const GeneratedBlocks>> front;
+
+        /**
+         * \brief Unreferenced buffer that is reused as the next back buffer. Only accessed by the worker.
+         */
+        std::shared_ptr<GeneratedBlocks> spare;
+
+        std::thread worker;
+    };
+}  // namespace floah
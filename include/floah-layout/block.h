@@ -1,5 +1,12 @@
 #pragma once
 
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <cstdint>
+#include <span>
+
 ////////////////////////////////////////////////////////////////
 // External includes.
 ////////////////////////////////////////////////////////////////
@@ -14,8 +21,70 @@
 
 namespace floah
 {
+    enum class BlockFlags : uint32_t
+    {
+        None = 0,
+
+        /**
+         * \brief Bounds of element lie completely outside of the clip rectangles. Children were not generated.
+         */
+        Culled = 1 << 0,
+
+        /**
+         * \brief Bounds of element lie completely outside of the clip rectangle of the nearest ancestor that clips its
+         * content (see LayoutElement::getContentClip). Unlike culled blocks, children were generated.
+         */
+        Clipped = 1 << 1,
+
+        /**
+         * \brief Element clips its descendants (see LayoutElement::getContentClip).
+         */
+        ClipsContent = 1 << 2,
+
+        /**
+         * \brief Bounds of element are smaller than GenerateOptions::minExtent. The element has children, but they were
+         * not generated. Renderers can draw a placeholder instead.
+         */
+        Collapsed = 1 << 3
+    };
+
+    [[nodiscard]] constexpr BlockFlags operator|(const BlockFlags lhs, const BlockFlags rhs) noexcept
+    {
+        return static_cast<BlockFlags>(static_cast<uint32_t>(lhs) | static_cast<uint32_t>(rhs));
+    }
+
+    [[nodiscard]] constexpr BlockFlags operator&(const BlockFlags lhs, const BlockFlags rhs) noexcept
+    {
+        return static_cast<BlockFlags>(static_cast<uint32_t>(lhs) & static_cast<uint32_t>(rhs));
+    }
+
+    [[nodiscard]] constexpr BlockFlags operator~(const BlockFlags flags) noexcept
+    {
+        return static_cast<BlockFlags>(~static_cast<uint32_t>(flags));
+    }
+
+    constexpr BlockFlags& operator|=(BlockFlags& lhs, const BlockFlags rhs) noexcept { return lhs = lhs | rhs; }
+
+    constexpr BlockFlags& operator&=(BlockFlags& lhs, const BlockFlags rhs) noexcept { return lhs = lhs & rhs; }
+
+    /**
+     * \brief Returns whether any of the flags in rhs are set in lhs.
+     * \param lhs Flags.
+     * \param rhs Flags to test.
+     * \return True if any flag is set.
+     */
+    [[nodiscard]] constexpr bool any(const BlockFlags lhs, const BlockFlags rhs) noexcept
+    {
+        return (lhs & rhs) != BlockFlags::None;
+    }
+
     struct Block
     {
+        /**
+         * \brief Value of parent for the root block.
+         */
+        static constexpr size_t noParent = static_cast<size_t>(-1);
+
         /**
          * \brief Identifier of layout element from which this block was generated. Note that an element may generate multiple blocks.
          */
@@ -32,7 +101,8 @@ namespace floah
         BBox childBounds;
 
         /**
-         * \brief Index of first child.
+         * \brief Index of first child. In BlockOrder::Siblings all children are contiguous. In BlockOrder::DepthFirst
+         * the first child directly follows this block and each next child starts at the subtreeEnd of the previous.
          */
         size_t firstChild = 0;
 
@@ -40,5 +110,52 @@ namespace floah
          * \brief Number of children.
          */
         size_t childCount = 0;
+
+        /**
+         * \brief Index of parent block, or noParent for the root block.
+         */
+        size_t parent = noParent;
+
+        /**
+         * \brief One past the largest index in the subtree of this block. In BlockOrder::DepthFirst the subtree occupies
+         * [index, subtreeEnd). In BlockOrder::Siblings all descendants occupy [firstChild, subtreeEnd).
+         */
+        size_t subtreeEnd = 0;
+
+        /**
+         * \brief Depth of block in the tree. The root block has depth 0.
+         */
+        uint32_t depth = 0;
+
+        /**
+         * \brief Flags.
+         */
+        BlockFlags flags = BlockFlags::None;
     };
-}  // namespace floah
\ No newline at end of file
+
+    /**
+     * \brief Get the absolute bounds of a block generated with CoordinateMode::ParentRelative, by walking up its
+     * parents. Runs in time linear in the depth of the block.
+     * \param blocks List of blocks.
+     * \param index Index of block.
+     * \return Absolute bounds.
+     */
+    [[nodiscard]] BBox resolveBounds(std::span<const Block> blocks, size_t index) noexcept;
+
+    /**
+     * \brief Convert a complete list of blocks generated with CoordinateMode::ParentRelative to absolute coordinates in
+     * place. Because a parent always has a smaller index than its children, this is a single forward pass.
+     * \param blocks List of blocks.
+     */
+    void resolveAbsolute(std::span<Block> blocks) noexcept;
+
+    /**
+     * \brief Translate the bounds and childBounds of a range of blocks. Written as a branchless loop so that the compiler
+     * can vectorize it. Useful to move a contiguous subtree (see BlockOrder::DepthFirst) of absolute blocks, or all
+     * direct children of a parent-relative block.
+     * \param blocks Blocks.
+     * \param dx Horizontal offset.
+     * \param dy Vertical offset.
+     */
+    void translateBlocks(std::span<Block> blocks, int32_t dx, int32_t dy) noexcept;
+}  // namespace floah
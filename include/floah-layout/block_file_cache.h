@@ -0,0 +1,207 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-layout/block.h"
+#include "floah-layout/generate_options.h"
+#include "floah-layout/layout.h"
+
+namespace floah
+{
+    /**
+     * \brief Persistent cache of generated blocks, to skip generating on cold start. Each entry is a file in a
+     * directory, keyed by a hash of the structure and layout parameters of the element tree (see
+     * LayoutElement::getLayoutHash), the size and offset of the layout and the generate options. The blocks are stored
+     * in an aligned array that is memory mapped when read.
+     *
+     * Element identifiers differ between runs, so instead of identifiers the file stores the position of each element
+     * in a pre-order walk of the tree, and identifiers are substituted when the blocks are read. The file also stores a
+     * fingerprint of the tree, which is compared before the file is used, so that a collision of the key hash is a miss
+     * instead of wrong blocks. Files written by a different version of this library, or on a platform with a different
+     * Block layout, are ignored and overwritten.
+     *
+     * A cache is not thread-safe: do not use it in concurrent generates.
+     */
+    class BlockFileCache
+    {
+    public:
+        ////////////////////////////////////////////////////////////////
+        // Constructors.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Construct a cache. The directory is created if it does not exist.
+         * \param directory Directory to store files in.
+         */
+        explicit BlockFileCache(std::filesystem::path directory);
+
+        BlockFileCache(const BlockFileCache&) = delete;
+
+        BlockFileCache(BlockFileCache&&) noexcept;
+
+        ~BlockFileCache() noexcept;
+
+        BlockFileCache& operator=(const BlockFileCache&) = delete;
+
+        BlockFileCache& operator=(BlockFileCache&&) noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Getters.
+        ////////////////////////////////////////////////////////////////
+
+        [[nodiscard]] const std::filesystem::path& getDirectory() const noexcept;
+
+        /**
+         * \brief Get the number of generates that were served from a file.
+         * \return Count.
+         */
+        [[nodiscard]] size_t getHitCount() const noexcept;
+
+        /**
+         * \brief Get the number of lookups that found no usable file.
+         * \return Count.
+         */
+        [[nodiscard]] size_t getMissCount() const noexcept;
+
+        /**
+         * \brief Get whether generate still looks up files. Becomes false after the first miss.
+         * \return True if cold.
+         */
+        [[nodiscard]] bool isCold() const noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Generate.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Generate all blocks, reading them from a file if possible. As long as every call hit, the next call
+         * looks up a file again, unless the layout, its structure version and the key are the same as for the previous
+         * hit, in which case the blocks of that hit are copied from memory. The first call that misses, typically after
+         * the first mutation of the layout, generates, stores the result for the next run and from then on this method
+         * just calls Layout::generate.
+         * \param layout Layout.
+         * \param blocks List of blocks. Cleared before filling.
+         * \param index Block index. Cleared before filling.
+         * \param options Options. All options except the subtree cache are part of the key.
+         */
+        void generate(const Layout&          layout,
+                      std::vector<Block>&    blocks,
+                      BlockIndex&            index,
+                      const GenerateOptions& options = {});
+
+        /**
+         * \brief Read the blocks of a layout from a file.
+         * \param layout Layout.
+         * \param blocks List of blocks. Cleared before filling. Untouched on a miss.
+         * \param index Block index. Cleared before filling. Untouched on a miss.
+         * \param options Options the blocks were generated with.
+         * \return False if there is no file for the layout, or it cannot be used.
+         */
+        bool load(const Layout& layout, std::vector<Block>& blocks, BlockIndex& index, const GenerateOptions& options);
+
+        /**
+         * \brief Write the blocks of a layout to a file, replacing any existing file for the same key.
+         * \param layout Layout.
+         * \param blocks Blocks generated from the layout.
+         * \param options Options the blocks were generated with.
+         */
+        void store(const Layout& layout, std::span<const Block> blocks, const GenerateOptions& options);
+
+        /**
+         * \brief Remove all files written by this cache from the directory and reset the counters.
+         */
+        void clear();
+
+    private:
+        /**
+         * \brief Calculate the key hash of a layout, optionally collecting its elements in pre-order.
+         * \param layout Layout.
+         * \param options Options.
+         * \param collect Whether to fill elements, positions and fingerprint. Without, only the hash is calculated.
+         * \return Hash.
+         */
+        [[nodiscard]] uint64_t walk(const Layout& layout, const GenerateOptions& options, bool collect);
+
+        /**
+         * \brief Read the blocks of the last walked layout from a file.
+         * \param hash Key hash returned by walk.
+         * \param blocks List of blocks. Untouched on a miss.
+         * \param index Block index. Untouched on a miss.
+         * \return False if there is no file for the layout, or it cannot be used.
+         */
+        bool read(uint64_t hash, std::vector<Block>& blocks, BlockIndex& index);
+
+        /**
+         * \brief Write the blocks of the last walked layout to a file.
+         * \param hash Key hash returned by walk.
+         * \param blocks Blocks generated from the layout.
+         */
+        void write(uint64_t hash, std::span<const Block> blocks);
+
+        [[nodiscard]] std::filesystem::path getPath(uint64_t hash) const;
+
+        ////////////////////////////////////////////////////////////////
+        // Member variables.
+        ////////////////////////////////////////////////////////////////
+
+        std::filesystem::path directory;
+
+        size_t hits = 0;
+
+        size_t misses = 0;
+
+        bool cold = true;
+
+        /**
+         * \brief Elements of the last walked layout, in pre-order.
+         */
+        std::vector<const LayoutElement*> elements;
+
+        /**
+         * \brief Pre-order position of each element of the last walked layout.
+         */
+        IdIndex<uint32_t> positions;
+
+        /**
+         * \brief Structural fingerprint of the last walked layout. Two words per position in the pre-order walk: the
+         * layout hash and the child count plus one of the element, or two zeros for an empty position.
+         */
+        std::vector<uint64_t> fingerprint;
+
+        /**
+         * \brief Pre-order position of the element of each block, for the file being written.
+         */
+        std::vector<uint32_t> ordinals;
+
+        /**
+         * \brief Whether the members below hold the result of the last hit.
+         */
+        bool loaded = false;
+
+        /**
+         * \brief Layout and identifier of its root element, in case another layout is created at the same address.
+         */
+        const Layout* loadedLayout = nullptr;
+
+        uuids::uuid loadedRoot;
+
+        uint64_t loadedVersion = 0;
+
+        uint64_t loadedHash = 0;
+
+        std::vector<Block> loadedBlocks;
+
+        BlockIndex loadedIndex;
+    };
+}  // namespace floah
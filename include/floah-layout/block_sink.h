@@ -0,0 +1,112 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-layout/block.h"
+#include "floah-layout/id_index.h"
+
+namespace floah
+{
+    /**
+     * \brief Receives blocks while they are generated. Implement this to convert blocks to another format (e.g.
+     * directly into mapped GPU memory) without materializing a list of blocks first.
+     */
+    class BlockSink
+    {
+    public:
+        ////////////////////////////////////////////////////////////////
+        // Constructors.
+        ////////////////////////////////////////////////////////////////
+
+        BlockSink() = default;
+
+        BlockSink(const BlockSink&) = default;
+
+        BlockSink(BlockSink&&) noexcept = default;
+
+        virtual ~BlockSink() noexcept;
+
+        BlockSink& operator=(const BlockSink&) = default;
+
+        BlockSink& operator=(BlockSink&&) noexcept = default;
+
+        ////////////////////////////////////////////////////////////////
+        // Callbacks.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Called once before any block is written.
+         * \param maxCount Upper bound on the number of blocks. All indices passed to write are smaller than this.
+         */
+        virtual void begin(size_t maxCount);
+
+        /**
+         * \brief Called exactly once for each block, as soon as it is complete (including its childBounds). Blocks are
+         * not written in index order: a block is written after all blocks in its subtree.
+         * \param index Index of block.
+         * \param block Block.
+         */
+        virtual void write(size_t index, const Block& block) = 0;
+
+        /**
+         * \brief Called once after all blocks were written. Blocks occupy the indices [0, count).
+         * \param count Number of written blocks.
+         */
+        virtual void end(size_t count);
+    };
+
+    /**
+     * \brief Sink that stores blocks in a list and fills a table from element identifier to block index.
+     */
+    class VectorBlockSink final : public BlockSink
+    {
+    public:
+        ////////////////////////////////////////////////////////////////
+        // Constructors.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Construct sink.
+         * \param b List of blocks. Overwritten on begin, reusing its storage.
+         * \param i Optional block index. Cleared on begin.
+         */
+        explicit VectorBlockSink(std::vector<Block>& b, IdIndex<size_t>* i = nullptr);
+
+        VectorBlockSink(const VectorBlockSink&) = delete;
+
+        VectorBlockSink(VectorBlockSink&&) noexcept = delete;
+
+        ~VectorBlockSink() noexcept override;
+
+        VectorBlockSink& operator=(const VectorBlockSink&) = delete;
+
+        VectorBlockSink& operator=(VectorBlockSink&&) noexcept = delete;
+
+        ////////////////////////////////////////////////////////////////
+        // Callbacks.
+        ////////////////////////////////////////////////////////////////
+
+        void begin(size_t maxCount) override;
+
+        void write(size_t index, const Block& block) override;
+
+        void end(size_t count) override;
+
+    private:
+        ////////////////////////////////////////////////////////////////
+        // Member variables.
+        ////////////////////////////////////////////////////////////////
+
+        std::vector<Block>& blocks;
+
+        IdIndex<size_t>* blockIndex = nullptr;
+    };
+}  // namespace floah
@@ -5,6 +5,9 @@
 ////////////////////////////////////////////////////////////////
 
 #include <cassert>
+#include <cstdint>
+#include <optional>
+#include <span>
 #include <vector>
 
 ////////////////////////////////////////////////////////////////
@@ -16,9 +19,83 @@
 
 namespace floah
 {
+    class SnapshotChildren;
+    class SnapshotNode;
+
+    /**
+     * \brief Element that places its child elements in a grid of uniform cells. An element is anchored at its top-left
+     * cell and can span multiple columns and rows. Which cells are covered is tracked in an occupancy bitmap with one
+     * bit per cell, so that overlap checks and searches for free cells test 64 cells at a time.
+     */
     class Grid final : public LayoutElement
     {
+        friend class SnapshotTree;
+
     public:
+        /**
+         * \brief Uniform cell geometry of a grid. Because all cells have the same size, the bounds of any cell follow directly from the origin and cell size.
+         */
+        struct Geometry
+        {
+            /**
+             * \brief Left of first column (i.e. bounds.x0 plus left margin).
+             */
+            int32_t x = 0;
+
+            /**
+             * \brief Top of first row (i.e. bounds.y0 plus top margin).
+             */
+            int32_t y = 0;
+
+            /**
+             * \brief Inner width (i.e. bounds width minus left and right margin).
+             */
+            int32_t width = 0;
+
+            /**
+             * \brief Inner height (i.e. bounds height minus top and bottom margin).
+             */
+            int32_t height = 0;
+
+            /**
+             * \brief Width of a single cell.
+             */
+            int32_t cellWidth = 0;
+
+            /**
+             * \brief Height of a single cell.
+             */
+            int32_t cellHeight = 0;
+
+            /**
+             * \brief Number of columns.
+             */
+            size_t columnCount = 0;
+
+            /**
+             * \brief Number of rows.
+             */
+            size_t rowCount = 0;
+        };
+
+        /**
+         * \brief Column and row index of a cell.
+         */
+        struct CellIndex
+        {
+            size_t x = 0;
+            size_t y = 0;
+        };
+
+        /**
+         * \brief Number of columns and rows covered by an element.
+         */
+        struct CellSpan
+        {
+            size_t columns = 1;
+            size_t rows    = 1;
+        };
+
         ////////////////////////////////////////////////////////////////
         // Constructors.
         ////////////////////////////////////////////////////////////////
@@ -27,13 +104,13 @@ namespace floah
 
         Grid(const Grid&);
 
-        Grid(Grid&&) noexcept = delete;
+        Grid(Grid&&) noexcept;
 
         ~Grid() noexcept override;
 
         Grid& operator=(const Grid&);
 
-        Grid& operator=(Grid&&) noexcept = delete;
+        Grid& operator=(Grid&&) noexcept;
 
         [[nodiscard]] LayoutElementPtr clone(Layout* l, LayoutElement* p) const override;
 
@@ -65,11 +142,78 @@ namespace floah
          */
         [[nodiscard]] size_t getColumnCount() const noexcept;
 
+        /**
+         * \brief Get the span of the element anchored at (x, y).
+         * \param x Column index.
+         * \param y Row index.
+         * \return Span. 1 by 1 if there is no element or it does not span multiple cells.
+         */
+        [[nodiscard]] CellSpan getSpan(size_t x, size_t y) const;
+
+        /**
+         * \brief Returns whether cell (x, y) is covered by an element, either anchored there or spanning it.
+         * \param x Column index.
+         * \param y Row index.
+         * \return True if occupied.
+         */
+        [[nodiscard]] bool isOccupied(size_t x, size_t y) const;
+
+        /**
+         * \brief Find the first free region of columns by rows cells, in row-major order of its top-left cell.
+         * \param columns Number of columns.
+         * \param rows Number of rows.
+         * \return Top-left cell of region, or std::nullopt if there is no free region of that size.
+         */
+        [[nodiscard]] std::optional<CellIndex> findFreeRegion(size_t columns, size_t rows) const noexcept;
+
+        [[nodiscard]] bool isLayoutEqual(const LayoutElement& other) const noexcept override;
+
+        [[nodiscard]] uint64_t getLayoutHash() const noexcept override;
+
+        [[nodiscard]] std::span<const LayoutElementPtr> getChildren() const noexcept override;
+
         ////////////////////////////////////////////////////////////////
-        // Setters.
+        // Geometry.
         ////////////////////////////////////////////////////////////////
 
-        void setLayout(Layout* l) noexcept override;
+        /**
+         * \brief Calculate the cell geometry for the given bounds of this grid.
+         * \param bounds Bounds of this grid.
+         * \return Geometry.
+         */
+        [[nodiscard]] Geometry calculateGeometry(const BBox& bounds) const noexcept;
+
+        /**
+         * \brief Find the cell that contains a point. Runs in constant time.
+         * \param bounds Bounds of this grid, e.g. from its generated block.
+         * \param px Absolute x-coordinate.
+         * \param py Absolute y-coordinate.
+         * \return Cell index, or std::nullopt if the point lies outside of all cells.
+         */
+        [[nodiscard]] std::optional<CellIndex> getCellAt(const BBox& bounds, int32_t px, int32_t py) const noexcept;
+
+        /**
+         * \brief Get the bounds of cell (x, y). Runs in constant time.
+         * \param bounds Bounds of this grid, e.g. from its generated block.
+         * \param x Column index.
+         * \param y Row index.
+         * \return Cell bounds.
+         */
+        [[nodiscard]] BBox getCellBounds(const BBox& bounds, size_t x, size_t y) const;
+
+        /**
+         * \brief Calculate the bounds of a contiguous range of cells in a single row. Written as a branchless loop over
+         * the cells so that the compiler can vectorize it.
+         * \param geometry Geometry.
+         * \param x Column index of first cell.
+         * \param y Row index.
+         * \param bounds Output bounds, one per cell.
+         */
+        static void calculateCellBounds(const Geometry& geometry, size_t x, size_t y, std::span<BBox> bounds) noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Setters.
+        ////////////////////////////////////////////////////////////////
 
         /**
          * \brief Set the horizontal alignment for child elements.
@@ -89,7 +233,15 @@ namespace floah
 
         void countBlocks(size_t& count) const noexcept override;
 
-        void generate(std::vector<Block>& blocks, Block& block) const override;
+        void layoutChildren(const BBox& bounds, std::span<BBox> childBounds, LayoutScratch& scratch) const override;
+
+        ////////////////////////////////////////////////////////////////
+        // Memory.
+        ////////////////////////////////////////////////////////////////
+
+        void addMemoryUsage(MemoryUsage& usage) const override;
+
+        void shrinkToFit() override;
 
         ////////////////////////////////////////////////////////////////
         // Rows/Cols.
@@ -121,6 +273,13 @@ namespace floah
          */
         void insertRow(size_t y);
 
+        /**
+         * \brief Insert count empty rows at y. All elements with y-index >= y are shifted down once.
+         * \param y Row index.
+         * \param count Number of rows.
+         */
+        void insertRows(size_t y, size_t count);
+
         /**
          * \brief Insert empty column at x. All elements with x-index >= x are shifted right.
          * \param x Column index.
@@ -161,30 +320,45 @@ namespace floah
         ////////////////////////////////////////////////////////////////
 
         /**
-         * \brief Get element at (x, y).
+         * \brief Get element anchored at (x, y).
          * \param x Column index.
          * \param y Row index.
-         * \return Element or nullptr if no element was inserted.
+         * \return Element or nullptr if no element was inserted (cells covered by a spanning element anchored
+         * elsewhere also return nullptr).
          */
         LayoutElement* get(size_t x, size_t y);
 
         /**
-         * \brief Insert an element at (x, y). Replaces existing element, if any.
+         * \brief Insert an element at (x, y), spanning columns by rows cells. Replaces the element anchored at (x, y),
+         * if any. The other cells in the region must not be covered by another element.
          * \tparam T Element type.
          * \param elem Element.
          * \param x Column index.
          * \param y Row index.
+         * \param columns Number of columns.
+         * \param rows Number of rows.
          * \return Element.
          */
         template<std::derived_from<LayoutElement> T>
-        T& insert(std::unique_ptr<T> elem, const size_t x, const size_t y)
+        T& insert(std::unique_ptr<T> elem, const size_t x, const size_t y, const size_t columns = 1, const size_t rows = 1)
         {
             assert(elem);
             T& elemRef = *elem;
-            insertImpl(std::move(elem), x, y);
+            insertImpl(std::move(elem), x, y, columns, rows);
             return elemRef;
         }
 
+        /**
+         * \brief Place a row-major list of elements in the region of width by height cells starting at (x, y). Replaces
+         * existing elements anchored in the region. The region must not be covered by elements anchored outside of it.
+         * \param elems Elements (can contain nullptrs, which leave the cell empty). Must contain width * height elements.
+         * \param x Column index of first cell.
+         * \param y Row index of first cell.
+         * \param width Number of columns.
+         * \param height Number of rows.
+         */
+        void fillRegion(std::vector<LayoutElementPtr> elems, size_t x, size_t y, size_t width, size_t height);
+
         /**
          * \brief Remove element at (x, y).
          * \param x Column index.
@@ -200,8 +374,128 @@ namespace floah
          */
         [[nodiscard]] LayoutElementPtr extract(size_t x, size_t y);
 
+    protected:
+        [[nodiscard]] std::span<LayoutElementPtr> getChildSlots() noexcept override;
+
+        bool swapChildren(LayoutElement& other) noexcept override;
+
     private:
-        void insertImpl(LayoutElementPtr elem, size_t x, size_t y);
+        /**
+         * \brief Calculate the cell geometry of a grid (see calculateGeometry).
+         * \param innerMargin Inner margin of the grid.
+         * \param columns Number of columns.
+         * \param rows Number of rows.
+         * \param bounds Bounds of the grid.
+         * \return Geometry.
+         */
+        [[nodiscard]] static Geometry
+          calculateGeometry(const Margin& innerMargin, size_t columns, size_t rows, const BBox& bounds) noexcept;
+
+        /**
+         * \brief Lay out the children of a snapshot node captured from a Grid (see layoutChildren).
+         * \param node Node.
+         * \param children Child nodes, one per cell.
+         * \param bounds Absolute bounds of node.
+         * \param childBounds Output bounds, one per child node.
+         * \param scratch Memory for intermediate results.
+         */
+        static void layoutNode(const SnapshotNode&     node,
+                               const SnapshotChildren& children,
+                               const BBox&             bounds,
+                               std::span<BBox>         childBounds,
+                               LayoutScratch&          scratch);
+
+        /**
+         * \brief Lay out the children of a Grid or of a snapshot node captured from one.
+         * \tparam G Grid or SnapshotNode.
+         * \tparam Children List of children (see LayoutElement::getChildren and SnapshotChildren).
+         * \tparam SpanAt Callable that returns the CellSpan of the element anchored at cell (x, y). Called for all
+         * cells in row-major order.
+         */
+        template<typename G, typename Children, typename SpanAt>
+        static void layoutGrid(const G&        grid,
+                               const Children& children,
+                               const BBox&     bounds,
+                               std::span<BBox> childBounds,
+                               LayoutScratch&  scratch,
+                               SpanAt&&        spanAt);
+
+        /**
+         * \brief Region covered by an element that spans more than one cell.
+         */
+        struct Span
+        {
+            size_t x       = 0;
+            size_t y       = 0;
+            size_t columns = 1;
+            size_t rows    = 1;
+
+            [[nodiscard]] bool operator==(const Span&) const noexcept = default;
+        };
+
+        void insertImpl(LayoutElementPtr elem, size_t x, size_t y, size_t columns, size_t rows);
+
+        /**
+         * \brief Find the span of the element anchored at (x, y).
+         * \param x Column index.
+         * \param y Row index.
+         * \return Iterator to span, or end if the element does not span multiple cells.
+         */
+        [[nodiscard]] std::vector<Span>::const_iterator findSpan(size_t x, size_t y) const noexcept;
+
+        /**
+         * \brief Remove the element anchored at (x, y) from the occupancy bitmap and the list of spans.
+         * \param x Column index.
+         * \param y Row index.
+         */
+        void releaseCells(size_t x, size_t y) noexcept;
+
+        /**
+         * \brief Get the number of 64-bit words per row of the occupancy bitmap.
+         * \return Stride.
+         */
+        [[nodiscard]] size_t getOccupancyStride() const noexcept;
+
+        /**
+         * \brief Find the first occupied cell in count cells of row y, starting at column x.
+         * \param x Column index.
+         * \param y Row index.
+         * \param count Number of cells.
+         * \return Column index of occupied cell, or columnCount if all are free.
+         */
+        [[nodiscard]] size_t findOccupied(size_t x, size_t y, size_t count) const noexcept;
+
+        [[nodiscard]] bool isRegionOccupied(size_t x, size_t y, size_t columns, size_t rows) const noexcept;
+
+        void setRegionOccupied(size_t x, size_t y, size_t columns, size_t rows, bool value) noexcept;
+
+        /**
+         * \brief Update spans and occupancy bitmap after rows were inserted. Spans that cross the inserted rows grow.
+         * \param y Index of first inserted row.
+         * \param count Number of rows.
+         */
+        void insertOccupancyRows(size_t y, size_t count);
+
+        /**
+         * \brief Update spans and occupancy bitmap after a column was inserted. Spans that cross the inserted column
+         * grow. Must be called with the new column count.
+         * \param x Index of inserted column.
+         */
+        void insertOccupancyColumn(size_t x);
+
+        /**
+         * \brief Update spans and occupancy bitmap before a row is removed. Spans anchored in the row are removed,
+         * spans that cross it shrink. Must be called with the old row count.
+         * \param y Row index.
+         */
+        void removeOccupancyRow(size_t y) noexcept;
+
+        /**
+         * \brief Update spans and occupancy bitmap before a column is removed. Spans anchored in the column are
+         * removed, spans that cross it shrink. Must be called with the old column count.
+         * \param x Column index.
+         */
+        void removeOccupancyColumn(size_t x);
 
         /**
          * \brief Horizontal alignment.
@@ -224,8 +518,18 @@ namespace floah
         size_t columnCount = 0;
 
         /**
-         * \brief Row-major list of child elements.
+         * \brief Row-major list of child elements, stored at their anchor cell.
          */
         std::vector<LayoutElementPtr> children;
+
+        /**
+         * \brief Regions of all elements that span more than one cell, in row-major order of their anchor cell.
+         */
+        std::vector<Span> spans;
+
+        /**
+         * \brief Row-major occupancy bitmap with one bit per cell and getOccupancyStride() words per row.
+         */
+        std::vector<uint64_t> occupancy;
     };
 }  // namespace floah
@@ -0,0 +1,230 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <cassert>
+#include <span>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-layout/block.h"
+#include "floah-layout/generate_options.h"
+#include "floah-layout/layout_element.h"
+
+namespace floah
+{
+    class SnapshotChildren;
+    class SnapshotNode;
+
+    /**
+     * \brief Element that shows a scrollable region of a single content element. The viewport is the bounds minus the
+     * inner margin. The content area has its own size, relative to the viewport, and is placed at the top-left of the
+     * viewport minus the scroll offset. The content element is laid out in the content area and clipped to the viewport.
+     */
+    class ScrollView final : public LayoutElement
+    {
+        friend class SnapshotTree;
+
+    public:
+        ////////////////////////////////////////////////////////////////
+        // Constructors.
+        ////////////////////////////////////////////////////////////////
+
+        ScrollView();
+
+        ScrollView(const ScrollView&);
+
+        ScrollView(ScrollView&&) noexcept;
+
+        ~ScrollView() noexcept override;
+
+        ScrollView& operator=(const ScrollView&);
+
+        ScrollView& operator=(ScrollView&&) noexcept;
+
+        [[nodiscard]] LayoutElementPtr clone(Layout* l, LayoutElement* p) const override;
+
+        ////////////////////////////////////////////////////////////////
+        // Getters.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Get the size of the content area. Relative lengths are relative to the viewport.
+         * \return Content size.
+         */
+        [[nodiscard]] Size& getContentSize() noexcept;
+
+        [[nodiscard]] const Size& getContentSize() const noexcept;
+
+        /**
+         * \brief Get the horizontal scroll offset.
+         * \return Offset.
+         */
+        [[nodiscard]] int32_t getScrollX() const noexcept;
+
+        /**
+         * \brief Get the vertical scroll offset.
+         * \return Offset.
+         */
+        [[nodiscard]] int32_t getScrollY() const noexcept;
+
+        /**
+         * \brief Get the content element.
+         * \return Content element or nullptr.
+         */
+        [[nodiscard]] LayoutElement* getContent() const noexcept;
+
+        [[nodiscard]] bool isLayoutEqual(const LayoutElement& other) const noexcept override;
+
+        [[nodiscard]] uint64_t getLayoutHash() const noexcept override;
+
+        [[nodiscard]] std::span<const LayoutElementPtr> getChildren() const noexcept override;
+
+        ////////////////////////////////////////////////////////////////
+        // Setters.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Set the scroll offset. During generate, the offset is clamped so that the viewport stays inside of the
+         * content area.
+         * \param x Horizontal offset.
+         * \param y Vertical offset.
+         */
+        void setScrollOffset(int32_t x, int32_t y) noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Generate.
+        ////////////////////////////////////////////////////////////////
+
+        void countBlocks(size_t& count) const noexcept override;
+
+        void layoutChildren(const BBox& bounds, std::span<BBox> childBounds, LayoutScratch& scratch) const override;
+
+        [[nodiscard]] bool getContentClip(const BBox& bounds, BBox& clip) const noexcept override;
+
+        ////////////////////////////////////////////////////////////////
+        // Memory.
+        ////////////////////////////////////////////////////////////////
+
+        void addMemoryUsage(MemoryUsage& usage) const override;
+
+        /**
+         * \brief Set the scroll offset and update the blocks of a previous generate to match, instead of generating
+         * again. Only the content blocks are translated: with CoordinateMode::Absolute this is a single vectorizable
+         * pass over the contiguous content subtree, with CoordinateMode::ParentRelative only the content block itself
+         * moves. The childBounds of the blocks of this element and its ancestors are not updated. If the blocks were not
+         * generated in depth-first order, an exception is thrown and the offset is left unchanged.
+         * \param blocks Blocks of a previous generate in BlockOrder::DepthFirst, with the current scroll offset.
+         * \param index Index of the block of this element.
+         * \param x New horizontal offset.
+         * \param y New vertical offset.
+         * \param coordinates Coordinate mode of the blocks.
+         * \param cull If true, also update BlockFlags::Clipped of the content blocks. Blocks inside of nested clipping
+         * elements are left untouched, since they move together with their clip rectangle.
+         */
+        void scroll(std::span<Block> blocks,
+                    size_t           index,
+                    int32_t          x,
+                    int32_t          y,
+                    CoordinateMode   coordinates = CoordinateMode::Absolute,
+                    bool             cull        = true);
+
+        ////////////////////////////////////////////////////////////////
+        // Elements.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Set the content element. Replaces the existing content element, if any.
+         * \tparam T Element type.
+         * \param elem Element.
+         * \return Element.
+         */
+        template<std::derived_from<LayoutElement> T>
+        T& setContent(std::unique_ptr<T> elem)
+        {
+            assert(elem);
+            T& elemRef = *elem;
+            setContentImpl(std::move(elem));
+            return elemRef;
+        }
+
+        /**
+         * \brief Remove the content element and return it.
+         * \return Content element or nullptr.
+         */
+        [[nodiscard]] LayoutElementPtr extractContent();
+
+    protected:
+        [[nodiscard]] std::span<LayoutElementPtr> getChildSlots() noexcept override;
+
+        bool swapChildren(LayoutElement& other) noexcept override;
+
+    private:
+        void setContentImpl(LayoutElementPtr elem);
+
+        /**
+         * \brief Lay out the content of a snapshot node captured from a ScrollView (see layoutChildren).
+         * \param node Node.
+         * \param children Child nodes.
+         * \param bounds Absolute bounds of node.
+         * \param childBounds Output bounds, one per child node.
+         */
+        static void layoutNode(const SnapshotNode&     node,
+                               const SnapshotChildren& children,
+                               const BBox&             bounds,
+                               std::span<BBox>         childBounds);
+
+        /**
+         * \brief Place the content element or node at the top-left of the content area.
+         * \tparam T LayoutElement or SnapshotNode.
+         * \param content Content.
+         * \param area Content area.
+         * \param b Output bounds of content.
+         */
+        template<typename T>
+        static void placeContent(const T& content, const BBox& area, BBox& b) noexcept;
+
+        /**
+         * \brief Calculate the viewport for the given bounds.
+         * \param innerMargin Inner margin.
+         * \param bounds Bounds.
+         * \return Viewport.
+         */
+        [[nodiscard]] static BBox calculateViewport(const Margin& innerMargin, const BBox& bounds) noexcept;
+
+        /**
+         * \brief Calculate the bounds of the content area for the given viewport, with the offset clamped.
+         * \param contentSize Size of content area.
+         * \param viewport Viewport.
+         * \param x Horizontal offset.
+         * \param y Vertical offset.
+         * \return Content area.
+         */
+        [[nodiscard]] static BBox
+          calculateContentArea(const Size& contentSize, const BBox& viewport, int32_t x, int32_t y) noexcept;
+
+        /**
+         * \brief Size of content area.
+         */
+        Size contentSize;
+
+        /**
+         * \brief Horizontal scroll offset.
+         */
+        int32_t scrollX = 0;
+
+        /**
+         * \brief Vertical scroll offset.
+         */
+        int32_t scrollY = 0;
+
+        /**
+         * \brief Content element.
+         */
+        LayoutElementPtr content;
+    };
+}  // namespace floah
@@ -16,8 +16,13 @@
 
 namespace floah
 {
+    class SnapshotChildren;
+    class SnapshotNode;
+
     class VerticalFlow final : public LayoutElement
     {
+        friend class SnapshotTree;
+
     public:
         ////////////////////////////////////////////////////////////////
         // Constructors.
@@ -27,13 +32,13 @@ namespace floah
 
         VerticalFlow(const VerticalFlow&);
 
-        VerticalFlow(VerticalFlow&&) noexcept = delete;
+        VerticalFlow(VerticalFlow&&) noexcept;
 
         ~VerticalFlow() noexcept override;
 
         VerticalFlow& operator=(const VerticalFlow&);
 
-        VerticalFlow& operator=(VerticalFlow&&) noexcept = delete;
+        VerticalFlow& operator=(VerticalFlow&&) noexcept;
 
         [[nodiscard]] LayoutElementPtr clone(Layout* l, LayoutElement* p) const override;
 
@@ -59,12 +64,16 @@ namespace floah
          */
         [[nodiscard]] size_t getChildCount() const noexcept;
 
+        [[nodiscard]] bool isLayoutEqual(const LayoutElement& other) const noexcept override;
+
+        [[nodiscard]] uint64_t getLayoutHash() const noexcept override;
+
+        [[nodiscard]] std::span<const LayoutElementPtr> getChildren() const noexcept override;
+
         ////////////////////////////////////////////////////////////////
         // Setters.
         ////////////////////////////////////////////////////////////////
 
-        void setLayout(Layout* l) noexcept override;
-
         /**
          * \brief Set the horizontal alignment for child elements.
          * \param alignment Horizontal alignment.
@@ -83,7 +92,15 @@ namespace floah
 
         void countBlocks(size_t& count) const noexcept override;
 
-        void generate(std::vector<Block>& blocks, Block& block) const override;
+        void layoutChildren(const BBox& bounds, std::span<BBox> childBounds, LayoutScratch& scratch) const override;
+
+        ////////////////////////////////////////////////////////////////
+        // Memory.
+        ////////////////////////////////////////////////////////////////
+
+        void addMemoryUsage(MemoryUsage& usage) const override;
+
+        void shrinkToFit() override;
 
         ////////////////////////////////////////////////////////////////
         // Elements.
@@ -142,6 +159,25 @@ namespace floah
             return elemRef;
         }
 
+        /**
+         * \brief Add a list of elements to the end.
+         * \param elems Elements.
+         */
+        void appendRange(std::vector<LayoutElementPtr> elems);
+
+        /**
+         * \brief Insert a list of elements at index. All elements at position >= index are shifted down once.
+         * \param elems Elements.
+         * \param index Index.
+         */
+        void insertRange(std::vector<LayoutElementPtr> elems, size_t index);
+
+        /**
+         * \brief Reserve space for a number of child elements.
+         * \param count Total number of child elements.
+         */
+        void reserve(size_t count);
+
         /**
          * \brief Remove element at index. All elements at position > index are shifted up.
          * \param index Index.
@@ -155,7 +191,35 @@ namespace floah
          */
         [[nodiscard]] LayoutElementPtr extract(size_t index);
 
+        /**
+         * \brief Remove count elements starting at index and return them. All elements at position >= index + count are
+         * shifted up once.
+         * \param index Index of first element.
+         * \param count Number of elements.
+         * \return Removed elements.
+         */
+        [[nodiscard]] std::vector<LayoutElementPtr> extractRange(size_t index, size_t count);
+
+    protected:
+        [[nodiscard]] std::span<LayoutElementPtr> getChildSlots() noexcept override;
+
+        bool swapChildren(LayoutElement& other) noexcept override;
+
     private:
+        /**
+         * \brief Lay out the children of a snapshot node captured from a VerticalFlow (see layoutChildren).
+         * \param node Node.
+         * \param children Child nodes.
+         * \param bounds Absolute bounds of node.
+         * \param childBounds Output bounds, one per child node.
+         * \param scratch Memory for intermediate results.
+         */
+        static void layoutNode(const SnapshotNode&     node,
+                               const SnapshotChildren& children,
+                               const BBox&             bounds,
+                               std::span<BBox>         childBounds,
+                               LayoutScratch&          scratch);
+
         void appendImpl(LayoutElementPtr elem);
 
         void prependImpl(LayoutElementPtr elem);
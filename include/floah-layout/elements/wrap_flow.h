@@ -0,0 +1,336 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-layout/layout_element.h"
+#include "floah-layout/line_breaks.h"
+#include "floah-common/alignment.h"
+
+namespace floah
+{
+    class SnapshotChildren;
+    class SnapshotNode;
+
+    /**
+     * \brief Flow that places child elements next to each other and wraps onto a new line when the next element does
+     * not fit in the remaining width. Lines are stacked from the top. Lines are broken in a single pass over the
+     * extents of the child elements. When generating with a GenerateCache, the extents and line breaks are kept in the
+     * cache, so that on the next generate only the lines starting at the first line affected by a change in width or
+     * child extents are broken again. The flow itself is never modified by generating.
+     */
+    class WrapFlow final : public LayoutElement
+    {
+        friend class SnapshotTree;
+
+    public:
+        ////////////////////////////////////////////////////////////////
+        // Constructors.
+        ////////////////////////////////////////////////////////////////
+
+        WrapFlow();
+
+        WrapFlow(const WrapFlow&);
+
+        WrapFlow(WrapFlow&&) noexcept;
+
+        ~WrapFlow() noexcept override;
+
+        WrapFlow& operator=(const WrapFlow&);
+
+        WrapFlow& operator=(WrapFlow&&) noexcept;
+
+        [[nodiscard]] LayoutElementPtr clone(Layout* l, LayoutElement* p) const override;
+
+        ////////////////////////////////////////////////////////////////
+        // Getters.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Get the horizontal alignment of each line.
+         * \return Horizontal alignment.
+         */
+        [[nodiscard]] HorizontalAlignment getHorizontalAlignment() const noexcept;
+
+        /**
+         * \brief Get the vertical alignment of child elements within their line.
+         * \return Vertical alignment.
+         */
+        [[nodiscard]] VerticalAlignment getVerticalAlignment() const noexcept;
+
+        /**
+         * \brief Get the number of child elements.
+         * \return Child count.
+         */
+        [[nodiscard]] size_t getChildCount() const noexcept;
+
+        /**
+         * \brief Calculate the number of lines the child elements are broken into. Runs in linear time.
+         * \param bounds Bounds of this flow, e.g. from its generated block.
+         * \return Line count.
+         */
+        [[nodiscard]] size_t getLineCount(const BBox& bounds) const;
+
+        [[nodiscard]] bool isLayoutEqual(const LayoutElement& other) const noexcept override;
+
+        [[nodiscard]] uint64_t getLayoutHash() const noexcept override;
+
+        [[nodiscard]] std::span<const LayoutElementPtr> getChildren() const noexcept override;
+
+        ////////////////////////////////////////////////////////////////
+        // Setters.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Set the horizontal alignment of each line.
+         * \param alignment Horizontal alignment.
+         */
+        void setHorizontalAlignment(HorizontalAlignment alignment) noexcept;
+
+        /**
+         * \brief Set the vertical alignment of child elements within their line.
+         * \param alignment Vertical alignment.
+         */
+        void setVerticalAlignment(VerticalAlignment alignment) noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Generate.
+        ////////////////////////////////////////////////////////////////
+
+        void countBlocks(size_t& count) const noexcept override;
+
+        void layoutChildren(const BBox& bounds, std::span<BBox> childBounds, LayoutScratch& scratch) const override;
+
+        ////////////////////////////////////////////////////////////////
+        // Memory.
+        ////////////////////////////////////////////////////////////////
+
+        void addMemoryUsage(MemoryUsage& usage) const override;
+
+        void shrinkToFit() override;
+
+        ////////////////////////////////////////////////////////////////
+        // Elements.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Get element at index.
+         * \param index Index.
+         * \return Element.
+         */
+        [[nodiscard]] LayoutElement& get(size_t index) const;
+
+        /**
+         * \brief Add an element to the end.
+         * \tparam T Element type.
+         * \param elem Element.
+         * \return Element.
+         */
+        template<std::derived_from<LayoutElement> T>
+        T& append(std::unique_ptr<T> elem)
+        {
+            assert(elem);
+            T& elemRef = *elem;
+            appendImpl(std::move(elem));
+            return elemRef;
+        }
+
+        /**
+         * \brief Add an element to the front. All elements are shifted right.
+         * \tparam T Element type.
+         * \param elem Element.
+         * \return Element.
+         */
+        template<std::derived_from<LayoutElement> T>
+        T& prepend(std::unique_ptr<T> elem)
+        {
+            assert(elem);
+            T& elemRef = *elem;
+            prependImpl(std::move(elem));
+            return elemRef;
+        }
+
+        /**
+         * \brief Insert an element at index. All elements at position >= index are shifted right.
+         * \tparam T Element type.
+         * \param elem Element.
+         * \param index Index.
+         * \return Element.
+         */
+        template<std::derived_from<LayoutElement> T>
+        T& insert(std::unique_ptr<T> elem, const size_t index)
+        {
+            assert(elem);
+            T& elemRef = *elem;
+            insertImpl(std::move(elem), index);
+            return elemRef;
+        }
+
+        /**
+         * \brief Add a list of elements to the end.
+         * \param elems Elements.
+         */
+        void appendRange(std::vector<LayoutElementPtr> elems);
+
+        /**
+         * \brief Insert a list of elements at index. All elements at position >= index are shifted right once.
+         * \param elems Elements.
+         * \param index Index.
+         */
+        void insertRange(std::vector<LayoutElementPtr> elems, size_t index);
+
+        /**
+         * \brief Reserve space for a number of child elements.
+         * \param count Total number of child elements.
+         */
+        void reserve(size_t count);
+
+        /**
+         * \brief Remove element at index. All elements at position > index are shifted left.
+         * \param index Index.
+         */
+        void remove(size_t index);
+
+        /**
+         * \brief Remove element at index and return it. All elements at position > index are shifted left.
+         * \param index Index.
+         * \return Removed element.
+         */
+        [[nodiscard]] LayoutElementPtr extract(size_t index);
+
+        /**
+         * \brief Remove count elements starting at index and return them. All elements at position >= index + count are
+         * shifted left once.
+         * \param index Index of first element.
+         * \param count Number of elements.
+         * \return Removed elements.
+         */
+        [[nodiscard]] std::vector<LayoutElementPtr> extractRange(size_t index, size_t count);
+
+    protected:
+        [[nodiscard]] std::span<LayoutElementPtr> getChildSlots() noexcept override;
+
+        bool swapChildren(LayoutElement& other) noexcept override;
+
+    private:
+        using Extent = LineBreaks::Extent;
+
+        using Line = LineBreaks::Line;
+
+        /**
+         * \brief Lay out the children of a snapshot node captured from a WrapFlow (see layoutChildren).
+         * \param node Node.
+         * \param children Child nodes.
+         * \param bounds Absolute bounds of node.
+         * \param childBounds Output bounds, one per child node.
+         * \param scratch Memory for intermediate results.
+         */
+        static void layoutNode(const SnapshotNode&     node,
+                               const SnapshotChildren& children,
+                               const BBox&             bounds,
+                               std::span<BBox>         childBounds,
+                               LayoutScratch&          scratch);
+
+        /**
+         * \brief Lay out the children of a WrapFlow or of a snapshot node captured from one.
+         * \tparam Flow WrapFlow or SnapshotNode.
+         * \tparam Children List of children (see LayoutElement::getChildren and SnapshotChildren).
+         */
+        template<typename Flow, typename Children>
+        static void layoutFlow(const Flow&     flow,
+                               const Children& children,
+                               const BBox&     bounds,
+                               std::span<BBox> childBounds,
+                               LayoutScratch&  scratch);
+
+        /**
+         * \brief Calculate the area inside of the inner margin.
+         * \param innerMargin Inner margin of the flow.
+         * \param bounds Bounds of the flow.
+         * \return Inner area.
+         */
+        [[nodiscard]] static BBox calculateInnerArea(const Margin& innerMargin, const BBox& bounds) noexcept;
+
+        /**
+         * \brief Calculate the extents of all child elements for the given inner size.
+         * \param children Child elements.
+         * \param width Inner width.
+         * \param height Inner height.
+         * \param extents Output extents, one per child element.
+         */
+        template<typename Children>
+        static void calculateExtents(const Children&   children,
+                                     int32_t           width,
+                                     int32_t           height,
+                                     std::span<Extent> extents) noexcept;
+
+        /**
+         * \brief Break the next line.
+         * \param extents Extents of all child elements.
+         * \param first Index of first child element of the line.
+         * \param width Inner width.
+         * \return Line.
+         */
+        [[nodiscard]] static Line breakLine(std::span<const Extent> extents, size_t first, int32_t width) noexcept;
+
+        /**
+         * \brief Update the line breaks of the previous generate for the given inner size. Keeps all leading lines that
+         * are not affected by a change and breaks the remaining lines in a single pass.
+         * \param children Child elements.
+         * \param breaks Line breaks.
+         * \param width Inner width.
+         * \param height Inner height.
+         */
+        template<typename Children>
+        static void updateLineBreaks(const Children& children, LineBreaks& breaks, int32_t width, int32_t height);
+
+        /**
+         * \brief Place the child elements of a line.
+         * \param horAlign Horizontal alignment of the flow.
+         * \param verAlign Vertical alignment of the flow.
+         * \param line Line.
+         * \param extents Extents of all child elements.
+         * \param area Inner area of the flow.
+         * \param y Top of the line.
+         * \param childBounds Output bounds.
+         * \return Top of the next line.
+         */
+        [[nodiscard]] static int32_t placeLine(HorizontalAlignment     horAlign,
+                                               VerticalAlignment       verAlign,
+                                               const Line&             line,
+                                               std::span<const Extent> extents,
+                                               const BBox&             area,
+                                               int32_t                 y,
+                                               std::span<BBox>         childBounds) noexcept;
+
+        void appendImpl(LayoutElementPtr elem);
+
+        void prependImpl(LayoutElementPtr elem);
+
+        void insertImpl(LayoutElementPtr elem, size_t index);
+
+        /**
+         * \brief Horizontal alignment.
+         */
+        HorizontalAlignment horAlign = HorizontalAlignment::Left;
+
+        /**
+         * \brief Vertical alignment.
+         */
+        VerticalAlignment verAlign = VerticalAlignment::Top;
+
+        /**
+         * \brief List of child elements.
+         */
+        std::vector<LayoutElementPtr> children;
+    };
+}  // namespace floah
@@ -0,0 +1,41 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <optional>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-common/length.h"
+
+namespace floah
+{
+    /**
+     * \brief Flex parameters of an element. Used by HorizontalFlow and VerticalFlow to distribute the space that is
+     * left after placing all fixed-size children over their flexible children. Sizes are along the main axis of the
+     * flow (width for HorizontalFlow, height for VerticalFlow). Relative lengths are relative to the inner size of the
+     * flow, like Size.
+     */
+    struct Flex
+    {
+        /**
+         * \brief Weight. If larger than 0, the size along the main axis is replaced by a share of the remaining space
+         * proportional to the weight.
+         */
+        float weight = 0.0f;
+
+        /**
+         * \brief Minimum size along the main axis.
+         */
+        Length min;
+
+        /**
+         * \brief Optional maximum size along the main axis.
+         */
+        std::optional<Length> max;
+    };
+}  // namespace floah
@@ -0,0 +1,217 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-layout/block.h"
+#include "floah-layout/generate_options.h"
+#include "floah-layout/line_breaks.h"
+
+namespace floah
+{
+    template<typename Tree>
+    class Generator;
+
+    /**
+     * \brief Cache of generated subtrees. Subtrees that have the same structure and layout parameters (see
+     * LayoutElement::getLayoutHash) and are given bounds of the same size produce the same blocks up to a translation.
+     * When such a subtree occurs more than once, its blocks are stored relative to the origin of the subtree root and
+     * stamped out for all other occurrences, in this and later generates, with only identifiers substituted.
+     *
+     * The cache also keeps the line breaks of every WrapFlow between generates, keyed by element identifier, so that a
+     * change only breaks lines again from the first affected line.
+     *
+     * The number of cached subtrees is bounded by a capacity, and so is the number of elements whose line breaks are
+     * kept. When a new subtree or element is added to a full cache, the least recently used quarter of the subtrees or
+     * elements is evicted.
+     *
+     * Pass a cache through GenerateOptions::cache. A cache is not thread-safe: do not use it in concurrent generates.
+     */
+    class GenerateCache
+    {
+    public:
+        ////////////////////////////////////////////////////////////////
+        // Constructors.
+        ////////////////////////////////////////////////////////////////
+
+        GenerateCache();
+
+        /**
+         * \brief Construct a cache.
+         * \param capacity Maximum number of cached subtrees. A capacity of 0 disables caching.
+         */
+        explicit GenerateCache(size_t capacity);
+
+        GenerateCache(const GenerateCache&);
+
+        GenerateCache(GenerateCache&&) noexcept;
+
+        ~GenerateCache() noexcept;
+
+        GenerateCache& operator=(const GenerateCache&);
+
+        GenerateCache& operator=(GenerateCache&&) noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Getters.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Get the number of cached subtrees.
+         * \return Count.
+         */
+        [[nodiscard]] size_t size() const noexcept;
+
+        /**
+         * \brief Get the maximum number of cached subtrees.
+         * \return Capacity.
+         */
+        [[nodiscard]] size_t getCapacity() const noexcept;
+
+        /**
+         * \brief Get the number of subtrees that were stamped out from the cache.
+         * \return Count.
+         */
+        [[nodiscard]] size_t getHitCount() const noexcept;
+
+        /**
+         * \brief Get the number of subtrees that were generated and added to the cache.
+         * \return Count.
+         */
+        [[nodiscard]] size_t getMissCount() const noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Modifiers.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Remove all cached subtrees and line breaks and reset the counters.
+         */
+        void clear() noexcept;
+
+        /**
+         * \brief Set the maximum number of cached subtrees and of elements whose line breaks are kept. Evicts the least
+         * recently used subtrees and line breaks if the cache holds more.
+         * \param value Capacity. A capacity of 0 disables caching.
+         */
+        void setCapacity(size_t value);
+
+        /**
+         * \brief Default maximum number of cached subtrees.
+         */
+        static constexpr size_t defaultCapacity = 1024;
+
+    private:
+        template<typename Tree>
+        friend class Generator;
+
+        friend class LayoutScratch;
+
+        struct Key
+        {
+            uint64_t hash = 0;
+
+            int32_t width = 0;
+
+            int32_t height = 0;
+
+            BlockOrder order = BlockOrder::Siblings;
+
+            [[nodiscard]] bool operator==(const Key&) const noexcept = default;
+        };
+
+        struct KeyHash
+        {
+            [[nodiscard]] size_t operator()(const Key& key) const noexcept;
+        };
+
+        struct Entry
+        {
+            /**
+             * \brief childBounds of subtree root, relative to its origin.
+             */
+            BBox childBounds;
+
+            /**
+             * \brief Number of children of subtree root.
+             */
+            size_t childCount = 0;
+
+            /**
+             * \brief Blocks of all descendants in index order. Bounds are relative to the origin of the subtree root,
+             * indices are relative to the first descendant and depth is relative to the subtree root. Direct children
+             * have Block::noParent as parent. Identifiers are not stored.
+             */
+            std::vector<Block> blocks;
+
+            /**
+             * \brief Subtree hash of the element of each block, checked on lookup to detect key collisions.
+             */
+            std::vector<uint64_t> hashes;
+
+            /**
+             * \brief Value of the use clock when the subtree was last recorded or stamped out.
+             */
+            uint64_t lastUse = 0;
+        };
+
+        struct LineBreakEntry
+        {
+            LineBreaks breaks;
+
+            /**
+             * \brief Value of the use clock when the line breaks were last used.
+             */
+            uint64_t lastUse = 0;
+        };
+
+        /**
+         * \brief Get the line breaks of an element. Adds empty line breaks if there are none, evicting if the cache
+         * is full.
+         * \param id Identifier of the element.
+         * \return Line breaks, or nullptr if the capacity is 0.
+         */
+        [[nodiscard]] LineBreaks* getLineBreaks(const uuids::uuid& id);
+
+        /**
+         * \brief Add or replace a subtree, evicting if the cache is full.
+         * \param key Key.
+         * \param entry Entry.
+         */
+        void insert(const Key& key, Entry entry);
+
+        /**
+         * \brief Evict the least recently used subtrees and line breaks.
+         * \param keep Number of subtrees and of line breaks to keep.
+         */
+        void evict(size_t keep);
+
+        ////////////////////////////////////////////////////////////////
+        // Member variables.
+        ////////////////////////////////////////////////////////////////
+
+        std::unordered_map<Key, Entry, KeyHash> entries;
+
+        std::unordered_map<uuids::uuid, LineBreakEntry> lineBreaks;
+
+        size_t hits = 0;
+
+        size_t misses = 0;
+
+        size_t capacity = defaultCapacity;
+
+        /**
+         * \brief Incremented on every use of a subtree or line breaks.
+         */
+        uint64_t clock = 0;
+    };
+}  // namespace floah
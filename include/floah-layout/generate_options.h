@@ -0,0 +1,126 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-common/bbox.h"
+
+namespace floah
+{
+    /**
+     * \brief How elements that are culled are output.
+     */
+    enum class CullMode : uint8_t
+    {
+        /**
+         * \brief Output a single block with BlockFlags::Culled and no children.
+         */
+        Marker,
+
+        /**
+         * \brief Output nothing. The element is not counted as a child of its parent.
+         */
+        Skip
+    };
+
+    /**
+     * \brief Order of blocks in the output.
+     */
+    enum class BlockOrder : uint8_t
+    {
+        /**
+         * \brief The direct children of an element are contiguous. They are followed by the descendants of the first
+         * child, then those of the second child, etc.
+         */
+        Siblings,
+
+        /**
+         * \brief Pre-order depth-first. Each element is directly followed by its whole subtree, so every subtree is a
+         * single contiguous range.
+         */
+        DepthFirst
+    };
+
+    /**
+     * \brief Coordinate space of the bounds in the output.
+     */
+    enum class CoordinateMode : uint8_t
+    {
+        /**
+         * \brief All bounds are absolute.
+         */
+        Absolute,
+
+        /**
+         * \brief The bounds and childBounds of a block are relative to the top-left corner of the bounds of its parent
+         * block. The root block is absolute. Moving a subtree then only changes the block of its root. Use
+         * resolveBounds or resolveAbsolute to get absolute bounds.
+         */
+        ParentRelative
+    };
+
+    class GenerateCache;
+
+    struct GenerateOptions
+    {
+        /**
+         * \brief Absolute clip rectangles. If not empty, elements whose bounds lie completely outside of all rectangles
+         * are culled and their children are not generated.
+         */
+        std::vector<BBox> clip;
+
+        /**
+         * \brief How culled elements are output.
+         */
+        CullMode cullMode = CullMode::Marker;
+
+        /**
+         * \brief Order of blocks.
+         */
+        BlockOrder order = BlockOrder::Siblings;
+
+        /**
+         * \brief Coordinate space of bounds.
+         */
+        CoordinateMode coordinates = CoordinateMode::Absolute;
+
+        /**
+         * \brief Level of detail threshold. If larger than 0, the children of elements whose bounds are narrower and
+         * lower than this are not generated, and the element is output with BlockFlags::Collapsed.
+         */
+        int32_t minExtent = 0;
+
+        /**
+         * \brief Optional cache used to stamp out structurally identical subtrees instead of generating them. Not used
+         * when there are clip rectangles, since culling depends on absolute positions, nor with a minExtent.
+         */
+        GenerateCache* cache = nullptr;
+    };
+
+    /**
+     * \brief Limits on the work done by a single step of an incremental generate (see IncrementalGenerator). A step
+     * ends once either limit is reached. Zero means unlimited.
+     */
+    struct GenerateBudget
+    {
+        /**
+         * \brief Number of blocks to write. A step can write more if a cached subtree is stamped out at once.
+         */
+        size_t blocks = 0;
+
+        /**
+         * \brief Wall clock time. Only checked every few elements, so a step can take slightly longer.
+         */
+        std::chrono::nanoseconds time{0};
+    };
+}  // namespace floah
@@ -0,0 +1,94 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <cstdint>
+
+namespace floah
+{
+    /**
+     * \brief Reason a layout cannot be generated.
+     */
+    enum class GenerateError : uint8_t
+    {
+        None,
+
+        /**
+         * \brief Layout size is relative.
+         */
+        RelativeSize,
+
+        /**
+         * \brief Layout offset is relative.
+         */
+        RelativeOffset,
+
+        /**
+         * \brief Memory for the blocks or for intermediate results could not be allocated.
+         */
+        OutOfMemory
+    };
+
+    /**
+     * \brief Result of a generate that does not throw (see Layout::tryGenerate). Either success or an error, like a
+     * std::expected without a value: the blocks are written to the output passed to the generate, so that its storage
+     * can be reused.
+     */
+    class GenerateStatus
+    {
+    public:
+        ////////////////////////////////////////////////////////////////
+        // Constructors.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Construct a successful status.
+         */
+        constexpr GenerateStatus() noexcept = default;
+
+        /**
+         * \brief Construct a status from an error.
+         * \param e Error.
+         */
+        constexpr GenerateStatus(const GenerateError e) noexcept : error(e) {}
+
+        ////////////////////////////////////////////////////////////////
+        // Getters.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Get whether the generate succeeded.
+         * \return True on success.
+         */
+        [[nodiscard]] constexpr bool hasValue() const noexcept { return error == GenerateError::None; }
+
+        [[nodiscard]] constexpr explicit operator bool() const noexcept { return hasValue(); }
+
+        [[nodiscard]] constexpr GenerateError getError() const noexcept { return error; }
+
+        /**
+         * \brief Get a description of the error, in the same words as the exception thrown by Layout::generate.
+         * \return Message, or an empty string on success.
+         */
+        [[nodiscard]] constexpr const char* getMessage() const noexcept
+        {
+            switch (error)
+            {
+            case GenerateError::None: return "";
+            case GenerateError::RelativeSize: return "Cannot generate. Layout must have an absolute size.";
+            case GenerateError::RelativeOffset: return "Cannot generate. Layout must have an absolute offset.";
+            case GenerateError::OutOfMemory: return "Cannot generate. Out of memory.";
+            }
+            return "";
+        }
+
+    private:
+        ////////////////////////////////////////////////////////////////
+        // Member variables.
+        ////////////////////////////////////////////////////////////////
+
+        GenerateError error = GenerateError::None;
+    };
+}  // namespace floah
@@ -0,0 +1,286 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+////////////////////////////////////////////////////////////////
+// External includes.
+////////////////////////////////////////////////////////////////
+
+#include "uuid.h"
+
+namespace floah
+{
+    /**
+     * \brief Open-addressing hash table from identifier to value. Uses linear probing over a power-of-two number of
+     * slots, so lookups touch a single contiguous region of memory and never allocate.
+     * \tparam T Value type.
+     */
+    template<typename T>
+    class IdIndex
+    {
+    public:
+        ////////////////////////////////////////////////////////////////
+        // Constructors.
+        ////////////////////////////////////////////////////////////////
+
+        IdIndex() = default;
+
+        IdIndex(const IdIndex&) = default;
+
+        IdIndex(IdIndex&& other) noexcept :
+            slots(std::move(other.slots)),
+            count(std::exchange(other.count, 0)),
+            deleted(std::exchange(other.deleted, 0))
+        {
+            other.slots.clear();
+        }
+
+        ~IdIndex() noexcept = default;
+
+        IdIndex& operator=(const IdIndex&) = default;
+
+        IdIndex& operator=(IdIndex&& other) noexcept
+        {
+            if (this == &other) return *this;
+            slots   = std::move(other.slots);
+            count   = std::exchange(other.count, 0);
+            deleted = std::exchange(other.deleted, 0);
+            other.slots.clear();
+            return *this;
+        }
+
+        ////////////////////////////////////////////////////////////////
+        // Getters.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Get the number of stored identifiers.
+         * \return Count.
+         */
+        [[nodiscard]] size_t size() const noexcept { return count; }
+
+        /**
+         * \brief Returns whether there are no stored identifiers.
+         * \return True if empty.
+         */
+        [[nodiscard]] bool empty() const noexcept { return count == 0; }
+
+        /**
+         * \brief Get the number of bytes allocated for slots.
+         * \return Bytes.
+         */
+        [[nodiscard]] size_t getAllocatedBytes() const noexcept { return slots.capacity() * sizeof(Slot); }
+
+        /**
+         * \brief Get the number of allocated bytes that shrinkToFit would release.
+         * \return Bytes.
+         */
+        [[nodiscard]] size_t getUnusedBytes() const noexcept
+        {
+            const auto needed = count == 0 ? 0 : getCapacity(count);
+            return slots.capacity() > needed ? (slots.capacity() - needed) * sizeof(Slot) : 0;
+        }
+
+        /**
+         * \brief Find the value stored for an identifier.
+         * \param id Identifier.
+         * \return Pointer to value or nullptr.
+         */
+        [[nodiscard]] T* find(const uuids::uuid& id) noexcept
+        {
+            const auto i = findSlot(id);
+            return i == npos ? nullptr : &slots[i].value;
+        }
+
+        /**
+         * \brief Find the value stored for an identifier.
+         * \param id Identifier.
+         * \return Pointer to value or nullptr.
+         */
+        [[nodiscard]] const T* find(const uuids::uuid& id) const noexcept
+        {
+            const auto i = findSlot(id);
+            return i == npos ? nullptr : &slots[i].value;
+        }
+
+        ////////////////////////////////////////////////////////////////
+        // Modifiers.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Make sure at least n identifiers can be stored without growing.
+         * \param n Number of identifiers.
+         */
+        void reserve(const size_t n)
+        {
+            const auto capacity = getCapacity(n);
+            if (capacity > slots.size()) rehash(capacity);
+        }
+
+        /**
+         * \brief Release the slots that are not needed for the stored identifiers. Purges tombstones.
+         */
+        void shrinkToFit()
+        {
+            if (count == 0)
+            {
+                slots.clear();
+                slots.shrink_to_fit();
+                deleted = 0;
+                return;
+            }
+
+            const auto capacity = getCapacity(count);
+            if (capacity < slots.capacity() || deleted > 0) rehash(capacity);
+        }
+
+        /**
+         * \brief Remove all identifiers. Keeps allocated slots.
+         */
+        void clear() noexcept
+        {
+            for (auto& slot : slots) slot.state = State::Empty;
+            count   = 0;
+            deleted = 0;
+        }
+
+        /**
+         * \brief Store a value for an identifier. Does nothing if the identifier is already present.
+         * \param id Identifier.
+         * \param value Value.
+         * \return True if inserted, false if identifier was already present.
+         */
+        bool insert(const uuids::uuid& id, T value)
+        {
+            // Keep load factor (including tombstones) at or below 0.5. Grow only if the live identifiers need it,
+            // otherwise rehashing at the same capacity just purges the tombstones.
+            if ((count + deleted + 1) * 2 > slots.size())
+            {
+                auto capacity = slots.empty() ? minCapacity : slots.size();
+                while ((count + 1) * 2 > capacity) capacity *= 2;
+                rehash(capacity);
+            }
+
+            const auto mask      = slots.size() - 1;
+            size_t     tombstone = npos;
+            for (size_t i = hash(id) & mask;; i = (i + 1) & mask)
+            {
+                auto& slot = slots[i];
+                if (slot.state == State::Empty)
+                {
+                    if (tombstone != npos)
+                    {
+                        deleted--;
+                        i = tombstone;
+                    }
+                    slots[i] = Slot{.id = id, .value = std::move(value), .state = State::Occupied};
+                    count++;
+                    return true;
+                }
+                if (slot.state == State::Deleted)
+                {
+                    if (tombstone == npos) tombstone = i;
+                }
+                else if (slot.id == id)
+                    return false;
+            }
+        }
+
+        /**
+         * \brief Remove an identifier.
+         * \param id Identifier.
+         * \return True if removed, false if identifier was not present.
+         */
+        bool erase(const uuids::uuid& id) noexcept
+        {
+            const auto i = findSlot(id);
+            if (i == npos) return false;
+            slots[i].state = State::Deleted;
+            count--;
+            deleted++;
+            return true;
+        }
+
+    private:
+        enum class State : uint8_t
+        {
+            Empty,
+            Occupied,
+            Deleted
+        };
+
+        struct Slot
+        {
+            uuids::uuid id;
+            T           value{};
+            State       state = State::Empty;
+        };
+
+        static constexpr size_t npos        = static_cast<size_t>(-1);
+        static constexpr size_t minCapacity = 16;
+
+        /**
+         * \brief Get the smallest number of slots that can store n identifiers without growing.
+         */
+        [[nodiscard]] static size_t getCapacity(const size_t n) noexcept
+        {
+            size_t capacity = minCapacity;
+            while (capacity / 2 < n) capacity *= 2;
+            return capacity;
+        }
+
+        [[nodiscard]] static size_t hash(const uuids::uuid& id) noexcept { return std::hash<uuids::uuid>{}(id); }
+
+        [[nodiscard]] size_t findSlot(const uuids::uuid& id) const noexcept
+        {
+            if (count == 0) return npos;
+
+            const auto mask = slots.size() - 1;
+            for (size_t i = hash(id) & mask;; i = (i + 1) & mask)
+            {
+                const auto& slot = slots[i];
+                if (slot.state == State::Empty) return npos;
+                if (slot.state == State::Occupied && slot.id == id) return i;
+            }
+        }
+
+        void rehash(const size_t capacity)
+        {
+            auto old = std::move(slots);
+            slots.clear();
+            slots.resize(capacity);
+            count   = 0;
+            deleted = 0;
+            for (auto& slot : old)
+            {
+                if (slot.state == State::Occupied) insert(slot.id, std::move(slot.value));
+            }
+        }
+
+        ////////////////////////////////////////////////////////////////
+        // Member variables.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Slots. Size is always zero or a power of two.
+         */
+        std::vector<Slot> slots;
+
+        /**
+         * \brief Number of occupied slots.
+         */
+        size_t count = 0;
+
+        /**
+         * \brief Number of deleted slots (tombstones).
+         */
+        size_t deleted = 0;
+    };
+}  // namespace floah
@@ -0,0 +1,129 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <atomic>
+#include <memory>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-layout/background_generator.h"
+#include "floah-layout/block_sink.h"
+#include "floah-layout/generate_options.h"
+#include "floah-layout/layout_snapshot.h"
+
+namespace floah
+{
+    template<typename Tree>
+    class Generator;
+    class SnapshotTree;
+
+    /**
+     * \brief Generates a layout snapshot in steps, e.g. a few blocks per frame on the UI thread, so that generating a
+     * large layout never takes longer than a given budget. Generation can be suspended after any element and resumed
+     * later. Results are double-buffered like those of a BackgroundGenerator: the previous complete result stays
+     * available until the current generation is done.
+     */
+    class IncrementalGenerator
+    {
+    public:
+        ////////////////////////////////////////////////////////////////
+        // Constructors.
+        ////////////////////////////////////////////////////////////////
+
+        IncrementalGenerator();
+
+        IncrementalGenerator(const IncrementalGenerator&) = delete;
+
+        IncrementalGenerator(IncrementalGenerator&&) noexcept = delete;
+
+        ~IncrementalGenerator() noexcept;
+
+        IncrementalGenerator& operator=(const IncrementalGenerator&) = delete;
+
+        IncrementalGenerator& operator=(IncrementalGenerator&&) noexcept = delete;
+
+        ////////////////////////////////////////////////////////////////
+        // Getters.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Get the most recently completed result.
+         * \return Result, or nullptr if no generation was completed yet.
+         */
+        [[nodiscard]] std::shared_ptr<const GeneratedBlocks> getResult() const noexcept;
+
+        /**
+         * \brief Get whether a generation was started and is not yet done.
+         * \return True if running.
+         */
+        [[nodiscard]] bool isRunning() const noexcept;
+
+        /**
+         * \brief Get the number of blocks written by the current generation so far.
+         * \return Count.
+         */
+        [[nodiscard]] size_t getWrittenCount() const noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Generate.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Start generating a snapshot. Cancels the current generation, if any. Does not generate any blocks
+         * yet, call resume for that.
+         * \param snapshot Snapshot.
+         * \param options Options. Copied. A cache referenced by the options must stay alive until done.
+         */
+        void start(std::shared_ptr<const LayoutSnapshot> snapshot, const GenerateOptions& options = {});
+
+        /**
+         * \brief Continue the current generation until done or until the budget is used up. If an exception is thrown,
+         * the generation is cancelled.
+         * \param budget Budget. The default budget is unlimited.
+         * \return True if done (or nothing was running), in which case the result was published.
+         */
+        bool resume(const GenerateBudget& budget = {});
+
+        /**
+         * \brief Cancel the current generation. Keeps the last completed result.
+         */
+        void cancel() noexcept;
+
+    private:
+        ////////////////////////////////////////////////////////////////
+        // Member variables.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Options of the current generation. Referenced by the generator.
+         */
+        GenerateOptions options;
+
+        /**
+         * \brief Generator of the current generation. Null if there is none, or if its layout has no root element.
+         */
+        std::unique_ptr<Generator<SnapshotTree>> generator;
+
+        std::unique_ptr<VectorBlockSink> sink;
+
+        /**
+         * \brief Buffer of the current generation.
+         */
+        std::shared_ptr<GeneratedBlocks> back;
+
+        /**
+         * \brief Unreferenced buffer that is reused as the next back buffer.
+         */
+        std::shared_ptr<GeneratedBlocks> spare;
+
+        /**
+         * \brief Last completed buffer.
+         */
+        std::atomic<std::shared_ptr<const GeneratedBlocks>> front;
+    };
+}  // namespace floah
@@ -4,8 +4,13 @@
 // Standard includes.
 ////////////////////////////////////////////////////////////////
 
+#include <atomic>
 #include <cassert>
 #include <concepts>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <vector>
 
 ////////////////////////////////////////////////////////////////
@@ -13,36 +18,55 @@
 ////////////////////////////////////////////////////////////////
 
 #include "floah-layout/block.h"
+#include "floah-layout/block_sink.h"
+#include "floah-layout/generate_options.h"
+#include "floah-layout/generate_status.h"
+#include "floah-layout/id_index.h"
 #include "floah-layout/layout_element.h"
+#include "floah-layout/memory_usage.h"
 #include "floah-common/size.h"
 
 namespace floah
 {
+    /**
+     * \brief Table from element identifier to the index of the first block generated for that element.
+     */
+    using BlockIndex = IdIndex<size_t>;
+
+    class LayoutSnapshot;
+
     class Layout
     {
+        friend class LayoutElement;
+        friend class LayoutSnapshot;
+        friend class LayoutTransaction;
+
     public:
         ////////////////////////////////////////////////////////////////
         // Constructors.
         ////////////////////////////////////////////////////////////////
-        // TODO: Implement some kind of clone.
         Layout();
 
         Layout(const Layout&) = delete;
 
-        Layout(Layout&&) noexcept = delete;
+        /**
+         * \brief Move constructor. Points the root element to the new layout.
+         */
+        Layout(Layout&&) noexcept;
 
         ~Layout() noexcept;
 
         Layout& operator=(const Layout&) = delete;
 
-        Layout& operator=(Layout&&) noexcept = delete;
+        Layout& operator=(Layout&&) noexcept;
 
         ////////////////////////////////////////////////////////////////
         // Getters.
         ////////////////////////////////////////////////////////////////
 
         /**
-         * \brief Get the absolute size of the layout.
+         * \brief Get the absolute size of the layout. Makes the next generate validate the layout again, so do not hold
+         * on to the reference past that generate. Prefer setSize.
          * \return Absolute size.
          */
         [[nodiscard]] Size& getSize() noexcept;
@@ -54,7 +78,8 @@ namespace floah
         [[nodiscard]] const Size& getSize() const noexcept;
 
         /**
-         * \brief Get the absolute offset of the layout.
+         * \brief Get the absolute offset of the layout. Makes the next generate validate the layout again, so do not
+         * hold on to the reference past that generate. Prefer setOffset.
          * \return Absolute offset.
          */
         [[nodiscard]] Size& getOffset() noexcept;
@@ -71,17 +96,62 @@ namespace floah
          */
         [[nodiscard]] LayoutElement* getRootElement() const noexcept;
 
+        /**
+         * \brief Get the structure version. Incremented every time elements are added to or removed from this layout.
+         * \return Version.
+         */
+        [[nodiscard]] uint64_t getStructureVersion() const noexcept;
+
+        /**
+         * \brief Find an element in this layout by its identifier. Runs in constant time, except for the first lookup
+         * after the structure changed, which rebuilds the element index in time linear in the number of elements.
+         * Concurrent lookups are safe as long as the structure is not changed at the same time.
+         * \param id Identifier.
+         * \return LayoutElement or nullptr.
+         */
+        [[nodiscard]] LayoutElement* findElement(const uuids::uuid& id) const noexcept;
+
+        /**
+         * \brief Get the roots of the subtrees whose structure changed in the last committed transaction (see
+         * LayoutTransaction). No root lies inside the subtree of another root. Elements that were removed during the
+         * transaction are not included.
+         * \return Element identifiers.
+         */
+        [[nodiscard]] std::span<const uuids::uuid> getInvalidatedElements() const noexcept;
+
+        /**
+         * \brief Check whether this layout can be generated. Only the layout itself needs checking: the parameters of
+         * elements are already validated when they are set. The result is cached until the size or offset changes.
+         * \return First error found, or GenerateError::None.
+         */
+        [[nodiscard]] GenerateError validate() const noexcept;
+
         ////////////////////////////////////////////////////////////////
         // Setters.
         ////////////////////////////////////////////////////////////////
 
+        /**
+         * \brief Set the absolute size of the layout.
+         * \param s Absolute size.
+         */
+        void setSize(const Size& s) noexcept;
+
+        /**
+         * \brief Set the absolute offset of the layout.
+         * \param o Absolute offset.
+         */
+        void setOffset(const Size& o) noexcept;
+
         template<std::derived_from<LayoutElement> T>
         T& setRoot(std::unique_ptr<T> elem)
         {
             assert(elem);
+            saveRoot();
             auto& elemRef = *elem;
             root          = std::move(elem);
             root->setLayout(this);
+            invalidateElementIndex();
+            invalidateStructure();
             return elemRef;
         }
 
@@ -91,7 +161,227 @@ namespace floah
 
         [[nodiscard]] std::vector<Block> generate() const;
 
+        /**
+         * \brief Generate all blocks.
+         * \param options Options.
+         * \return List of blocks.
+         */
+        [[nodiscard]] std::vector<Block> generate(const GenerateOptions& options) const;
+
+        /**
+         * \brief Generate all blocks and fill a table from element identifier to block index.
+         * \param index Block index. Cleared before filling.
+         * \return List of blocks.
+         */
+        [[nodiscard]] std::vector<Block> generate(BlockIndex& index) const;
+
+        /**
+         * \brief Generate all blocks into an existing list, reusing its storage, and fill a table from element
+         * identifier to block index.
+         * \param blocks List of blocks. Cleared before filling.
+         * \param index Block index. Cleared before filling.
+         * \param options Options.
+         */
+        void generate(std::vector<Block>& blocks, BlockIndex& index, const GenerateOptions& options = {}) const;
+
+        /**
+         * \brief Generate all blocks, passing each block to a sink as soon as it is complete.
+         * \param sink Sink.
+         * \param options Options.
+         */
+        void generate(BlockSink& sink, const GenerateOptions& options = {}) const;
+
+        /**
+         * \brief Generate all blocks into an existing list without throwing, e.g. for builds where exceptions must not
+         * reach the per-frame path. Failed allocations are reported as GenerateError::OutOfMemory. Exceptions of any
+         * other type thrown by custom elements terminate the program.
+         * \param blocks List of blocks. Cleared before filling. Untouched if validation fails, empty if an allocation
+         * fails.
+         * \param index Block index. Cleared before filling. Untouched if validation fails, empty if an allocation
+         * fails.
+         * \param options Options.
+         * \return Status.
+         */
+        [[nodiscard]] GenerateStatus tryGenerate(std::vector<Block>&    blocks,
+                                                 BlockIndex&            index,
+                                                 const GenerateOptions& options = {}) const noexcept;
+
+        /**
+         * \brief Generate all blocks into a sink, reporting errors instead of throwing them (see tryGenerate). Not
+         * noexcept: exceptions thrown by the sink itself, other than failed allocations, are passed on to the caller.
+         * \param sink Sink. Not called if validation fails. May have received part of the blocks if an allocation
+         * fails.
+         * \param options Options.
+         * \return Status.
+         */
+        [[nodiscard]] GenerateStatus tryGenerate(BlockSink& sink, const GenerateOptions& options = {}) const;
+
+        ////////////////////////////////////////////////////////////////
+        // Snapshots.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Create an immutable copy of the layout parameters of this layout that can be generated on another
+         * thread. Layout parameters are not tracked, so this captures a plain record of every element, which runs in
+         * linear time but does not copy any element of a built-in type. Records are shared with the previous snapshot
+         * where nothing changed, and if neither the structure nor any layout parameter changed, the previous snapshot
+         * itself is returned. Call only from the thread that modifies this layout.
+         * \return Snapshot.
+         */
+        [[nodiscard]] std::shared_ptr<const LayoutSnapshot> snapshot() const;
+
+        ////////////////////////////////////////////////////////////////
+        // Memory.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Get a report of the memory used by this layout and all its elements. Snapshots are not included.
+         * \return Report.
+         */
+        [[nodiscard]] MemoryUsage memoryUsage() const;
+
+        /**
+         * \brief Get a report of the memory used by this layout, all its elements and output generated from it.
+         * \param blocks Generated blocks.
+         * \param index Generated block index.
+         * \return Report.
+         */
+        [[nodiscard]] MemoryUsage memoryUsage(const std::vector<Block>& blocks, const BlockIndex& index) const;
+
+        /**
+         * \brief Release unused capacity of the storage owned by this layout and all its elements, such as the child
+         * lists of flows and grids and the element index. Does not change the structure.
+         */
+        void shrinkToFit();
+
     private:
+        void invalidateStructure() noexcept;
+
+        void invalidateStructure(const LayoutElement& elem) noexcept;
+
+        /**
+         * \brief Mark the element index as out of date, so that the next lookup rebuilds it.
+         */
+        void invalidateElementIndex() noexcept;
+
+        /**
+         * \brief Rebuild the element index if it is out of date. Concurrent callers wait for a single rebuild.
+         * \return True if the index is up to date, false if rebuilding failed and lookups have to walk the tree.
+         */
+        [[nodiscard]] bool updateElementIndex() const noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Transactions.
+        ////////////////////////////////////////////////////////////////
+
+        void beginTransaction();
+
+        void endTransaction() noexcept;
+
+        /**
+         * \brief Start recording an undo log for a transaction.
+         * \return Start of the undo log of the enclosing transaction, to pass to endUndoLog.
+         */
+        [[nodiscard]] size_t beginUndoLog() noexcept;
+
+        /**
+         * \brief Stop recording the undo log of the innermost transaction. On commit, its entries are kept for the
+         * enclosing transactions, if any.
+         * \param previousStart Value returned by beginUndoLog.
+         * \param rollback If true, restore all subtrees saved since beginUndoLog, most recent first.
+         */
+        void endUndoLog(size_t previousStart, bool rollback) noexcept;
+
+        /**
+         * \brief Save a copy of the subtree of an element before its children change, if an undo log is recorded and
+         * the subtree is not already covered by a copy saved in the innermost transaction.
+         * \param elem Element.
+         */
+        void saveSubtree(const LayoutElement& elem);
+
+        /**
+         * \brief Save a copy of the whole tree before the root element is replaced, if an undo log is recorded.
+         */
+        void saveRoot();
+
+        /**
+         * \brief Restore the structure of a saved subtree. The element with the identifier of the copy takes over the
+         * children of the copy, after which every element of the copy is replaced by the element with the same
+         * identifier that is still part of the layout or of another copy. Elements that are no longer needed are moved
+         * into the copy, so that nothing is destroyed until the whole undo log of the transaction is restored.
+         * \param copy Copy. Holds the elements that are no longer needed afterwards.
+         * \param id Identifier of the element, or nil to replace the whole tree.
+         * \param indexed If true, elements are looked up in the element index, which has room for all copied
+         * elements. Otherwise, they are searched for in the tree.
+         */
+        void restoreSubtree(LayoutElementPtr& copy, const uuids::uuid& id, bool indexed) noexcept;
+
+        /**
+         * \brief Replace an element of a saved copy by the element with the same identifier, if there is one, and do
+         * the same for all its descendants (see restoreSubtree).
+         * \param slot Pointer through which the copied element is owned.
+         * \param owner Element that owns the slot, or nullptr.
+         * \param indexed If true, use the element index.
+         */
+        void restoreElement(LayoutElementPtr& slot, LayoutElement* owner, bool indexed) noexcept;
+
+        /**
+         * \brief Find the element that currently has an identifier while restoring the undo log.
+         * \param id Identifier.
+         * \param indexed If true, use the element index.
+         * \return Element or nullptr.
+         */
+        [[nodiscard]] LayoutElement* findRestoredElement(const uuids::uuid& id, bool indexed) noexcept;
+
+        /**
+         * \brief Find the pointer through which an element is owned, which is a child slot of its parent, the root, or
+         * a copy in the undo log.
+         * \param elem Element.
+         * \param owner Set to the parent of the element.
+         * \return Pointer, or nullptr if the parent does not expose its children (see LayoutElement::getChildSlots).
+         */
+        [[nodiscard]] LayoutElementPtr* findElementSlot(const LayoutElement& elem, LayoutElement*& owner) noexcept;
+
+        /**
+         * \brief Set the parent and layout of an element that was moved to another slot.
+         * \param slot Slot.
+         * \param owner Element that owns the slot, or nullptr.
+         */
+        void attachElement(LayoutElementPtr& slot, LayoutElement* owner) noexcept;
+
+        /**
+         * \brief Collect the roots of all changed subtrees of the finished transaction into invalidatedElements.
+         */
+        void mergeTransactionChanges();
+
+        /**
+         * \brief Check the size and offset of this layout.
+         * \return First error found, or GenerateError::None.
+         */
+        [[nodiscard]] GenerateError validateSize() const noexcept;
+
+        /**
+         * \brief Generate all blocks, mapping failed allocations to GenerateError::OutOfMemory. Requires a successful
+         * validate.
+         * \param sink Sink.
+         * \param options Options.
+         * \return Status.
+         */
+        [[nodiscard]] GenerateStatus tryGenerateValidated(BlockSink& sink, const GenerateOptions& options) const;
+
+        /**
+         * \brief Generate all blocks. Requires a successful validate.
+         * \param sink Sink.
+         * \param options Options.
+         */
+        void generateValidated(BlockSink& sink, const GenerateOptions& options) const;
+
+        /**
+         * \brief Calculate the absolute bounds of the root element. Requires a root element and a successful validate.
+         * \return Bounds.
+         */
+        [[nodiscard]] BBox calculateRootBounds() const noexcept;
+
         ////////////////////////////////////////////////////////////////
         // Member variables.
         ////////////////////////////////////////////////////////////////
@@ -100,6 +390,111 @@ namespace floah
 
         Size offset;
 
+        /**
+         * \brief Value of validation when the size or offset changed since the last validate.
+         */
+        static constexpr uint8_t unvalidated = 0xff;
+
+        /**
+         * \brief Cached result of validateSize as a GenerateError, or unvalidated. Atomic, because concurrent generates
+         * of the same layout may each fill it in.
+         */
+        mutable std::atomic<uint8_t> validation = unvalidated;
+
+        /**
+         * \brief Incremented on each structural change.
+         */
+        uint64_t structureVersion = 0;
+
+        /**
+         * \brief Index of all elements in this layout. Rebuilt on demand by lookups.
+         */
+        mutable IdIndex<LayoutElement*> elements;
+
+        /**
+         * \brief Whether elements were added or removed since the element index was last built.
+         */
+        mutable std::atomic<bool> elementIndexStale = false;
+
+        /**
+         * \brief Serializes rebuilds of the element index by concurrent lookups.
+         */
+        mutable std::mutex elementIndexMutex;
+
         LayoutElementPtr root;
+
+        /**
+         * \brief Most recent snapshot.
+         */
+        mutable std::shared_ptr<const LayoutSnapshot> lastSnapshot;
+
+        /**
+         * \brief Number of open transactions.
+         */
+        uint32_t transactionDepth = 0;
+
+        /**
+         * \brief Whether the structure changed in the open transaction.
+         */
+        bool transactionChanged = false;
+
+        /**
+         * \brief Whether the root was replaced in the open transaction.
+         */
+        bool transactionChangedRoot = false;
+
+        /**
+         * \brief Elements whose children changed in the open transaction. May contain duplicates.
+         */
+        std::vector<uuids::uuid> transactionChanges;
+
+        /**
+         * \brief Roots of the subtrees that changed in the last committed transaction.
+         */
+        std::vector<uuids::uuid> invalidatedElements;
+
+        /**
+         * \brief Copy of a subtree as it was before its structure changed in a transaction with undo log.
+         */
+        struct UndoEntry
+        {
+            /**
+             * \brief Identifier of the subtree root. Nil if the whole tree was saved because the root was replaced.
+             */
+            uuids::uuid id;
+
+            /**
+             * \brief Copy, including identifiers. Null if the whole tree was saved and there was no root. After the
+             * entry is restored, holds the elements that are no longer part of the layout.
+             */
+            LayoutElementPtr copy;
+        };
+
+        static constexpr size_t noUndoPosition = static_cast<size_t>(-1);
+
+        /**
+         * \brief Number of open transactions with undo log.
+         */
+        uint32_t undoDepth = 0;
+
+        /**
+         * \brief Saved subtrees, in the order in which they were saved.
+         */
+        std::vector<UndoEntry> undoLog;
+
+        /**
+         * \brief First entry of the undo log of the innermost transaction.
+         */
+        size_t undoStart = 0;
+
+        /**
+         * \brief Position of the most recent copy of each saved subtree in the undo log.
+         */
+        IdIndex<size_t> undoPositions;
+
+        /**
+         * \brief Position of the most recent copy of the whole tree in the undo log, or noUndoPosition.
+         */
+        size_t rootUndoPosition = noUndoPosition;
     };
 }  // namespace floah
\ No newline at end of file
@@ -4,7 +4,10 @@
 // Standard includes.
 ////////////////////////////////////////////////////////////////
 
+#include <cstdint>
 #include <memory>
+#include <span>
+#include <vector>
 
 ////////////////////////////////////////////////////////////////
 // External includes.
@@ -17,6 +20,9 @@
 ////////////////////////////////////////////////////////////////
 
 #include "floah-layout/block.h"
+#include "floah-layout/flex.h"
+#include "floah-layout/layout_scratch.h"
+#include "floah-layout/memory_usage.h"
 #include "floah-common/margin.h"
 #include "floah-common/size.h"
 
@@ -41,13 +47,21 @@ namespace floah
 
         LayoutElement(const LayoutElement&);
 
-        LayoutElement(LayoutElement&&) noexcept = delete;
+        /**
+         * \brief Move constructor. The new element takes over the identifier and child elements of the other element,
+         * but is not part of any layout or parent element. The other element is left without identifier and children.
+         */
+        LayoutElement(LayoutElement&&) noexcept;
 
         virtual ~LayoutElement() noexcept;
 
         LayoutElement& operator=(const LayoutElement&);
 
-        LayoutElement& operator=(LayoutElement&&) noexcept = delete;
+        /**
+         * \brief Move assignment. This element takes over the identifier and child elements of the other element, but
+         * keeps its own layout and parent element. The other element is left without identifier and children.
+         */
+        LayoutElement& operator=(LayoutElement&&) noexcept;
 
         /**
          * \brief Clone this element to a new layout and/or parent element.
@@ -67,6 +81,11 @@ namespace floah
 
         [[nodiscard]] const uuids::uuid& getId() const noexcept;
 
+        /**
+         * \brief Get the layout this element is part of. Resolved through the root element, so that moving a subtree
+         * between layouts never has to visit its descendants.
+         * \return Layout or nullptr.
+         */
         [[nodiscard]] Layout* getLayout() const noexcept;
 
         [[nodiscard]] LayoutElement* getParent() const noexcept;
@@ -83,31 +102,125 @@ namespace floah
 
         [[nodiscard]] const Margin& getOuterMargin() const noexcept;
 
+        /**
+         * \brief Get the flex parameters. Only used by parent elements that distribute space (see Flex).
+         * \return Flex parameters.
+         */
+        [[nodiscard]] Flex& getFlex() noexcept;
+
+        [[nodiscard]] const Flex& getFlex() const noexcept;
+
+        /**
+         * \brief Returns whether the other element has the same type and the same layout parameters (sizes, margins,
+         * alignments, etc.) as this element. Identifiers and child elements are not compared.
+         * \param other Other element.
+         * \return True if equal.
+         */
+        [[nodiscard]] virtual bool isLayoutEqual(const LayoutElement& other) const noexcept;
+
+        /**
+         * \brief Get a hash of the type and layout parameters of this element. Elements for which isLayoutEqual returns
+         * true have the same hash. Identifiers and child elements are not hashed. The hash does not change between
+         * runs of the same build.
+         * \return Hash.
+         */
+        [[nodiscard]] virtual uint64_t getLayoutHash() const noexcept;
+
+        /**
+         * \brief Get the list of direct child elements.
+         * \return List of child elements (can contain nullptrs, e.g. for empty grid cells).
+         */
+        [[nodiscard]] virtual std::span<const LayoutElementPtr> getChildren() const noexcept;
+
         ////////////////////////////////////////////////////////////////
         // Setters.
         ////////////////////////////////////////////////////////////////
 
     protected:
         /**
-         * \brief Recursively set layout.
+         * \brief Set layout. Only used for the root element, all other elements resolve their layout through the root.
          * \param l Layout.
          */
-        virtual void setLayout(Layout* l) noexcept;
-
-        void setLayout(Layout* l, LayoutElement& elem) noexcept;
+        void setLayout(Layout* l) noexcept;
 
         /**
-         * \brief Make other element a child of this element.
+         * \brief Make other element a child of this element. Call after adding the element to the list of children.
+         * Does not visit the subtree of the other element, the element index of the layout is only marked as out of
+         * date.
          * \param elem Other element.
          */
         void makeChild(LayoutElement& elem);
 
         /**
-         * \brief Remove this element as parent of other element.
+         * \brief Remove this element as parent of other element. Call before removing or destroying the element, so
+         * that the element index of the layout no longer refers to its subtree.
          * \param elem Other element.
          */
         void removeChild(LayoutElement& elem);
 
+        /**
+         * \brief Make other elements children of this element. Equivalent to calling makeChild for each element, but
+         * notifies the layout only once.
+         * \param elems Other elements (can contain nullptrs).
+         */
+        void makeChildren(std::span<const LayoutElementPtr> elems);
+
+        /**
+         * \brief Remove this element as parent of other elements. Equivalent to calling removeChild for each element,
+         * but notifies the layout only once.
+         * \param elems Other elements (can contain nullptrs).
+         */
+        void removeChildren(std::span<const LayoutElementPtr> elems);
+
+        /**
+         * \brief Notify the layout this element is part of that elements were added or removed.
+         */
+        void invalidateStructure() const noexcept;
+
+        /**
+         * \brief Notify the layout this element is part of that elements were added to or removed from this element,
+         * and mark its element index as out of date.
+         */
+        void invalidateMembership() const noexcept;
+
+        /**
+         * \brief Notify the layout this element is part of that the children of this element are about to change, so
+         * that an open LayoutTransaction with undo log can save a copy of this subtree. Call before adding, removing or
+         * moving child elements and before modifying anything else.
+         */
+        void prepareStructureChange() const;
+
+        /**
+         * \brief Point the parent of all direct child elements to this element and mark the element index of the layout
+         * as out of date. Used after moving child elements.
+         */
+        void reparentChildren() noexcept;
+
+        /**
+         * \brief Get the pointers through which this element owns its children, in the same order as getChildren. Used
+         * to move elements between parents when a LayoutTransaction is rolled back. Elements of types that do not
+         * override this are restored by copies of their subtree instead.
+         * \return List of pointers to child elements.
+         */
+        [[nodiscard]] virtual std::span<LayoutElementPtr> getChildSlots() noexcept;
+
+        /**
+         * \brief Exchange the child elements, and the parameters that describe their placement (e.g. grid rows and
+         * spans), with those of another element of the same type. Both elements keep their own layout parameters. Used
+         * to restore the structure of an element from a copy when a LayoutTransaction is rolled back.
+         * \param other Element of the same type.
+         * \return True if exchanged. False if the type does not support this and either element has children.
+         */
+        virtual bool swapChildren(LayoutElement& other) noexcept;
+
+    private:
+        /**
+         * \brief Deep copy the subtree of this element, including the identifiers of all elements.
+         * \param l Layout to put the copy in.
+         * \return Copy.
+         */
+        [[nodiscard]] LayoutElementPtr cloneTree(Layout* l) const;
+
     public:
         ////////////////////////////////////////////////////////////////
         // Generate.
@@ -120,11 +233,51 @@ namespace floah
         virtual void countBlocks(size_t& count) const noexcept;
 
         /**
-         * \brief Generate all blocks for this element and all its children.
-         * \param blocks List of blocks to append new blocks to.
+         * \brief Calculate the absolute bounds of all direct child elements. Recursion into the children is done by the
+         * Layout, so implementations only have to position their direct children.
+         * \param bounds Absolute bounds of this element.
+         * \param childBounds Output bounds, one per entry in getChildren(). Entries for nullptr children are left untouched.
+         * \param scratch Memory for intermediate results, valid until this method returns. Implementations must not
+         * modify this element, so that the same element can be generated on multiple threads.
+         */
+        virtual void layoutChildren(const BBox& bounds, std::span<BBox> childBounds, LayoutScratch& scratch) const;
+
+        /**
+         * \brief Generate all blocks for this element and all its children, appending the blocks of the children of
+         * each element after those of earlier elements. Kept for compatibility: Layout no longer calls this method.
+         * Declared final, so that existing overrides fail to compile instead of being ignored. Override layoutChildren
+         * instead.
+         * \param blocks List of blocks to append new blocks to. Must have capacity for all blocks (see countBlocks), so
+         * that block stays valid.
          * \param block Block for this element. Identifier and bounds are already filled in.
          */
-        virtual void generate(std::vector<Block>& blocks, Block& block) const;
+        [[deprecated("Use Layout::generate and override layoutChildren instead.")]] virtual void
+          generate(std::vector<Block>& blocks, Block& block) const final;
+
+        /**
+         * \brief Get the rectangle that descendants of this element are clipped to, e.g. the viewport of a scrollable
+         * element. Descendants outside of the nearest such rectangle are flagged with BlockFlags::Clipped.
+         * \param bounds Absolute bounds of this element.
+         * \param clip Output absolute clip rectangle.
+         * \return True if this element clips its descendants.
+         */
+        [[nodiscard]] virtual bool getContentClip(const BBox& bounds, BBox& clip) const noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Memory.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Add the memory used by this element, excluding child elements, to a report. Derived classes that own
+         * storage or add member variables should override this to report their own size.
+         * \param usage Report.
+         */
+        virtual void addMemoryUsage(MemoryUsage& usage) const;
+
+        /**
+         * \brief Release unused capacity of the storage owned by this element, excluding child elements.
+         */
+        virtual void shrinkToFit();
 
     protected:
         ////////////////////////////////////////////////////////////////
@@ -133,6 +286,9 @@ namespace floah
 
         uuids::uuid id;
 
+        /**
+         * \brief Layout. Only set on the root element.
+         */
         Layout* layout = nullptr;
 
         LayoutElement* parent = nullptr;
@@ -142,5 +298,7 @@ namespace floah
         Margin innerMargin;
 
         Margin outerMargin;
+
+        Flex flex;
     };
 }  // namespace floah
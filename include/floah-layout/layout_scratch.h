@@ -0,0 +1,136 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+////////////////////////////////////////////////////////////////
+// External includes.
+////////////////////////////////////////////////////////////////
+
+#include "uuid.h"
+
+namespace floah
+{
+    class GenerateCache;
+
+    struct LineBreaks;
+
+    /**
+     * \brief Scratch memory for LayoutElement::layoutChildren. Owned by the generator and reset before every call, so
+     * that elements can keep intermediate results without allocating on every generate and without storing them in
+     * themselves, which would make generating the same elements on multiple threads a data race.
+     *
+     * Memory is handed out from chunks that are never moved, so earlier allocations stay valid until the next reset.
+     * On reset, all chunks are merged into one, so that after the first few generates no allocations remain.
+     */
+    class LayoutScratch
+    {
+    public:
+        ////////////////////////////////////////////////////////////////
+        // Constructors.
+        ////////////////////////////////////////////////////////////////
+
+        LayoutScratch();
+
+        /**
+         * \brief Construct scratch memory that gives access to the state elements keep in a cache between generates.
+         * \param c Cache, or nullptr.
+         */
+        explicit LayoutScratch(GenerateCache* c);
+
+        LayoutScratch(const LayoutScratch&) = delete;
+
+        LayoutScratch(LayoutScratch&&) noexcept;
+
+        ~LayoutScratch() noexcept;
+
+        LayoutScratch& operator=(const LayoutScratch&) = delete;
+
+        LayoutScratch& operator=(LayoutScratch&&) noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Getters.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Get the number of bytes allocated for all chunks.
+         * \return Number of bytes.
+         */
+        [[nodiscard]] size_t getAllocatedBytes() const noexcept;
+
+        /**
+         * \brief Get the line breaks a WrapFlow keeps between generates. Unlike allocations, these are not released on
+         * reset, but stored in the GenerateCache of the generate.
+         * \param id Identifier of the element.
+         * \return Line breaks of the previous generate, empty the first time, or nullptr if there is no cache.
+         */
+        [[nodiscard]] LineBreaks* getLineBreaks(const uuids::uuid& id);
+
+        ////////////////////////////////////////////////////////////////
+        // Allocation.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Allocate a value-initialized array. Valid until the next reset.
+         * \tparam T Element type.
+         * \param count Number of elements.
+         * \return Array.
+         */
+        template<typename T>
+            requires(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T> &&
+                     alignof(T) <= alignof(std::max_align_t))
+        [[nodiscard]] std::span<T> allocate(const size_t count)
+        {
+            if (count == 0) return {};
+            auto* first = reinterpret_cast<T*>(allocateBytes(count, sizeof(T), alignof(T)));
+            std::uninitialized_value_construct_n(first, count);
+            return {first, count};
+        }
+
+        /**
+         * \brief Release all allocations, keeping the memory for reuse.
+         */
+        void reset();
+
+    private:
+        /**
+         * \brief Allocate uninitialized memory.
+         * \param count Number of elements.
+         * \param size Size of an element.
+         * \param alignment Alignment of an element.
+         * \return Memory.
+         */
+        [[nodiscard]] std::byte* allocateBytes(size_t count, size_t size, size_t alignment);
+
+        ////////////////////////////////////////////////////////////////
+        // Member variables.
+        ////////////////////////////////////////////////////////////////
+
+        struct Chunk
+        {
+            std::unique_ptr<std::byte[]> memory;
+
+            size_t size = 0;
+        };
+
+        std::vector<Chunk> chunks;
+
+        /**
+         * \brief Cache of the generate, or nullptr.
+         */
+        GenerateCache* cache = nullptr;
+
+        /**
+         * \brief Number of bytes used in the last chunk.
+         */
+        size_t used = 0;
+    };
+}  // namespace floah
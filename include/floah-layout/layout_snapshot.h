@@ -0,0 +1,210 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-layout/layout.h"
+
+namespace floah
+{
+    class SnapshotNode;
+    class SnapshotTree;
+
+    /**
+     * \brief Immutable copy of the layout parameters of a layout, created with Layout::snapshot. Instead of copying the
+     * elements, a snapshot holds a flat list with a plain record (a node) per element: identifier, size, margins, flex
+     * parameters, alignments and the position of its children. Nodes are stored in fixed-size chunks, and a new
+     * snapshot reuses every chunk of the previous snapshot that did not change. Elements of types other than the
+     * built-in ones are laid out through copies of those elements.
+     *
+     * Blocks generated from a snapshot have the identifiers of the elements the nodes were captured from, so they can
+     * be used in place of blocks generated from the original layout. A snapshot is never modified after creation, so
+     * it can be generated on any number of threads while the original layout is modified.
+     */
+    class LayoutSnapshot
+    {
+        friend class IncrementalGenerator;
+        friend class Layout;
+        friend class SnapshotTree;
+
+    public:
+        ////////////////////////////////////////////////////////////////
+        // Constructors.
+        ////////////////////////////////////////////////////////////////
+
+        LayoutSnapshot(const LayoutSnapshot&) = delete;
+
+        LayoutSnapshot(LayoutSnapshot&&) noexcept = delete;
+
+        ~LayoutSnapshot() noexcept;
+
+        LayoutSnapshot& operator=(const LayoutSnapshot&) = delete;
+
+        LayoutSnapshot& operator=(LayoutSnapshot&&) noexcept = delete;
+
+        ////////////////////////////////////////////////////////////////
+        // Getters.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Get the structure version of the original layout at the time this snapshot was created.
+         * \return Version.
+         */
+        [[nodiscard]] uint64_t getStructureVersion() const noexcept;
+
+        /**
+         * \brief Get the size of the original layout at the time this snapshot was created.
+         * \return Size.
+         */
+        [[nodiscard]] const Size& getSize() const noexcept;
+
+        /**
+         * \brief Get the offset of the original layout at the time this snapshot was created.
+         * \return Offset.
+         */
+        [[nodiscard]] const Size& getOffset() const noexcept;
+
+        /**
+         * \brief Get the number of elements in this snapshot, which is also the number of blocks it generates.
+         * \return Count.
+         */
+        [[nodiscard]] size_t getElementCount() const noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Generate.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Generate all blocks into an existing list, reusing its storage, and fill a table from element
+         * identifier to block index (see Layout::generate).
+         * \param blocks List of blocks. Cleared before filling.
+         * \param index Block index. Cleared before filling.
+         * \param options Options.
+         */
+        void generate(std::vector<Block>& blocks, BlockIndex& index, const GenerateOptions& options = {}) const;
+
+        /**
+         * \brief Generate all blocks, passing each block to a sink as soon as it is complete.
+         * \param sink Sink.
+         * \param options Options.
+         */
+        void generate(BlockSink& sink, const GenerateOptions& options = {}) const;
+
+        /**
+         * \brief Generate all blocks into an existing list without throwing (see Layout::tryGenerate).
+         * \param blocks List of blocks. Cleared before filling. Untouched if validation fails, empty if an allocation
+         * fails.
+         * \param index Block index. Cleared before filling. Untouched if validation fails, empty if an allocation
+         * fails.
+         * \param options Options.
+         * \return Status.
+         */
+        [[nodiscard]] GenerateStatus tryGenerate(std::vector<Block>&    blocks,
+                                                 BlockIndex&            index,
+                                                 const GenerateOptions& options = {}) const noexcept;
+
+        /**
+         * \brief Generate all blocks into a sink, reporting errors instead of throwing them (see Layout::tryGenerate).
+         * \param sink Sink. Not called if validation fails. May have received part of the blocks if an allocation
+         * fails.
+         * \param options Options.
+         * \return Status.
+         */
+        [[nodiscard]] GenerateStatus tryGenerate(BlockSink& sink, const GenerateOptions& options = {}) const;
+
+    private:
+        LayoutSnapshot();
+
+        /**
+         * \brief Capture the nodes of all elements of a layout in breadth-first order, so that the children of each
+         * element are stored next to each other. Chunks that are equal to those at the same position in the previous
+         * snapshot are shared with it.
+         * \param layout Layout.
+         * \param previous Previous snapshot of the layout, or nullptr.
+         * \return The previous snapshot if nothing changed, a new snapshot otherwise.
+         */
+        [[nodiscard]] static std::shared_ptr<const LayoutSnapshot>
+          capture(const Layout& layout, const std::shared_ptr<const LayoutSnapshot>& previous);
+
+        /**
+         * \brief Returns whether the size, offset, structure version and all chunks are the same as those of the other
+         * snapshot.
+         * \param other Other snapshot.
+         * \return True if equal.
+         */
+        [[nodiscard]] bool isEqual(const LayoutSnapshot& other) const noexcept;
+
+        /**
+         * \brief Get the root node. Requires a root element.
+         * \return Root node.
+         */
+        [[nodiscard]] const SnapshotNode& getRoot() const noexcept;
+
+        /**
+         * \brief Generate all blocks, mapping failed allocations to GenerateError::OutOfMemory. Requires a successful
+         * validation.
+         * \param sink Sink.
+         * \param options Options.
+         * \return Status.
+         */
+        [[nodiscard]] GenerateStatus tryGenerateValidated(BlockSink& sink, const GenerateOptions& options) const;
+
+        /**
+         * \brief Generate all blocks. Requires a successful validation.
+         * \param sink Sink.
+         * \param options Options.
+         */
+        void generateValidated(BlockSink& sink, const GenerateOptions& options) const;
+
+        /**
+         * \brief Calculate the absolute bounds of the root node. Requires a root element and a successful validation.
+         * \return Bounds.
+         */
+        [[nodiscard]] BBox calculateRootBounds() const noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Member variables.
+        ////////////////////////////////////////////////////////////////
+
+        Size size;
+
+        Size offset;
+
+        /**
+         * \brief Result of Layout::validate at the time this snapshot was created.
+         */
+        GenerateError validation = GenerateError::None;
+
+        uint64_t structureVersion = 0;
+
+        /**
+         * \brief Number of nodes, including those of empty positions.
+         */
+        size_t nodeCount = 0;
+
+        /**
+         * \brief Number of nodes of elements.
+         */
+        size_t elementCount = 0;
+
+        /**
+         * \brief Nodes in breadth-first order, snapshotChunkSize per chunk.
+         */
+        std::vector<std::shared_ptr<const std::vector<SnapshotNode>>> chunks;
+
+        /**
+         * \brief Copies of custom elements, referenced by their nodes. Each points into a copy of the subtree of the
+         * outermost custom element it is part of.
+         */
+        std::vector<std::shared_ptr<const LayoutElement>> customElements;
+    };
+}  // namespace floah
@@ -0,0 +1,117 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-layout/layout.h"
+#include "floah-common/size.h"
+
+namespace floah
+{
+    /**
+     * \brief Batches modifications of a layout. While a transaction is open, structural changes (adding, removing and
+     * moving elements) do not increment the structure version. It is incremented once when the outermost transaction
+     * is committed, and the changed subtrees are merged into a minimal list of subtree roots (see
+     * Layout::getInvalidatedElements).
+     *
+     * Transactions can be nested. Only the outermost transaction increments the structure version. An open transaction
+     * is committed when it is destroyed. The layout must not be moved while a transaction is open.
+     *
+     * Changes are applied to the layout immediately, not when the transaction is committed. With an undo log, the first
+     * structural change to a subtree saves a copy of that subtree, so the cost of the log is proportional to the size
+     * of the changed subtrees instead of the whole layout. Only changes made through the methods that add and remove
+     * elements and Layout::setRoot are recorded, not move assignment of elements. Layout parameters (sizes, margins,
+     * etc.) are modified through references without notifying the layout, so they are not recorded.
+     */
+    class LayoutTransaction
+    {
+    public:
+        ////////////////////////////////////////////////////////////////
+        // Constructors.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Open a transaction.
+         * \param l Layout.
+         * \param undoLog If true, record the size and offset of the layout and a copy of each subtree before its
+         * structure first changes, so that the transaction can be rolled back.
+         */
+        explicit LayoutTransaction(Layout& l, bool undoLog = false);
+
+        LayoutTransaction(const LayoutTransaction&) = delete;
+
+        LayoutTransaction(LayoutTransaction&&) noexcept = delete;
+
+        /**
+         * \brief Commit the transaction if it is still open.
+         */
+        ~LayoutTransaction() noexcept;
+
+        LayoutTransaction& operator=(const LayoutTransaction&) = delete;
+
+        LayoutTransaction& operator=(LayoutTransaction&&) noexcept = delete;
+
+        ////////////////////////////////////////////////////////////////
+        // Getters.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Get whether the transaction was neither committed nor rolled back yet.
+         * \return True if open.
+         */
+        [[nodiscard]] bool isOpen() const noexcept;
+
+        /**
+         * \brief Get whether the transaction can be rolled back.
+         * \return True if the transaction is open and has an undo log.
+         */
+        [[nodiscard]] bool hasUndoLog() const noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Modifiers.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Commit the transaction.
+         */
+        void commit();
+
+        /**
+         * \brief Restore the size, offset and structure of the layout to their state when the transaction was opened,
+         * and close the transaction. Elements that are still part of the layout are moved back to their former
+         * positions, so pointers and references to them stay valid, and they keep their current layout parameters.
+         * Elements that were removed or extracted in the transaction are put back as copies with the layout parameters
+         * they had when the structure around them first changed. Elements added in the transaction are destroyed. The
+         * children of elements of types that do not expose them (see LayoutElement::getChildSlots) are always put back
+         * as copies. Elements keep their identifiers, so a GenerateCache still matches the restored subtrees.
+         */
+        void rollback();
+
+    private:
+        ////////////////////////////////////////////////////////////////
+        // Member variables.
+        ////////////////////////////////////////////////////////////////
+
+        Layout& layout;
+
+        bool open = true;
+
+        bool undo = false;
+
+        /**
+         * \brief Start of the undo log of the enclosing transaction.
+         */
+        size_t previousUndoStart = 0;
+
+        /**
+         * \brief Size of the layout when the transaction was opened.
+         */
+        Size size;
+
+        /**
+         * \brief Offset of the layout when the transaction was opened.
+         */
+        Size offset;
+    };
+}  // namespace floah
@@ -0,0 +1,71 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace floah
+{
+    /**
+     * \brief Line breaks of a WrapFlow, kept in a GenerateCache between generates, so that only the lines starting at
+     * the first line affected by a change in width or child extents are broken again.
+     */
+    struct LineBreaks
+    {
+        /**
+         * \brief Absolute size and outer margins of a child element.
+         */
+        struct Extent
+        {
+            int32_t width  = 0;
+            int32_t height = 0;
+            int32_t left   = 0;
+            int32_t top    = 0;
+            int32_t right  = 0;
+            int32_t bottom = 0;
+
+            [[nodiscard]] int32_t outerWidth() const noexcept { return left + width + right; }
+
+            [[nodiscard]] int32_t outerHeight() const noexcept { return top + height + bottom; }
+
+            [[nodiscard]] bool operator==(const Extent&) const noexcept = default;
+        };
+
+        struct Line
+        {
+            /**
+             * \brief Index of first child element.
+             */
+            size_t first = 0;
+
+            /**
+             * \brief One past index of last child element.
+             */
+            size_t end = 0;
+
+            /**
+             * \brief Sum of outer widths of child elements.
+             */
+            int32_t width = 0;
+
+            /**
+             * \brief Largest outer height of child elements.
+             */
+            int32_t height = 0;
+        };
+
+        /**
+         * \brief Extents of all child elements of the last generate.
+         */
+        std::vector<Extent> extents;
+
+        /**
+         * \brief Lines of the last generate.
+         */
+        std::vector<Line> lines;
+    };
+}  // namespace floah
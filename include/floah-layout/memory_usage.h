@@ -0,0 +1,108 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <vector>
+
+namespace floah
+{
+    /**
+     * \brief Report of the memory used by a layout and, optionally, its generated output. All sizes are in bytes and
+     * include allocated but unused capacity. Allocator overhead is not included.
+     */
+    struct MemoryUsage
+    {
+        /**
+         * \brief Memory used by all elements of a single type.
+         */
+        struct ElementType
+        {
+            /**
+             * \brief Implementation-defined type name, as returned by typeid.
+             */
+            const char* name = nullptr;
+
+            /**
+             * \brief Number of elements.
+             */
+            size_t count = 0;
+
+            /**
+             * \brief Size of the element objects plus the storage they own (child lists, caches, etc.).
+             */
+            size_t bytes = 0;
+
+            /**
+             * \brief Unused capacity of the storage owned by the elements.
+             */
+            size_t wastedBytes = 0;
+        };
+
+        /**
+         * \brief Memory per element type, sorted by descending bytes.
+         */
+        std::vector<ElementType> elementTypes;
+
+        /**
+         * \brief Total number of elements.
+         */
+        size_t elementCount = 0;
+
+        /**
+         * \brief Total memory used by elements.
+         */
+        size_t elementBytes = 0;
+
+        /**
+         * \brief Unused capacity of the storage owned by elements and of the element index.
+         */
+        size_t wastedBytes = 0;
+
+        /**
+         * \brief Total number of grid slots.
+         */
+        size_t gridSlotCount = 0;
+
+        /**
+         * \brief Number of grid slots without an element, including slots covered by a spanning element.
+         */
+        size_t nullGridSlotCount = 0;
+
+        /**
+         * \brief Memory used by the layout object and its element index.
+         */
+        size_t layoutBytes = 0;
+
+        /**
+         * \brief Number of generated blocks.
+         */
+        size_t blockCount = 0;
+
+        /**
+         * \brief Memory used by generated blocks and the block index.
+         */
+        size_t blockBytes = 0;
+
+        /**
+         * \brief Unused capacity of the block list and block index.
+         */
+        size_t wastedBlockBytes = 0;
+
+        /**
+         * \brief Get the total memory used.
+         * \return Bytes.
+         */
+        [[nodiscard]] size_t total() const noexcept { return elementBytes + layoutBytes + blockBytes; }
+
+        /**
+         * \brief Add an element to the report. Called by LayoutElement::addMemoryUsage.
+         * \param type Type name, as returned by typeid.
+         * \param bytes Size of the element object plus the storage it owns.
+         * \param wasted Unused capacity of the storage owned by the element.
+         */
+        void addElement(const char* type, size_t bytes, size_t wasted);
+    };
+}  // namespace floah
@@ -0,0 +1,248 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-layout/block.h"
+
+namespace floah
+{
+    /**
+     * \brief Frame in a shared block ring, referencing the shared memory directly. Only valid while
+     * SharedBlockReader::validate returns true for it.
+     */
+    struct SharedBlockFrame
+    {
+        /**
+         * \brief Frame number. The first published frame is 1.
+         */
+        uint64_t number = 0;
+
+        /**
+         * \brief Frame this frame is a delta to, or 0 if this is a full frame.
+         */
+        uint64_t base = 0;
+
+        /**
+         * \brief Number of blocks in the full list of blocks of this frame.
+         */
+        size_t totalCount = 0;
+
+        /**
+         * \brief For delta frames, the index of each changed block. Empty for full frames.
+         */
+        std::span<const uint64_t> indices;
+
+        /**
+         * \brief For full frames all blocks, for delta frames the changed blocks.
+         */
+        std::span<const Block> blocks;
+
+        /**
+         * \brief Sequence number of the slot when the frame was acquired.
+         */
+        uint64_t sequence = 0;
+
+        /**
+         * \brief Index of the slot.
+         */
+        size_t slot = 0;
+    };
+
+    /**
+     * \brief Publishes generated blocks to a ring of frames in POSIX shared memory, for a renderer in another process.
+     * Each slot of the ring is guarded by a sequence lock, so publishing never waits for readers. A frame with the same
+     * number of blocks as the previous one is written as a delta that only holds the changed blocks, unless most blocks
+     * changed. A full frame is written at least every half ring, so that readers that fell behind can catch up.
+     *
+     * Blocks are copied as is, so readers must run on the same architecture and use the same version of this library.
+     */
+    class SharedBlockWriter
+    {
+    public:
+        ////////////////////////////////////////////////////////////////
+        // Constructors.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Create a shared memory object and map it. Fails if an object with the same name already exists, e.g.
+         * because another writer uses it or a crashed process did not unlink it (remove it with shm_unlink).
+         * \param name Name of the shared memory object, e.g. "/my-app-blocks".
+         * \param capacity Maximum number of blocks per frame.
+         * \param slotCount Number of frames in the ring. At least 2.
+         */
+        SharedBlockWriter(std::string name, size_t capacity, size_t slotCount = 8);
+
+        SharedBlockWriter(const SharedBlockWriter&) = delete;
+
+        SharedBlockWriter(SharedBlockWriter&&) noexcept = delete;
+
+        /**
+         * \brief Unmap and unlink the shared memory object. Readers that still map it keep their mapping.
+         */
+        ~SharedBlockWriter() noexcept;
+
+        SharedBlockWriter& operator=(const SharedBlockWriter&) = delete;
+
+        SharedBlockWriter& operator=(SharedBlockWriter&&) noexcept = delete;
+
+        ////////////////////////////////////////////////////////////////
+        // Getters.
+        ////////////////////////////////////////////////////////////////
+
+        [[nodiscard]] const std::string& getName() const noexcept;
+
+        [[nodiscard]] size_t getCapacity() const noexcept;
+
+        [[nodiscard]] size_t getSlotCount() const noexcept;
+
+        /**
+         * \brief Get the number of the last published frame.
+         * \return Frame number, or 0 if nothing was published yet.
+         */
+        [[nodiscard]] uint64_t getFrameNumber() const noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Modifiers.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Publish a list of blocks as the next frame.
+         * \param blocks Blocks. At most capacity.
+         * \return Frame number.
+         */
+        uint64_t publish(std::span<const Block> blocks);
+
+    private:
+        ////////////////////////////////////////////////////////////////
+        // Member variables.
+        ////////////////////////////////////////////////////////////////
+
+        std::string name;
+
+        size_t capacity = 0;
+
+        size_t slotCount = 0;
+
+        std::byte* memory = nullptr;
+
+        size_t bytes = 0;
+
+        uint64_t frameNumber = 0;
+
+        /**
+         * \brief Number of the last full frame.
+         */
+        uint64_t keyFrame = 0;
+
+        /**
+         * \brief Blocks of the last published frame, to find changed blocks.
+         */
+        std::vector<Block> previous;
+
+        /**
+         * \brief Indices of changed blocks.
+         */
+        std::vector<uint64_t> changed;
+    };
+
+    /**
+     * \brief Reads frames published by a SharedBlockWriter in another process. Reading never blocks the writer.
+     */
+    class SharedBlockReader
+    {
+    public:
+        ////////////////////////////////////////////////////////////////
+        // Constructors.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Open and map an existing shared memory object read-only.
+         * \param name Name of the shared memory object.
+         */
+        explicit SharedBlockReader(const std::string& name);
+
+        SharedBlockReader(const SharedBlockReader&) = delete;
+
+        SharedBlockReader(SharedBlockReader&&) noexcept = delete;
+
+        ~SharedBlockReader() noexcept;
+
+        SharedBlockReader& operator=(const SharedBlockReader&) = delete;
+
+        SharedBlockReader& operator=(SharedBlockReader&&) noexcept = delete;
+
+        ////////////////////////////////////////////////////////////////
+        // Getters.
+        ////////////////////////////////////////////////////////////////
+
+        [[nodiscard]] size_t getCapacity() const noexcept;
+
+        [[nodiscard]] size_t getSlotCount() const noexcept;
+
+        /**
+         * \brief Get the number of the last frame the writer completed.
+         * \return Frame number, or 0 if nothing was published yet.
+         */
+        [[nodiscard]] uint64_t getLatestFrameNumber() const noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Read.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Reference a frame in shared memory without copying. Read its blocks and then call validate: if that
+         * returns false, the writer overwrote the slot in the meantime and whatever was read must be discarded.
+         * \param number Frame number.
+         * \param frame Frame.
+         * \return False if the frame is no longer (or not yet) in the ring.
+         */
+        [[nodiscard]] bool acquire(uint64_t number, SharedBlockFrame& frame) const noexcept;
+
+        /**
+         * \brief Check that a frame was not overwritten since it was acquired.
+         * \param frame Frame.
+         * \return True if everything read from the frame so far is consistent.
+         */
+        [[nodiscard]] bool validate(const SharedBlockFrame& frame) const noexcept;
+
+        /**
+         * \brief Bring a local copy of the blocks up to date with the latest frame, applying deltas where possible.
+         * \param blocks Local copy.
+         * \param number Number of the frame the local copy holds, or 0 if it holds nothing. Updated.
+         * \return True if the local copy changed. If the reader fell too far behind to catch up, the local copy is
+         * cleared and number is set to 0.
+         */
+        bool update(std::vector<Block>& blocks, uint64_t& number) const;
+
+    private:
+        /**
+         * \brief Apply frames (number, last] to a local copy.
+         * \return False if a frame was overwritten or could not be applied.
+         */
+        bool apply(std::vector<Block>& blocks, uint64_t number, uint64_t last) const;
+
+        ////////////////////////////////////////////////////////////////
+        // Member variables.
+        ////////////////////////////////////////////////////////////////
+
+        size_t capacity = 0;
+
+        size_t slotCount = 0;
+
+        const std::byte* memory = nullptr;
+
+        size_t bytes = 0;
+    };
+}  // namespace floah
@@ -0,0 +1,598 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-layout/block.h"
+#include "floah-layout/generate_options.h"
+#include "floah-common/alignment.h"
+#include "floah-common/floah_error.h"
+
+/*
+ * Compile-time layouts. Describes a fixed tree of elements with value types instead of heap-allocated LayoutElements,
+ * so that the whole tree is a literal type and its blocks can be computed by the compiler:
+ *
+ *     constexpr auto hud = StaticLayout(
+ *       StaticVerticalFlow({.size = {1.0f, 1.0f}},
+ *                          StaticElement({.size = {1.0f, 32}}),
+ *                          makeStaticGrid<3, 1>({.size = {1.0f, 64}},
+ *                                               StaticElement({.size = {0.5f, 1.0f}}),
+ *                                               StaticEmpty{},
+ *                                               StaticElement({.size = {0.5f, 1.0f}}))));
+ *     constexpr auto blocks = hud.generate(1920, 1080);
+ *
+ * Positions are computed exactly like Grid, HorizontalFlow and VerticalFlow do, so the blocks equal those generated
+ * from the equivalent runtime layout, except that all identifiers are nil. Blocks are identified by their index
+ * instead. Flex weights, grid spans, clipping and culling are not supported.
+ */
+
+namespace floah
+{
+    /**
+     * \brief Literal equivalent of Length. Either an absolute value, or a ratio of a reference length.
+     */
+    struct StaticLength
+    {
+        constexpr StaticLength() noexcept = default;
+
+        /**
+         * \brief Absolute length.
+         * \param v Value.
+         */
+        constexpr StaticLength(const int32_t v) noexcept : value(v) {}
+
+        /**
+         * \brief Relative length.
+         * \param r Ratio of reference length.
+         */
+        constexpr StaticLength(const float r) noexcept : ratio(r), relative(true) {}
+
+        /**
+         * \brief Get the absolute value.
+         * \param reference Reference length for relative lengths.
+         * \return Absolute value.
+         */
+        [[nodiscard]] constexpr int32_t get(const int32_t reference) const noexcept
+        {
+            return relative ? static_cast<int32_t>(static_cast<float>(reference) * ratio) : value;
+        }
+
+        int32_t value    = 0;
+        float   ratio    = 0;
+        bool    relative = false;
+    };
+
+    struct StaticSize
+    {
+        StaticLength width;
+        StaticLength height;
+    };
+
+    struct StaticMargin
+    {
+        StaticLength left;
+        StaticLength top;
+        StaticLength right;
+        StaticLength bottom;
+    };
+
+    /**
+     * \brief Layout parameters of a static element. Mirrors the parameters of LayoutElement and the alignments of the
+     * containers.
+     */
+    struct StaticParams
+    {
+        StaticSize size;
+
+        StaticMargin innerMargin;
+
+        StaticMargin outerMargin;
+
+        /**
+         * \brief Horizontal alignment of child elements. Only used by containers.
+         */
+        HorizontalAlignment horAlign = HorizontalAlignment::Left;
+
+        /**
+         * \brief Vertical alignment of child elements. Only used by containers.
+         */
+        VerticalAlignment verAlign = VerticalAlignment::Top;
+    };
+
+    /**
+     * \brief Static equivalent of a plain LayoutElement.
+     */
+    struct StaticElement
+    {
+        static constexpr size_t blockCount = 1;
+
+        static constexpr size_t childCount = 0;
+
+        static constexpr size_t generatedChildCount = 0;
+
+        constexpr explicit StaticElement(const StaticParams& p = {}) noexcept : params(p) {}
+
+        StaticParams params;
+    };
+
+    /**
+     * \brief Empty grid cell. Generates no block.
+     */
+    struct StaticEmpty
+    {
+        static constexpr size_t blockCount = 0;
+
+        static constexpr size_t childCount = 0;
+
+        static constexpr size_t generatedChildCount = 0;
+
+        StaticParams params;
+    };
+
+    /**
+     * \brief Static equivalent of HorizontalFlow.
+     * \tparam Children Child element types.
+     */
+    template<typename... Children>
+    struct StaticHorizontalFlow
+    {
+        static_assert(((Children::blockCount > 0) && ...), "Flows cannot contain empty elements.");
+
+        static constexpr size_t blockCount = (Children::blockCount + ... + 1);
+
+        static constexpr size_t childCount = sizeof...(Children);
+
+        static constexpr size_t generatedChildCount = childCount;
+
+        constexpr explicit StaticHorizontalFlow(const StaticParams& p, Children... c) :
+            params(p), children(std::move(c)...)
+        {
+        }
+
+        /**
+         * \brief Calculate the absolute bounds of all direct child elements. See HorizontalFlow::layoutChildren.
+         * \param bounds Absolute bounds of this element.
+         * \param childBounds Output bounds.
+         */
+        constexpr void layoutChildren(const BBox& bounds, std::array<BBox, childCount>& childBounds) const
+        {
+            if constexpr (childCount > 0)
+            {
+                // Total width and height are the bounds minus the inner margins.
+                const auto boundsWidth  = bounds.x1 - bounds.x0;
+                const auto leftMargin   = params.innerMargin.left.get(boundsWidth);
+                const auto rightMargin  = params.innerMargin.right.get(boundsWidth);
+                const auto width        = boundsWidth - leftMargin - rightMargin;
+                const auto boundsHeight = bounds.y1 - bounds.y0;
+                const auto topMargin    = params.innerMargin.top.get(boundsHeight);
+                const auto bottomMargin = params.innerMargin.bottom.get(boundsHeight);
+                const auto height       = boundsHeight - topMargin - bottomMargin;
+
+                int32_t x = 0;
+                switch (params.horAlign)
+                {
+                case HorizontalAlignment::Left: x = bounds.x0 + leftMargin; break;
+                case HorizontalAlignment::Center:
+                    throw FloahError("Cannot generate. Center not supported for horizontal alignment.");
+                case HorizontalAlignment::Right: x = bounds.x1 - rightMargin;
+                }
+
+                int32_t y = 0;
+                switch (params.verAlign)
+                {
+                case VerticalAlignment::Top: y = bounds.y0 + topMargin; break;
+                case VerticalAlignment::Middle: y = bounds.y0 + topMargin + (height >> 1); break;
+                case VerticalAlignment::Bottom: y = bounds.y1 - bottomMargin;
+                }
+
+                const auto place = [&](const StaticParams& c, BBox& b) {
+                    const auto cWidth  = c.size.width.get(width);
+                    const auto cHeight = c.size.height.get(height);
+
+                    if (params.horAlign == HorizontalAlignment::Left)
+                    {
+                        b.x0 = x + c.outerMargin.left.get(width);
+                        b.x1 = b.x0 + cWidth;
+                        x    = b.x1 + c.outerMargin.right.get(width);
+                    }
+                    else
+                    {
+                        b.x1 = x - c.outerMargin.right.get(width);
+                        b.x0 = b.x1 - cWidth;
+                        x    = b.x0 - c.outerMargin.left.get(width);
+                    }
+
+                    switch (params.verAlign)
+                    {
+                    case VerticalAlignment::Top:
+                        b.y0 = y + c.outerMargin.top.get(height);
+                        b.y1 = b.y0 + cHeight;
+                        break;
+                    case VerticalAlignment::Middle:
+                        b.y0 = y - (cHeight + 1) / 2;
+                        b.y1 = y + cHeight / 2;
+                        break;
+                    case VerticalAlignment::Bottom:
+                        b.y1 = y - c.outerMargin.bottom.get(height);
+                        b.y0 = b.y1 - cHeight;
+                        break;
+                    }
+                };
+
+                std::apply(
+                  [&](const auto&... c) {
+                      size_t i = 0;
+                      (place(c.params, childBounds[i++]), ...);
+                  },
+                  children);
+            }
+        }
+
+        StaticParams params;
+
+        std::tuple<Children...> children;
+    };
+
+    /**
+     * \brief Static equivalent of VerticalFlow.
+     * \tparam Children Child element types.
+     */
+    template<typename... Children>
+    struct StaticVerticalFlow
+    {
+        static_assert(((Children::blockCount > 0) && ...), "Flows cannot contain empty elements.");
+
+        static constexpr size_t blockCount = (Children::blockCount + ... + 1);
+
+        static constexpr size_t childCount = sizeof...(Children);
+
+        static constexpr size_t generatedChildCount = childCount;
+
+        constexpr explicit StaticVerticalFlow(const StaticParams& p, Children... c) :
+            params(p), children(std::move(c)...)
+        {
+        }
+
+        /**
+         * \brief Calculate the absolute bounds of all direct child elements. See VerticalFlow::layoutChildren.
+         * \param bounds Absolute bounds of this element.
+         * \param childBounds Output bounds.
+         */
+        constexpr void layoutChildren(const BBox& bounds, std::array<BBox, childCount>& childBounds) const
+        {
+            if constexpr (childCount > 0)
+            {
+                // Total width and height are the bounds minus the inner margins.
+                const auto boundsWidth  = bounds.x1 - bounds.x0;
+                const auto leftMargin   = params.innerMargin.left.get(boundsWidth);
+                const auto rightMargin  = params.innerMargin.right.get(boundsWidth);
+                const auto width        = boundsWidth - leftMargin - rightMargin;
+                const auto boundsHeight = bounds.y1 - bounds.y0;
+                const auto topMargin    = params.innerMargin.top.get(boundsHeight);
+                const auto bottomMargin = params.innerMargin.bottom.get(boundsHeight);
+                const auto height       = boundsHeight - topMargin - bottomMargin;
+
+                int32_t y = 0;
+                switch (params.verAlign)
+                {
+                case VerticalAlignment::Top: y = bounds.y0 + topMargin; break;
+                case VerticalAlignment::Middle:
+                    throw FloahError("Cannot generate. Middle not supported for vertical alignment.");
+                case VerticalAlignment::Bottom: y = bounds.y1 - bottomMargin;
+                }
+
+                int32_t x = 0;
+                switch (params.horAlign)
+                {
+                case HorizontalAlignment::Left: x = bounds.x0 + leftMargin; break;
+                case HorizontalAlignment::Center: x = bounds.x0 + leftMargin + (width >> 1); break;
+                case HorizontalAlignment::Right: x = bounds.x1 - rightMargin;
+                }
+
+                const auto place = [&](const StaticParams& c, BBox& b) {
+                    const auto cWidth  = c.size.width.get(width);
+                    const auto cHeight = c.size.height.get(height);
+
+                    if (params.verAlign == VerticalAlignment::Top)
+                    {
+                        b.y0 = y + c.outerMargin.top.get(height);
+                        b.y1 = b.y0 + cHeight;
+                        y    = b.y1 + c.outerMargin.bottom.get(height);
+                    }
+                    else
+                    {
+                        b.y1 = y - c.outerMargin.bottom.get(height);
+                        b.y0 = b.y1 - cHeight;
+                        y    = b.y0 - c.outerMargin.top.get(height);
+                    }
+
+                    switch (params.horAlign)
+                    {
+                    case HorizontalAlignment::Left:
+                        b.x0 = x + c.outerMargin.left.get(width);
+                        b.x1 = b.x0 + cWidth;
+                        break;
+                    case HorizontalAlignment::Center:
+                        b.x0 = x - (cWidth + 1) / 2;
+                        b.x1 = x + cWidth / 2;
+                        break;
+                    case HorizontalAlignment::Right:
+                        b.x1 = x - c.outerMargin.right.get(width);
+                        b.x0 = b.x1 - cWidth;
+                        break;
+                    }
+                };
+
+                std::apply(
+                  [&](const auto&... c) {
+                      size_t i = 0;
+                      (place(c.params, childBounds[i++]), ...);
+                  },
+                  children);
+            }
+        }
+
+        StaticParams params;
+
+        std::tuple<Children...> children;
+    };
+
+    /**
+     * \brief Static equivalent of Grid. Children fill the cells in row-major order. Use StaticEmpty for empty cells.
+     * Cells past the last child are empty.
+     * \tparam Columns Number of columns.
+     * \tparam Rows Number of rows.
+     * \tparam Children Child element types.
+     */
+    template<size_t Columns, size_t Rows, typename... Children>
+    struct StaticGrid
+    {
+        static_assert(Columns > 0 && Rows > 0, "Grid must have at least one cell.");
+        static_assert(sizeof...(Children) <= Columns * Rows, "Grid has more children than cells.");
+
+        static constexpr size_t blockCount = (Children::blockCount + ... + 1);
+
+        static constexpr size_t childCount = sizeof...(Children);
+
+        /**
+         * \brief Number of children that generate a block, i.e. that are not StaticEmpty.
+         */
+        static constexpr size_t generatedChildCount = ((Children::blockCount > 0 ? 1 : 0) + ... + 0);
+
+        constexpr explicit StaticGrid(const StaticParams& p, Children... c) : params(p), children(std::move(c)...) {}
+
+        /**
+         * \brief Calculate the absolute bounds of all direct child elements. See Grid::layoutChildren.
+         * \param bounds Absolute bounds of this element.
+         * \param childBounds Output bounds.
+         */
+        constexpr void layoutChildren(const BBox& bounds, std::array<BBox, childCount>& childBounds) const
+        {
+            if constexpr (childCount > 0)
+            {
+                const auto boundsWidth  = bounds.x1 - bounds.x0;
+                const auto leftMargin   = params.innerMargin.left.get(boundsWidth);
+                const auto rightMargin  = params.innerMargin.right.get(boundsWidth);
+                const auto gridX        = bounds.x0 + leftMargin;
+                const auto width        = boundsWidth - leftMargin - rightMargin;
+                const auto cellWidth    = width / static_cast<int32_t>(Columns);
+                const auto boundsHeight = bounds.y1 - bounds.y0;
+                const auto topMargin    = params.innerMargin.top.get(boundsHeight);
+                const auto bottomMargin = params.innerMargin.bottom.get(boundsHeight);
+                const auto gridY        = bounds.y0 + topMargin;
+                const auto height       = boundsHeight - topMargin - bottomMargin;
+                const auto cellHeight   = height / static_cast<int32_t>(Rows);
+
+                const auto place = [&](const StaticParams& c, const size_t index, BBox& b) {
+                    const auto x0 = gridX + cellWidth * static_cast<int32_t>(index % Columns);
+                    const auto y0 = gridY + cellHeight * static_cast<int32_t>(index / Columns);
+
+                    const auto cWidth  = c.size.width.get(width) / static_cast<int32_t>(Columns);
+                    const auto cHeight = c.size.height.get(height) / static_cast<int32_t>(Rows);
+
+                    const auto center = x0 + cellWidth / 2;
+                    switch (params.horAlign)
+                    {
+                    case HorizontalAlignment::Left:
+                        b.x0 = x0 + c.outerMargin.left.get(cellWidth);
+                        b.x1 = b.x0 + cWidth;
+                        break;
+                    case HorizontalAlignment::Center:
+                        b.x0 = center - (cWidth + 1) / 2;
+                        b.x1 = center + cWidth / 2;
+                        break;
+                    case HorizontalAlignment::Right:
+                        b.x1 = x0 + cellWidth - c.outerMargin.right.get(cellWidth);
+                        b.x0 = b.x1 - cWidth;
+                        break;
+                    }
+
+                    const auto middle = y0 + cellHeight / 2;
+                    switch (params.verAlign)
+                    {
+                    case VerticalAlignment::Top:
+                        b.y0 = y0 + c.outerMargin.top.get(cellHeight);
+                        b.y1 = b.y0 + cHeight;
+                        break;
+                    case VerticalAlignment::Middle:
+                        b.y0 = middle - (cHeight + 1) / 2;
+                        b.y1 = middle + cHeight / 2;
+                        break;
+                    case VerticalAlignment::Bottom:
+                        b.y1 = y0 + cellHeight - c.outerMargin.bottom.get(cellHeight);
+                        b.y0 = b.y1 - cHeight;
+                        break;
+                    }
+                };
+
+                std::apply(
+                  [&](const auto&... c) {
+                      size_t i = 0;
+                      ((place(c.params, i, childBounds[i]), i++), ...);
+                  },
+                  children);
+            }
+        }
+
+        StaticParams params;
+
+        std::tuple<Children...> children;
+    };
+
+    /**
+     * \brief Make a static grid, deducing the child element types.
+     * \tparam Columns Number of columns.
+     * \tparam Rows Number of rows.
+     * \param params Layout parameters.
+     * \param children Child elements in row-major order.
+     * \return StaticGrid.
+     */
+    template<size_t Columns, size_t Rows, typename... Children>
+    [[nodiscard]] constexpr StaticGrid<Columns, Rows, Children...> makeStaticGrid(const StaticParams& params,
+                                                                                 Children... children)
+    {
+        return StaticGrid<Columns, Rows, Children...>(params, std::move(children)...);
+    }
+
+    /**
+     * \brief Static equivalent of Layout. The number of blocks is known at compile time, and generating blocks does not
+     * allocate. If the size is a constant, generate can be evaluated by the compiler.
+     * \tparam Root Root element type.
+     */
+    template<typename Root>
+    class StaticLayout
+    {
+    public:
+        static_assert(Root::blockCount > 0, "Root cannot be empty.");
+
+        /**
+         * \brief Number of blocks generated by this layout.
+         */
+        static constexpr size_t blockCount = Root::blockCount;
+
+        using Blocks = std::array<Block, blockCount>;
+
+        ////////////////////////////////////////////////////////////////
+        // Constructors.
+        ////////////////////////////////////////////////////////////////
+
+        constexpr explicit StaticLayout(Root r) : root(std::move(r)) {}
+
+        ////////////////////////////////////////////////////////////////
+        // Getters.
+        ////////////////////////////////////////////////////////////////
+
+        [[nodiscard]] constexpr const Root& getRoot() const noexcept { return root; }
+
+        ////////////////////////////////////////////////////////////////
+        // Generate.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Generate all blocks. Equivalent to Layout::generate with an absolute layout size and offset.
+         * \param width Width of layout.
+         * \param height Height of layout.
+         * \param x Horizontal offset of layout.
+         * \param y Vertical offset of layout.
+         * \param order Order of blocks.
+         * \return List of blocks, with nil identifiers.
+         */
+        [[nodiscard]] constexpr Blocks generate(const int32_t    width,
+                                                const int32_t    height,
+                                                const int32_t    x     = 0,
+                                                const int32_t    y     = 0,
+                                                const BlockOrder order = BlockOrder::Siblings) const
+        {
+            const auto left = root.params.outerMargin.left.get(width) + x;
+            const auto top  = root.params.outerMargin.top.get(height) + y;
+            const BBox bounds{.x0 = left,
+                              .y0 = top,
+                              .x1 = left + root.params.size.width.get(width),
+                              .y1 = top + root.params.size.height.get(height)};
+
+            Blocks blocks{};
+            blocks[0]   = Block{.id = {}, .bounds = bounds, .childBounds = bounds, .subtreeEnd = 1};
+            size_t next = 1;
+            visit(root, blocks, 0, next, order);
+            return blocks;
+        }
+
+    private:
+        template<typename Element>
+        static constexpr void
+          visit(const Element& element, Blocks& blocks, const size_t index, size_t& next, const BlockOrder order)
+        {
+            if constexpr (Element::childCount > 0)
+            {
+                std::array<BBox, Element::childCount> childBounds{};
+                element.layoutChildren(blocks[index].bounds, childBounds);
+
+                constexpr auto count = Element::generatedChildCount;
+                if constexpr (count > 0)
+                {
+                    blocks[index].childCount = count;
+                    blocks[index].firstChild = order == BlockOrder::Siblings ? next : index + 1;
+                }
+
+                // In sibling order, all children are indexed before any of them is visited.
+                auto childIndex = next;
+                if (order == BlockOrder::Siblings) next += count;
+
+                std::apply(
+                  [&](const auto&... children) {
+                      size_t i = 0;
+                      (visitChild(children, childBounds[i++], blocks, index, childIndex, next, order), ...);
+                  },
+                  element.children);
+            }
+        }
+
+        template<typename Element>
+        static constexpr void visitChild(const Element&   element,
+                                         const BBox&      bounds,
+                                         Blocks&          blocks,
+                                         const size_t     parent,
+                                         size_t&          childIndex,
+                                         size_t&          next,
+                                         const BlockOrder order)
+        {
+            if constexpr (Element::blockCount > 0)
+            {
+                const auto index = order == BlockOrder::Siblings ? childIndex++ : next++;
+                blocks[index]    = Block{.id          = {},
+                                         .bounds      = bounds,
+                                         .childBounds = bounds,
+                                         .parent      = parent,
+                                         .subtreeEnd  = index + 1,
+                                         .depth       = blocks[parent].depth + 1};
+                visit(element, blocks, index, next, order);
+
+                // Accumulate into parent.
+                const auto& child = blocks[index];
+                auto&       p     = blocks[parent];
+                p.childBounds.x0  = std::min(p.childBounds.x0, child.childBounds.x0);
+                p.childBounds.y0  = std::min(p.childBounds.y0, child.childBounds.y0);
+                p.childBounds.x1  = std::max(p.childBounds.x1, child.childBounds.x1);
+                p.childBounds.y1  = std::max(p.childBounds.y1, child.childBounds.y1);
+                p.subtreeEnd      = std::max(p.subtreeEnd, child.subtreeEnd);
+            }
+        }
+
+        ////////////////////////////////////////////////////////////////
+        // Member variables.
+        ////////////////////////////////////////////////////////////////
+
+        Root root;
+    };
+}  // namespace floah
@@ -0,0 +1,169 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-layout/block.h"
+
+namespace floah
+{
+    /**
+     * \brief Lists of the blocks that overlap each tile of a regular grid of screen tiles, for tiled renderers. All
+     * lists are stored back to back in a single array (compressed sparse rows): the blocks of tile k are at
+     * indices[offsets[k], offsets[k + 1]). Tiles are numbered row by row. Within a tile, blocks are in the order of the
+     * block list, so drawing them in that order keeps parents behind children.
+     *
+     * Binning is done in two parallel passes, one to count and one to fill, so storage is allocated once per build and
+     * reused by later builds. A block whose childBounds fit inside a single tile is binned together with its whole
+     * subtree, without testing its descendants against the tile grid.
+     */
+    class TileBins
+    {
+    public:
+        ////////////////////////////////////////////////////////////////
+        // Constructors.
+        ////////////////////////////////////////////////////////////////
+
+        TileBins();
+
+        TileBins(const TileBins&);
+
+        TileBins(TileBins&&) noexcept;
+
+        ~TileBins() noexcept;
+
+        TileBins& operator=(const TileBins&);
+
+        TileBins& operator=(TileBins&&) noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Getters.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Get the area covered by the tiles. The last column and row of tiles can extend past the area.
+         * \return Area.
+         */
+        [[nodiscard]] const BBox& getArea() const noexcept;
+
+        [[nodiscard]] int32_t getTileWidth() const noexcept;
+
+        [[nodiscard]] int32_t getTileHeight() const noexcept;
+
+        [[nodiscard]] size_t getColumnCount() const noexcept;
+
+        [[nodiscard]] size_t getRowCount() const noexcept;
+
+        /**
+         * \brief Get the offset of the list of each tile into the block indices, plus the total number of indices.
+         * \return Offsets, columnCount * rowCount + 1 values.
+         */
+        [[nodiscard]] std::span<const size_t> getOffsets() const noexcept;
+
+        /**
+         * \brief Get the block indices of all tiles.
+         * \return Block indices.
+         */
+        [[nodiscard]] std::span<const size_t> getIndices() const noexcept;
+
+        /**
+         * \brief Get the indices of the blocks that overlap a tile.
+         * \param column Column of tile.
+         * \param row Row of tile.
+         * \return Block indices.
+         */
+        [[nodiscard]] std::span<const size_t> getTile(size_t column, size_t row) const;
+
+        ////////////////////////////////////////////////////////////////
+        // Modifiers.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Bin a list of blocks with absolute coordinates (see CoordinateMode::Absolute) into tiles. Blocks
+         * outside of the area, blocks with empty bounds and blocks with BlockFlags::Culled or BlockFlags::Clipped are not
+         * binned.
+         * \param blocks Blocks.
+         * \param area Area to cover with tiles. The first tile starts at its top-left corner.
+         * \param tileWidth Width of a tile.
+         * \param tileHeight Height of a tile.
+         * \param threadCount Maximum number of threads to use. If 0, the number of hardware threads.
+         */
+        void build(std::span<const Block> blocks,
+                   const BBox&            area,
+                   int32_t                tileWidth,
+                   int32_t                tileHeight,
+                   size_t                 threadCount = 0);
+
+        /**
+         * \brief Remove all tiles. Keeps allocated storage.
+         */
+        void clear() noexcept;
+
+    private:
+        /**
+         * \brief Inclusive range of tiles.
+         */
+        struct TileRange
+        {
+            size_t column0 = 0;
+            size_t row0    = 0;
+            size_t column1 = 0;
+            size_t row1    = 0;
+        };
+
+        /**
+         * \brief Get the tiles overlapped by a rectangle.
+         * \param bounds Rectangle.
+         * \param range Tiles.
+         * \return False if the rectangle lies outside of the area.
+         */
+        [[nodiscard]] bool getTileRange(const BBox& bounds, TileRange& range) const noexcept;
+
+        /**
+         * \brief Count (first pass) or write (second pass) the tile entries of a range of blocks.
+         * \param blocks Blocks.
+         * \param begin Index of first block.
+         * \param end One past index of last block.
+         * \param tileCursors Per tile, number of entries (first pass) or index of next entry (second pass).
+         * \param fill If true, write entries.
+         */
+        void binRange(std::span<const Block> blocks, size_t begin, size_t end, size_t* tileCursors, bool fill) noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Member variables.
+        ////////////////////////////////////////////////////////////////
+
+        BBox area;
+
+        int32_t tileWidth = 0;
+
+        int32_t tileHeight = 0;
+
+        size_t columnCount = 0;
+
+        size_t rowCount = 0;
+
+        std::vector<size_t> offsets;
+
+        std::vector<size_t> indices;
+
+        /**
+         * \brief Per block, the single tile containing its whole subtree, or one of the special values.
+         */
+        std::vector<uint32_t> labels;
+
+        /**
+         * \brief Per thread and tile, the number of entries and then the write cursor.
+         */
+        std::vector<size_t> cursors;
+    };
+}  // namespace floah
@@ -0,0 +1,241 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-layout/block.h"
+#include "floah-layout/id_index.h"
+
+namespace floah
+{
+    /**
+     * \brief Easing curve applied to the interpolation parameter.
+     */
+    enum class Easing : uint8_t
+    {
+        Linear,
+
+        /**
+         * \brief Quadratic, starting slow.
+         */
+        EaseIn,
+
+        /**
+         * \brief Quadratic, ending slow.
+         */
+        EaseOut,
+
+        /**
+         * \brief Cubic smoothstep, starting and ending slow.
+         */
+        EaseInOut
+    };
+
+    /**
+     * \brief How blocks without a counterpart in the other generation are animated.
+     */
+    enum class UnmatchedMode : uint8_t
+    {
+        /**
+         * \brief Blocks that appear are at their end bounds and blocks that disappear at their start bounds for all t.
+         */
+        Snap,
+
+        /**
+         * \brief Blocks that appear grow from an empty rectangle at the center of their end bounds. Blocks that
+         * disappear shrink to an empty rectangle at the center of their start bounds.
+         */
+        Collapse,
+
+        /**
+         * \brief Blocks that appear start at the start bounds of their nearest matched ancestor. Blocks that disappear
+         * end at the end bounds of their nearest matched ancestor. Falls back to Collapse if there is no such ancestor.
+         */
+        Parent
+    };
+
+    struct TransitionOptions
+    {
+        /**
+         * \brief Easing curve.
+         */
+        Easing easing = Easing::Linear;
+
+        /**
+         * \brief Handling of blocks that appear or disappear.
+         */
+        UnmatchedMode unmatched = UnmatchedMode::Collapse;
+    };
+
+    /**
+     * \brief Apply an easing curve.
+     * \param easing Easing curve.
+     * \param t Interpolation parameter in [0, 1].
+     * \return Eased parameter in [0, 1].
+     */
+    [[nodiscard]] float ease(Easing easing, float t) noexcept;
+
+    /**
+     * \brief Interpolates between two generations of blocks of the same layout, e.g. before and after a panel opened.
+     * Blocks are matched by identifier once, when the transition is set. Evaluating the transition for a value of t is
+     * then a single branchless pass over all rectangles, without touching the layout.
+     *
+     * The interpolated rectangles are ordered like the end blocks: rectangle i belongs to end block i. Rectangles for
+     * blocks that disappear follow after that, in the order of the start blocks (see getLeavingIndices). Blocks must
+     * have absolute coordinates. Blocks with nil identifiers (e.g. from a StaticLayout) are matched by index.
+     */
+    class Transition
+    {
+    public:
+        /**
+         * \brief Source index of a block that has no start block.
+         */
+        static constexpr size_t noIndex = static_cast<size_t>(-1);
+
+        ////////////////////////////////////////////////////////////////
+        // Constructors.
+        ////////////////////////////////////////////////////////////////
+
+        Transition();
+
+        Transition(const Transition&);
+
+        Transition(Transition&&) noexcept;
+
+        ~Transition() noexcept;
+
+        Transition& operator=(const Transition&);
+
+        Transition& operator=(Transition&&) noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Getters.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Get the number of interpolated rectangles.
+         * \return Count.
+         */
+        [[nodiscard]] size_t size() const noexcept;
+
+        /**
+         * \brief Get the number of end blocks that were matched to a start block.
+         * \return Count.
+         */
+        [[nodiscard]] size_t getMatchedCount() const noexcept;
+
+        /**
+         * \brief Get the index of the start block of each end block, or noIndex for blocks that appear.
+         * \return Indices, one per end block.
+         */
+        [[nodiscard]] std::span<const size_t> getSourceIndices() const noexcept;
+
+        /**
+         * \brief Get the indices of the start blocks that disappear. Their rectangles follow the rectangles of the end
+         * blocks, in this order.
+         * \return Indices.
+         */
+        [[nodiscard]] std::span<const size_t> getLeavingIndices() const noexcept;
+
+        /**
+         * \brief Get the rectangles of the last evaluate.
+         * \return Rectangles.
+         */
+        [[nodiscard]] std::span<const BBox> getBounds() const noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Modifiers.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Match two generations of blocks and prepare the interpolation. The blocks are not referenced after
+         * this call. Storage is reused between calls.
+         * \param from Start blocks.
+         * \param to End blocks.
+         * \param options Options.
+         */
+        void set(std::span<const Block> from, std::span<const Block> to, const TransitionOptions& options = {});
+
+        /**
+         * \brief Remove all rectangles. Keeps allocated storage.
+         */
+        void clear() noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Evaluate.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Interpolate all rectangles. At t = 0 the rectangles equal the start bounds and at t = 1 the end bounds,
+         * exactly. Intermediate coordinates are truncated towards the start bounds.
+         * \param t Interpolation parameter. Clamped to [0, 1].
+         * \return Rectangles. Valid until the next call to evaluate, set or clear.
+         */
+        std::span<const BBox> evaluate(float t) noexcept;
+
+    private:
+        /**
+         * \brief Difference between end and start bounds.
+         */
+        struct Delta
+        {
+            float x0 = 0;
+            float y0 = 0;
+            float x1 = 0;
+            float y1 = 0;
+        };
+
+        void append(const BBox& start, const BBox& end);
+
+        ////////////////////////////////////////////////////////////////
+        // Member variables.
+        ////////////////////////////////////////////////////////////////
+
+        Easing easing = Easing::Linear;
+
+        size_t matched = 0;
+
+        std::vector<size_t> sources;
+
+        std::vector<size_t> leaving;
+
+        /**
+         * \brief Start bounds per rectangle.
+         */
+        std::vector<BBox> starts;
+
+        /**
+         * \brief End minus start bounds per rectangle.
+         */
+        std::vector<Delta> deltas;
+
+        /**
+         * \brief Output rectangles.
+         */
+        std::vector<BBox> bounds;
+
+        /**
+         * \brief Index of start block per end block, or noIndex. Used while matching.
+         */
+        std::vector<size_t> targets;
+
+        /**
+         * \brief Nearest matched ancestor per block, or noIndex. Used while matching.
+         */
+        std::vector<size_t> ancestors;
+
+        /**
+         * \brief Table from identifier to index of start block. Used while matching.
+         */
+        IdIndex<size_t> index;
+    };
+}  // namespace floah
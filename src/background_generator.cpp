@@ -0,0 +1,96 @@
+#include "floah-layout/background_generator.h"
+
+namespace floah
+{
+    ////////////////////////////////////////////////////////////////
+    // Constructors.
+    ////////////////////////////////////////////////////////////////
+
+    BackgroundGenerator::BackgroundGenerator() : worker([this] { run(); }) {}
+
+    BackgroundGenerator::~BackgroundGenerator() noexcept
+    {
+        {
+            std::scoped_lock lock(mutex);
+            stopping = true;
+        }
+        submitted.notify_one();
+        worker.join();
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Getters.
+    ////////////////////////////////////////////////////////////////
+
+    std::shared_ptr<const GeneratedBlocks> BackgroundGenerator::getResult() const noexcept
+    {
+        return front.load(std::memory_order_acquire);
+    }
+
+    std::exception_ptr BackgroundGenerator::getError() const
+    {
+        std::scoped_lock lock(mutex);
+        return error;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // ...
+    ////////////////////////////////////////////////////////////////
+
+    void BackgroundGenerator::submit(std::shared_ptr<const LayoutSnapshot> snapshot)
+    {
+        {
+            std::scoped_lock lock(mutex);
+            pending = std::move(snapshot);
+        }
+        submitted.notify_one();
+    }
+
+    void BackgroundGenerator::wait()
+    {
+        std::unique_lock lock(mutex);
+        idle.wait(lock, [this] { return !pending && !busy; });
+    }
+
+    void BackgroundGenerator::run()
+    {
+        std::unique_lock lock(mutex);
+        while (true)
+        {
+            submitted.wait(lock, [this] { return stopping || pending; });
+            if (stopping) return;
+
+            auto snapshot = std::move(pending);
+            pending.reset();
+            busy = true;
+            lock.unlock();
+
+            std::exception_ptr e;
+            try
+            {
+                // Generate into the back buffer.
+                auto back = spare ? std::move(spare) : std::make_shared<GeneratedBlocks>();
+                spare.reset();
+                back->snapshot = snapshot;
+                snapshot->generate(back->blocks, back->index);
+
+                // Publish. If no reader holds on to the previous front buffer, reuse it as the next back buffer.
+                auto old = front.exchange(std::move(back), std::memory_order_acq_rel);
+                if (old && old.use_count() == 1)
+                {
+                    spare = std::const_pointer_cast<GeneratedBlocks>(std::move(old));
+                    spare->snapshot.reset();
+                }
+            }
+            catch (...)
+            {
+                e = std::current_exception();
+            }
+
+            lock.lock();
+            error = e;
+            busy  = false;
+            if (!pending) idle.notify_all();
+        }
+    }
+}  // namespace floah
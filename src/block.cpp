@@ -2,4 +2,52 @@
 
 namespace floah
 {
+    BBox resolveBounds(const std::span<const Block> blocks, size_t index) noexcept
+    {
+        auto bounds = blocks[index].bounds;
+        for (index = blocks[index].parent; index != Block::noParent; index = blocks[index].parent)
+        {
+            const auto& origin = blocks[index].bounds;
+            bounds.x0 += origin.x0;
+            bounds.y0 += origin.y0;
+            bounds.x1 += origin.x0;
+            bounds.y1 += origin.y0;
+        }
+        return bounds;
+    }
+
+    void resolveAbsolute(const std::span<Block> blocks) noexcept
+    {
+        for (auto& block : blocks)
+        {
+            if (block.parent == Block::noParent) continue;
+
+            // Parent was already made absolute.
+            const auto dx = blocks[block.parent].bounds.x0;
+            const auto dy = blocks[block.parent].bounds.y0;
+            block.bounds.x0 += dx;
+            block.bounds.y0 += dy;
+            block.bounds.x1 += dx;
+            block.bounds.y1 += dy;
+            block.childBounds.x0 += dx;
+            block.childBounds.y0 += dy;
+            block.childBounds.x1 += dx;
+            block.childBounds.y1 += dy;
+        }
+    }
+
+    void translateBlocks(const std::span<Block> blocks, const int32_t dx, const int32_t dy) noexcept
+    {
+        for (auto& block : blocks)
+        {
+            block.bounds.x0 += dx;
+            block.bounds.y0 += dy;
+            block.bounds.x1 += dx;
+            block.bounds.y1 += dy;
+            block.childBounds.x0 += dx;
+            block.childBounds.y0 += dy;
+            block.childBounds.x1 += dx;
+            block.childBounds.y1 += dy;
+        }
+    }
 }  // namespace floah
@@ -0,0 +1,432 @@
+#include "floah-layout/block_file_cache.h"
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+////////////////////////////////////////////////////////////////
+// External includes.
+////////////////////////////////////////////////////////////////
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-common/floah_error.h"
+#include "hash.h"
+
+namespace floah
+{
+    namespace
+    {
+        constexpr uint32_t fileMagic = 0x464c4243;
+
+        /**
+         * \brief Incremented whenever the file format changes.
+         */
+        constexpr uint32_t fileFormat = 2;
+
+        constexpr size_t fileAlignment = 64;
+
+        constexpr const char* fileExtension = ".floah-blocks";
+
+        static_assert(std::is_trivially_copyable_v<Block>, "Blocks are copied to and from files.");
+
+        struct FileHeader
+        {
+            uint32_t magic = 0;
+
+            uint32_t format = 0;
+
+            uint32_t versionMajor = 0;
+
+            uint32_t versionMinor = 0;
+
+            uint32_t versionPatch = 0;
+
+            /**
+             * \brief Size of a block, as a check that the file was written on a compatible platform.
+             */
+            uint32_t blockSize = 0;
+
+            uint64_t hash = 0;
+
+            uint64_t elementCount = 0;
+
+            /**
+             * \brief Number of words in the structural fingerprint (see BlockFileCache::fingerprint).
+             */
+            uint64_t fingerprintSize = 0;
+
+            uint64_t blockCount = 0;
+        };
+
+        [[nodiscard]] constexpr size_t alignSize(const size_t size) noexcept
+        {
+            return (size + fileAlignment - 1) / fileAlignment * fileAlignment;
+        }
+
+        [[nodiscard]] constexpr size_t getFingerprintOffset() noexcept { return alignSize(sizeof(FileHeader)); }
+
+        [[nodiscard]] constexpr size_t getOrdinalsOffset(const size_t words) noexcept
+        {
+            return getFingerprintOffset() + alignSize(words * sizeof(uint64_t));
+        }
+
+        [[nodiscard]] constexpr size_t getBlocksOffset(const size_t words, const size_t count) noexcept
+        {
+            return getOrdinalsOffset(words) + alignSize(count * sizeof(uint32_t));
+        }
+
+        [[nodiscard]] constexpr size_t getFileSize(const size_t words, const size_t count) noexcept
+        {
+            return getBlocksOffset(words, count) + count * sizeof(Block);
+        }
+
+        /**
+         * \brief Read-only memory mapping of a whole file. Empty if the file cannot be mapped.
+         */
+        class MappedFile
+        {
+        public:
+            explicit MappedFile(const std::filesystem::path& path) noexcept
+            {
+                const auto fd = open(path.c_str(), O_RDONLY);
+                if (fd < 0) return;
+
+                struct stat info = {};
+                if (fstat(fd, &info) == 0 && info.st_size > 0)
+                {
+                    auto* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (mapped != MAP_FAILED)
+                    {
+                        memory = static_cast<const std::byte*>(mapped);
+                        bytes  = static_cast<size_t>(info.st_size);
+                    }
+                }
+                close(fd);
+            }
+
+            MappedFile(const MappedFile&) = delete;
+
+            MappedFile(MappedFile&&) noexcept = delete;
+
+            ~MappedFile() noexcept
+            {
+                if (memory) munmap(const_cast<std::byte*>(memory), bytes);
+            }
+
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            MappedFile& operator=(MappedFile&&) noexcept = delete;
+
+            const std::byte* memory = nullptr;
+
+            size_t bytes = 0;
+        };
+    }  // namespace
+
+    ////////////////////////////////////////////////////////////////
+    // Constructors.
+    ////////////////////////////////////////////////////////////////
+
+    BlockFileCache::BlockFileCache(std::filesystem::path dir) : directory(std::move(dir))
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec) throw FloahError("Cannot create block file cache. Failed to create directory.");
+    }
+
+    BlockFileCache::BlockFileCache(BlockFileCache&&) noexcept = default;
+
+    BlockFileCache::~BlockFileCache() noexcept = default;
+
+    BlockFileCache& BlockFileCache::operator=(BlockFileCache&&) noexcept = default;
+
+    ////////////////////////////////////////////////////////////////
+    // Getters.
+    ////////////////////////////////////////////////////////////////
+
+    const std::filesystem::path& BlockFileCache::getDirectory() const noexcept { return directory; }
+
+    size_t BlockFileCache::getHitCount() const noexcept { return hits; }
+
+    size_t BlockFileCache::getMissCount() const noexcept { return misses; }
+
+    bool BlockFileCache::isCold() const noexcept { return cold; }
+
+    ////////////////////////////////////////////////////////////////
+    // Generate.
+    ////////////////////////////////////////////////////////////////
+
+    void BlockFileCache::generate(const Layout&          layout,
+                                  std::vector<Block>&    blocks,
+                                  BlockIndex&            index,
+                                  const GenerateOptions& options)
+    {
+        if (!cold)
+        {
+            layout.generate(blocks, index, options);
+            return;
+        }
+
+        const auto  version = layout.getStructureVersion();
+        const auto* root    = layout.getRootElement();
+        const auto  rootId  = root ? root->getId() : uuids::uuid{};
+
+        // Serve repeated generates of an unchanged layout from the previous hit, instead of mapping the file again.
+        // Compare the layout, its root and structure version first, so that after a structural change no time is spent
+        // on the memo. Parameters of elements are not tracked, so a matching structure still needs a hash of the tree,
+        // but that pass does not collect anything.
+        if (loaded && loadedLayout == &layout && loadedRoot == rootId && loadedVersion == version &&
+            walk(layout, options, false) == loadedHash)
+        {
+            blocks = loadedBlocks;
+            index  = loadedIndex;
+            hits++;
+            return;
+        }
+
+        if (const GenerateStatus status = layout.validate(); !status) throw FloahError(status.getMessage());
+        const auto hash = walk(layout, options, true);
+        if (read(hash, blocks, index))
+        {
+            loadedBlocks  = blocks;
+            loadedIndex   = index;
+            loadedLayout  = &layout;
+            loadedRoot    = rootId;
+            loadedVersion = version;
+            loadedHash    = hash;
+            loaded        = true;
+            return;
+        }
+
+        // Release the previous hit, it is not needed anymore.
+        cold   = false;
+        loaded = false;
+        loadedBlocks.clear();
+        loadedBlocks.shrink_to_fit();
+        loadedIndex = {};
+        layout.generate(blocks, index, options);
+        write(hash, blocks);
+    }
+
+    bool BlockFileCache::load(const Layout&          layout,
+                              std::vector<Block>&    blocks,
+                              BlockIndex&            index,
+                              const GenerateOptions& options)
+    {
+        if (const GenerateStatus status = layout.validate(); !status) throw FloahError(status.getMessage());
+
+        return read(walk(layout, options, true), blocks, index);
+    }
+
+    bool BlockFileCache::read(const uint64_t hash, std::vector<Block>& blocks, BlockIndex& index)
+    {
+        const MappedFile file(getPath(hash));
+        const auto* header = reinterpret_cast<const FileHeader*>(file.memory);
+        if (!file.memory || file.bytes < sizeof(FileHeader) || header->magic != fileMagic ||
+            header->format != fileFormat || header->versionMajor != FLOAH_VERSION_MAJOR ||
+            header->versionMinor != FLOAH_VERSION_MINOR || header->versionPatch != FLOAH_VERSION_PATCH ||
+            header->blockSize != sizeof(Block) || header->hash != hash || header->elementCount != elements.size() ||
+            header->fingerprintSize != fingerprint.size() || header->blockCount > file.bytes / sizeof(Block) ||
+            getFileSize(fingerprint.size(), header->blockCount) != file.bytes)
+        {
+            misses++;
+            return false;
+        }
+
+        // The key is only a hash, so compare the structure of the tree before trusting the file.
+        const auto  count = static_cast<size_t>(header->blockCount);
+        const auto* fp    = file.memory + getFingerprintOffset();
+        const auto* ords  = reinterpret_cast<const uint32_t*>(file.memory + getOrdinalsOffset(fingerprint.size()));
+        const auto* data  = reinterpret_cast<const Block*>(file.memory + getBlocksOffset(fingerprint.size(), count));
+        if (std::memcmp(fp, fingerprint.data(), fingerprint.size() * sizeof(uint64_t)) != 0)
+        {
+            misses++;
+            return false;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (ords[i] >= elements.size())
+            {
+                misses++;
+                return false;
+            }
+        }
+
+        blocks.assign(data, data + count);
+        index.clear();
+        index.reserve(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            blocks[i].id = elements[ords[i]]->getId();
+            index.insert(blocks[i].id, i);
+        }
+
+        hits++;
+        return true;
+    }
+
+    void BlockFileCache::store(const Layout&                layout,
+                               const std::span<const Block> blocks,
+                               const GenerateOptions&       options)
+    {
+        if (const GenerateStatus status = layout.validate(); !status) throw FloahError(status.getMessage());
+
+        write(walk(layout, options, true), blocks);
+    }
+
+    void BlockFileCache::write(const uint64_t hash, const std::span<const Block> blocks)
+    {
+        ordinals.resize(blocks.size());
+        for (size_t i = 0; i < blocks.size(); i++)
+        {
+            const auto* position = positions.find(blocks[i].id);
+            if (!position) throw FloahError("Cannot store blocks. Block was not generated from this layout.");
+            ordinals[i] = *position;
+        }
+
+        const FileHeader header{.magic            = fileMagic,
+                                .format           = fileFormat,
+                                .versionMajor     = FLOAH_VERSION_MAJOR,
+                                .versionMinor     = FLOAH_VERSION_MINOR,
+                                .versionPatch     = FLOAH_VERSION_PATCH,
+                                .blockSize        = sizeof(Block),
+                                .hash             = hash,
+                                .elementCount     = elements.size(),
+                                .fingerprintSize  = fingerprint.size(),
+                                .blockCount       = blocks.size()};
+
+        // Identifiers are substituted on load, so do not write them.
+        const auto             words = fingerprint.size();
+        std::vector<std::byte> bytes(getFileSize(words, blocks.size()));
+        std::memcpy(bytes.data(), &header, sizeof(header));
+        std::memcpy(bytes.data() + getFingerprintOffset(), fingerprint.data(), words * sizeof(uint64_t));
+        std::ranges::copy(ordinals, reinterpret_cast<uint32_t*>(bytes.data() + getOrdinalsOffset(words)));
+        auto* data = reinterpret_cast<Block*>(bytes.data() + getBlocksOffset(words, blocks.size()));
+        for (size_t i = 0; i < blocks.size(); i++)
+        {
+            data[i]    = blocks[i];
+            data[i].id = uuids::uuid{};
+        }
+
+        // Write to a temporary file first, so that a concurrent or interrupted run never sees a partial file.
+        const auto path = getPath(hash);
+        auto       tmp  = path;
+        tmp += ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            if (!out) throw FloahError("Cannot store blocks. Failed to write file.");
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tmp, path, ec);
+        if (ec)
+        {
+            std::filesystem::remove(tmp, ec);
+            throw FloahError("Cannot store blocks. Failed to replace file.");
+        }
+    }
+
+    void BlockFileCache::clear()
+    {
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, ec))
+        {
+            if (entry.path().extension() == fileExtension) std::filesystem::remove(entry.path(), ec);
+        }
+
+        hits   = 0;
+        misses = 0;
+        cold   = true;
+        loaded = false;
+        loadedBlocks.clear();
+        loadedIndex.clear();
+    }
+
+    uint64_t BlockFileCache::walk(const Layout& layout, const GenerateOptions& options, const bool collect)
+    {
+        if (collect)
+        {
+            elements.clear();
+            positions.clear();
+            fingerprint.clear();
+        }
+
+        uint64_t h = fileFormat;
+        hashCombine(h, layout.getSize());
+        hashCombine(h, layout.getOffset());
+        hashCombine(h, static_cast<uint64_t>(options.cullMode));
+        hashCombine(h, static_cast<uint64_t>(options.order));
+        hashCombine(h, static_cast<uint64_t>(options.coordinates));
+        hashCombine(h, static_cast<uint64_t>(static_cast<uint32_t>(options.minExtent)));
+        hashCombine(h, options.clip.size());
+        for (const auto& clip : options.clip)
+        {
+            hashCombine(h, static_cast<uint64_t>(static_cast<uint32_t>(clip.x0)));
+            hashCombine(h, static_cast<uint64_t>(static_cast<uint32_t>(clip.y0)));
+            hashCombine(h, static_cast<uint64_t>(static_cast<uint32_t>(clip.x1)));
+            hashCombine(h, static_cast<uint64_t>(static_cast<uint32_t>(clip.y1)));
+        }
+
+        // Pre-order walk. Hashing the child count of each element and a marker for each empty position (e.g. grid
+        // cells) makes the sequence of hashes describe a single tree.
+        std::vector<const LayoutElement*> pending;
+        pending.push_back(layout.getRootElement());
+        while (!pending.empty())
+        {
+            const auto* element = pending.back();
+            pending.pop_back();
+            if (!element)
+            {
+                hashCombine(h, uint64_t{0});
+                if (collect)
+                {
+                    fingerprint.push_back(0);
+                    fingerprint.push_back(0);
+                }
+                continue;
+            }
+
+            const auto children   = element->getChildren();
+            const auto layoutHash = element->getLayoutHash();
+            hashCombine(h, layoutHash);
+            hashCombine(h, children.size());
+            if (collect)
+            {
+                if (elements.size() >= std::numeric_limits<uint32_t>::max())
+                    throw FloahError("Cannot cache blocks. Layout has too many elements.");
+                positions.insert(element->getId(), static_cast<uint32_t>(elements.size()));
+                elements.push_back(element);
+                fingerprint.push_back(layoutHash);
+                fingerprint.push_back(children.size() + 1);
+            }
+            for (auto it = children.rbegin(); it != children.rend(); ++it) pending.push_back(it->get());
+        }
+
+        return h;
+    }
+
+    std::filesystem::path BlockFileCache::getPath(const uint64_t hash) const
+    {
+        constexpr auto digits = "0123456789abcdef";
+        std::string    name(16, '0');
+        for (size_t i = 0; i < 16; i++) name[15 - i] = digits[(hash >> (i * 4)) & 0xf];
+        return directory / (name + fileExtension);
+    }
+}  // namespace floah
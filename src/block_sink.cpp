@@ -0,0 +1,40 @@
+#include "floah-layout/block_sink.h"
+
+namespace floah
+{
+    ////////////////////////////////////////////////////////////////
+    // BlockSink.
+    ////////////////////////////////////////////////////////////////
+
+    BlockSink::~BlockSink() noexcept = default;
+
+    void BlockSink::begin(size_t) {}
+
+    void BlockSink::end(size_t) {}
+
+    ////////////////////////////////////////////////////////////////
+    // VectorBlockSink.
+    ////////////////////////////////////////////////////////////////
+
+    VectorBlockSink::VectorBlockSink(std::vector<Block>& b, IdIndex<size_t>* i) : blocks(b), blockIndex(i) {}
+
+    VectorBlockSink::~VectorBlockSink() noexcept = default;
+
+    void VectorBlockSink::begin(const size_t maxCount)
+    {
+        blocks.resize(maxCount);
+        if (blockIndex)
+        {
+            blockIndex->clear();
+            blockIndex->reserve(maxCount);
+        }
+    }
+
+    void VectorBlockSink::write(const size_t index, const Block& block)
+    {
+        blocks[index] = block;
+        if (blockIndex) blockIndex->insert(block.id, index);
+    }
+
+    void VectorBlockSink::end(const size_t count) { blocks.resize(count); }
+}  // namespace floah
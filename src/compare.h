@@ -0,0 +1,54 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-layout/block.h"
+#include "floah-layout/flex.h"
+#include "floah-common/length.h"
+#include "floah-common/margin.h"
+#include "floah-common/size.h"
+
+namespace floah
+{
+    /**
+     * \brief Reference length used to compare relative lengths. Two relative lengths are considered equal if they
+     * resolve to the same absolute length at this (large) reference, i.e. if they are equal up to roughly 1e-6.
+     */
+    inline constexpr int32_t compareReference = 1 << 20;
+
+    [[nodiscard]] inline bool isEqual(const Length& lhs, const Length& rhs) noexcept
+    {
+        return lhs.isRelative() == rhs.isRelative() && lhs.get(compareReference) == rhs.get(compareReference);
+    }
+
+    [[nodiscard]] inline bool isEqual(const Size& lhs, const Size& rhs) noexcept
+    {
+        return isEqual(lhs.getWidth(), rhs.getWidth()) && isEqual(lhs.getHeight(), rhs.getHeight());
+    }
+
+    [[nodiscard]] inline bool isEqual(const Margin& lhs, const Margin& rhs) noexcept
+    {
+        return isEqual(lhs.getLeft(), rhs.getLeft()) && isEqual(lhs.getTop(), rhs.getTop()) &&
+               isEqual(lhs.getRight(), rhs.getRight()) && isEqual(lhs.getBottom(), rhs.getBottom());
+    }
+
+    [[nodiscard]] inline bool isEqual(const Flex& lhs, const Flex& rhs) noexcept
+    {
+        return lhs.weight == rhs.weight && isEqual(lhs.min, rhs.min) && lhs.max.has_value() == rhs.max.has_value() &&
+               (!lhs.max || isEqual(*lhs.max, *rhs.max));
+    }
+
+    [[nodiscard]] inline bool isEqual(const BBox& lhs, const BBox& rhs) noexcept
+    {
+        return lhs.x0 == rhs.x0 && lhs.y0 == rhs.y0 && lhs.x1 == rhs.x1 && lhs.y1 == rhs.y1;
+    }
+
+    [[nodiscard]] inline bool isEqual(const Block& lhs, const Block& rhs) noexcept
+    {
+        return lhs.id == rhs.id && isEqual(lhs.bounds, rhs.bounds) && isEqual(lhs.childBounds, rhs.childBounds) &&
+               lhs.firstChild == rhs.firstChild && lhs.childCount == rhs.childCount && lhs.parent == rhs.parent &&
+               lhs.subtreeEnd == rhs.subtreeEnd && lhs.depth == rhs.depth && lhs.flags == rhs.flags;
+    }
+}  // namespace floah
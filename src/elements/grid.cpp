@@ -1,13 +1,76 @@
 #include "floah-layout/elements/grid.h"
 
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <typeinfo>
+#include <utility>
+
 ////////////////////////////////////////////////////////////////
 // Current target includes.
 ////////////////////////////////////////////////////////////////
 
 #include "floah-common/floah_error.h"
+#include "../hash.h"
+#include "../snapshot_node.h"
 
 namespace floah
 {
+    namespace
+    {
+        constexpr size_t wordBits = 64;
+
+        /**
+         * \brief Read 64 bits of a bitmap starting at an arbitrary bit.
+         * \param src Bitmap.
+         * \param size Number of bits in bitmap. Bits at or past size are read as zero.
+         * \param start Index of first bit.
+         * \return Bits.
+         */
+        [[nodiscard]] uint64_t readBits(const uint64_t* src, const size_t size, const size_t start) noexcept
+        {
+            if (start >= size) return 0;
+            const auto word   = start / wordBits;
+            const auto offset = start % wordBits;
+            auto       bits   = src[word] >> offset;
+            if (offset > 0 && (word + 1) * wordBits < size) bits |= src[word + 1] << (wordBits - offset);
+            if (size - start < wordBits) bits &= (uint64_t{1} << (size - start)) - 1;
+            return bits;
+        }
+
+        /**
+         * \brief Get a mask of count bits starting at bit first. first + count must not exceed 64.
+         */
+        [[nodiscard]] uint64_t maskBits(const size_t first, const size_t count) noexcept
+        {
+            const auto bits = count == wordBits ? ~uint64_t{0} : (uint64_t{1} << count) - 1;
+            return bits << first;
+        }
+
+        /**
+         * \brief Copy a range of bits between bitmaps, a word at a time. The destination range must be zero.
+         */
+        void copyBits(const uint64_t* src,
+                      const size_t    srcSize,
+                      const size_t    srcStart,
+                      uint64_t*       dst,
+                      const size_t    dstStart,
+                      const size_t    count) noexcept
+        {
+            for (size_t i = 0; i < count;)
+            {
+                const auto offset = (dstStart + i) % wordBits;
+                const auto n      = std::min(wordBits - offset, count - i);
+                dst[(dstStart + i) / wordBits] |= (readBits(src, srcSize, srcStart + i) & maskBits(0, n)) << offset;
+                i += n;
+            }
+        }
+    }  // namespace
+
     ////////////////////////////////////////////////////////////////
     // Constructors.
     ////////////////////////////////////////////////////////////////
@@ -16,6 +79,23 @@ namespace floah
 
     Grid::Grid(const Grid& other) : LayoutElement(other), horAlign(other.horAlign), verAlign(other.verAlign) {}
 
+    Grid::Grid(Grid&& other) noexcept :
+        LayoutElement(std::move(other)),
+        horAlign(other.horAlign),
+        verAlign(other.verAlign),
+        rowCount(std::exchange(other.rowCount, 0)),
+        columnCount(std::exchange(other.columnCount, 0)),
+        children(std::move(other.children)),
+        spans(std::move(other.spans)),
+        occupancy(std::move(other.occupancy))
+    {
+        other.children.clear();
+        other.spans.clear();
+        other.occupancy.clear();
+        other.invalidateStructure();
+        reparentChildren();
+    }
+
     Grid::~Grid() noexcept = default;
 
     Grid& Grid::operator=(const Grid& other)
@@ -26,6 +106,26 @@ namespace floah
         return *this;
     }
 
+    Grid& Grid::operator=(Grid&& other) noexcept
+    {
+        if (this == &other) return *this;
+        LayoutElement::operator=(std::move(other));
+        horAlign    = other.horAlign;
+        verAlign    = other.verAlign;
+        rowCount    = std::exchange(other.rowCount, 0);
+        columnCount = std::exchange(other.columnCount, 0);
+        children    = std::move(other.children);
+        spans       = std::move(other.spans);
+        occupancy   = std::move(other.occupancy);
+        other.children.clear();
+        other.spans.clear();
+        other.occupancy.clear();
+        other.invalidateStructure();
+        reparentChildren();
+        invalidateStructure();
+        return *this;
+    }
+
     LayoutElementPtr Grid::clone(Layout* l, LayoutElement* p) const
     {
         auto elem = std::make_unique<Grid>(*this);
@@ -33,11 +133,10 @@ namespace floah
 
         elem->rowCount    = rowCount;
         elem->columnCount = columnCount;
+        elem->spans       = spans;
+        elem->occupancy   = occupancy;
         elem->children.reserve(children.size());
-        for (const auto& c : children)
-        {
-            if (c) elem->children.push_back(c->clone(l, elem.get()));
-        }
+        for (const auto& c : children) elem->children.push_back(c ? c->clone(l, elem.get()) : nullptr);
 
         return elem;
     }
@@ -54,132 +153,303 @@ namespace floah
 
     size_t Grid::getColumnCount() const noexcept { return columnCount; }
 
-    ////////////////////////////////////////////////////////////////
-    // Setters.
-    ////////////////////////////////////////////////////////////////
-
-    void Grid::setLayout(Layout* l) noexcept
+    Grid::CellSpan Grid::getSpan(const size_t x, const size_t y) const
     {
-        LayoutElement::setLayout(l);
-        for (auto& c : children)
-        {
-            if (c) LayoutElement::setLayout(l, *c);
-        }
-    }
+        if (x >= columnCount || y >= rowCount) throw FloahError("Cannot get span. Index is out of range.");
 
-    void Grid::setHorizontalAlignment(const HorizontalAlignment alignment) noexcept { horAlign = alignment; }
+        const auto it = findSpan(x, y);
+        if (it == spans.end()) return {};
+        return CellSpan{.columns = it->columns, .rows = it->rows};
+    }
 
-    void Grid::setVerticalAlignment(const VerticalAlignment alignment) noexcept { verAlign = alignment; }
+    bool Grid::isOccupied(const size_t x, const size_t y) const
+    {
+        if (x >= columnCount || y >= rowCount) throw FloahError("Cannot get occupancy. Index is out of range.");
 
-    ////////////////////////////////////////////////////////////////
-    // Generate.
-    ////////////////////////////////////////////////////////////////
+        return findOccupied(x, y, 1) != columnCount;
+    }
 
-    void Grid::countBlocks(size_t& count) const noexcept
+    std::optional<Grid::CellIndex> Grid::findFreeRegion(const size_t columns, const size_t rows) const noexcept
     {
-        count++;
-        for (const auto& c : children)
+        if (columns == 0 || rows == 0 || columns > columnCount || rows > rowCount) return std::nullopt;
+
+        for (size_t y = 0; y + rows <= rowCount; y++)
         {
-            if (c) c->countBlocks(count);
+            for (size_t x = 0; x + columns <= columnCount;)
+            {
+                // Any region that starts at or before an occupied cell and covers it is not free either, so continue
+                // right after it.
+                auto occupied = columnCount;
+                for (size_t j = y; j < y + rows && occupied == columnCount; j++) occupied = findOccupied(x, j, columns);
+                if (occupied == columnCount) return CellIndex{.x = x, .y = y};
+                x = occupied + 1;
+            }
         }
+
+        return std::nullopt;
     }
 
-    void Grid::generate(std::vector<Block>& blocks, Block& block) const
+    bool Grid::isLayoutEqual(const LayoutElement& other) const noexcept
     {
-        if (children.empty()) return;
+        if (!LayoutElement::isLayoutEqual(other)) return false;
+        const auto& o = static_cast<const Grid&>(other);
+        return horAlign == o.horAlign && verAlign == o.verAlign && rowCount == o.rowCount &&
+               columnCount == o.columnCount && spans == o.spans;
+    }
 
-        // Count number of children.
-        for (const auto& c : children)
+    uint64_t Grid::getLayoutHash() const noexcept
+    {
+        auto h = LayoutElement::getLayoutHash();
+        hashCombine(h, static_cast<uint64_t>(horAlign));
+        hashCombine(h, static_cast<uint64_t>(verAlign));
+        hashCombine(h, rowCount);
+        hashCombine(h, columnCount);
+        for (const auto& span : spans)
         {
-            if (c) block.childCount++;
+            hashCombine(h, span.x);
+            hashCombine(h, span.y);
+            hashCombine(h, span.columns);
+            hashCombine(h, span.rows);
         }
-        if (block.childCount == 0) return;
-        block.firstChild = blocks.size();
+        return h;
+    }
+
+    std::span<const LayoutElementPtr> Grid::getChildren() const noexcept { return children; }
 
-        const auto& bounds = block.bounds;
+    std::span<LayoutElementPtr> Grid::getChildSlots() noexcept { return children; }
+
+    bool Grid::swapChildren(LayoutElement& other) noexcept
+    {
+        auto& grid = static_cast<Grid&>(other);
+        std::swap(rowCount, grid.rowCount);
+        std::swap(columnCount, grid.columnCount);
+        children.swap(grid.children);
+        spans.swap(grid.spans);
+        occupancy.swap(grid.occupancy);
+        reparentChildren();
+        grid.reparentChildren();
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Geometry.
+    ////////////////////////////////////////////////////////////////
+
+    Grid::Geometry Grid::calculateGeometry(const BBox& bounds) const noexcept
+    {
+        return calculateGeometry(innerMargin, columnCount, rowCount, bounds);
+    }
+
+    Grid::Geometry Grid::calculateGeometry(const Margin& innerMargin,
+                                           const size_t  columns,
+                                           const size_t  rows,
+                                           const BBox&   bounds) noexcept
+    {
+        Geometry g;
+        g.columnCount = columns;
+        g.rowCount    = rows;
 
         // Total width is bounds.width minus left and right margin.
         const auto boundsWidth = bounds.width();
         const auto leftMargin  = innerMargin.getLeft().get(boundsWidth);
         const auto rightMargin = innerMargin.getRight().get(boundsWidth);
-        const auto width       = boundsWidth - leftMargin - rightMargin;
-        const auto cellWidth   = width / static_cast<int32_t>(columnCount);
-        const auto x           = bounds.x0 + leftMargin;
+        g.x                    = bounds.x0 + leftMargin;
+        g.width                = boundsWidth - leftMargin - rightMargin;
+        if (columns > 0) g.cellWidth = g.width / static_cast<int32_t>(columns);
 
         // Total height is bounds.height minus top and bottom margin.
         const auto boundsHeight = bounds.height();
         const auto topMargin    = innerMargin.getTop().get(boundsHeight);
         const auto bottomMargin = innerMargin.getBottom().get(boundsHeight);
-        const auto height       = boundsHeight - topMargin - bottomMargin;
-        const auto cellHeight   = height / static_cast<int32_t>(rowCount);
-        const auto y            = bounds.y0 + topMargin;
+        g.y                     = bounds.y0 + topMargin;
+        g.height                = boundsHeight - topMargin - bottomMargin;
+        if (rows > 0) g.cellHeight = g.height / static_cast<int32_t>(rows);
 
-        for (int32_t j = 0; j < static_cast<int32_t>(rowCount); j++)
+        return g;
+    }
+
+    std::optional<Grid::CellIndex> Grid::getCellAt(const BBox& bounds, const int32_t px, const int32_t py) const noexcept
+    {
+        const auto geometry = calculateGeometry(bounds);
+        if (geometry.cellWidth <= 0 || geometry.cellHeight <= 0) return std::nullopt;
+
+        const auto dx = px - geometry.x;
+        const auto dy = py - geometry.y;
+        if (dx < 0 || dy < 0) return std::nullopt;
+
+        const auto x = static_cast<size_t>(dx / geometry.cellWidth);
+        const auto y = static_cast<size_t>(dy / geometry.cellHeight);
+        if (x >= geometry.columnCount || y >= geometry.rowCount) return std::nullopt;
+
+        return CellIndex{.x = x, .y = y};
+    }
+
+    BBox Grid::getCellBounds(const BBox& bounds, const size_t x, const size_t y) const
+    {
+        const auto geometry = calculateGeometry(bounds);
+        if (x >= geometry.columnCount || y >= geometry.rowCount)
+            throw FloahError("Cannot get cell bounds. Index is out of range.");
+
+        BBox b;
+        calculateCellBounds(geometry, x, y, std::span(&b, 1));
+        return b;
+    }
+
+    void Grid::calculateCellBounds(const Geometry& geometry, const size_t x, const size_t y, std::span<BBox> bounds) noexcept
+    {
+        const auto y0 = geometry.y + geometry.cellHeight * static_cast<int32_t>(y);
+        const auto y1 = y0 + geometry.cellHeight;
+        const auto x0 = geometry.x + geometry.cellWidth * static_cast<int32_t>(x);
+
+        const auto count = static_cast<int32_t>(bounds.size());
+        for (int32_t i = 0; i < count; i++)
         {
-            for (int32_t i = 0; i < static_cast<int32_t>(columnCount); i++)
-            {
-                const auto& c = children[i + j * columnCount];
-                if (!c) continue;
+            bounds[i].x0 = x0 + geometry.cellWidth * i;
+            bounds[i].y0 = y0;
+            bounds[i].x1 = x0 + geometry.cellWidth * (i + 1);
+            bounds[i].y1 = y1;
+        }
+    }
 
-                // Calculate absolute size of child.
-                const auto cWidth  = c->getSize().getWidth().get(width) / static_cast<int32_t>(columnCount);
-                const auto cHeight = c->getSize().getHeight().get(height) / static_cast<int32_t>(rowCount);
+    ////////////////////////////////////////////////////////////////
+    // Setters.
+    ////////////////////////////////////////////////////////////////
 
-                BBox b;
+    void Grid::setHorizontalAlignment(const HorizontalAlignment alignment) noexcept { horAlign = alignment; }
 
-                const auto center = cellWidth * i + cellWidth / 2;
-                switch (horAlign)
-                {
-                // Align to left of grid cell.
-                case HorizontalAlignment::Left:
-                    b.x0 = x + cellWidth * i + c->getOuterMargin().getLeft().get(cellWidth);
-                    b.x1 = b.x0 + cWidth;
-                    break;
-                // Align around center of grid cell.
-                case HorizontalAlignment::Center:
-                    b.x0 = x + center - (cWidth + 1) / 2;  // Add 1 so odd widths are respected.
-                    b.x1 = x + center + cWidth / 2;
-                    break;
-                // Align to right of grid cell.
-                case HorizontalAlignment::Right:
-                    b.x1 = x + cellWidth * (i + 1) - c->getOuterMargin().getRight().get(cellWidth);
-                    b.x0 = b.x1 - cWidth;
-                    break;
-                }
+    void Grid::setVerticalAlignment(const VerticalAlignment alignment) noexcept { verAlign = alignment; }
 
-                const auto middle = cellHeight * j + cellHeight / 2;
-                switch (verAlign)
-                {
-                // Align to top of grid cell.
-                case VerticalAlignment::Top:
-                    b.y0 = y + cellHeight * j + c->getOuterMargin().getTop().get(cellHeight);
-                    b.y1 = b.y0 + cHeight;
-                    break;
-                // Align around middle of grid cell.
-                case VerticalAlignment::Middle:
-                    b.y0 = y + middle - (cHeight + 1) / 2;  // Add 1 so odd heights are respected.
-                    b.y1 = y + middle + cHeight / 2;
-                    break;
-                // Align to bottom of grid cell.
-                case VerticalAlignment::Bottom:
-                    b.y1 = y + cellHeight * (i + 1) - c->getOuterMargin().getBottom().get(cellHeight);
-                    b.y0 = b.y1 - cWidth;
-                    break;
-                }
+    ////////////////////////////////////////////////////////////////
+    // Generate.
+    ////////////////////////////////////////////////////////////////
 
-                blocks.emplace_back(c->getId(), b);
-            }
+    void Grid::countBlocks(size_t& count) const noexcept
+    {
+        count++;
+        for (const auto& c : children)
+        {
+            if (c) c->countBlocks(count);
         }
+    }
+
+    void Grid::layoutChildren(const BBox& bounds, const std::span<BBox> childBounds, LayoutScratch& scratch) const
+    {
+        // Spans are sorted in row-major order of their anchor cell, so walk them alongside the cells.
+        auto       nextSpan = spans.begin();
+        const auto spanAt   = [&](const size_t x, const size_t y) {
+            if (nextSpan == spans.end() || nextSpan->x != x || nextSpan->y != y) return CellSpan{};
+            const auto& span = *nextSpan++;
+            return CellSpan{.columns = span.columns, .rows = span.rows};
+        };
+        layoutGrid(*this, std::span<const LayoutElementPtr>(children), bounds, childBounds, scratch, spanAt);
+    }
+
+    void Grid::layoutNode(const SnapshotNode&     node,
+                          const SnapshotChildren& children,
+                          const BBox&             bounds,
+                          const std::span<BBox>   childBounds,
+                          LayoutScratch&          scratch)
+    {
+        // Nodes keep the span of their element, so the span of a cell is that of the node anchored there.
+        const auto columnCount = node.getColumnCount();
+        const auto spanAt      = [&](const size_t x, const size_t y) {
+            const auto* c = children[x + y * columnCount];
+            return c ? c->getCellSpan() : CellSpan{};
+        };
+        layoutGrid(node, children, bounds, childBounds, scratch, spanAt);
+    }
+
+    template<typename G, typename Children, typename SpanAt>
+    void Grid::layoutGrid(const G&              grid,
+                          const Children&       children,
+                          const BBox&           bounds,
+                          const std::span<BBox> childBounds,
+                          LayoutScratch&        scratch,
+                          SpanAt&&              spanAt)
+    {
+        if (children.empty()) return;
+
+        const auto columnCount = grid.getColumnCount();
+        const auto rowCount    = grid.getRowCount();
+        const auto horAlign    = grid.getHorizontalAlignment();
+        const auto verAlign    = grid.getVerticalAlignment();
+        const auto geometry    = calculateGeometry(grid.getInnerMargin(), columnCount, rowCount, bounds);
+        const auto width      = geometry.width;
+        const auto height     = geometry.height;
+        const auto cellWidth  = geometry.cellWidth;
+        const auto cellHeight = geometry.cellHeight;
+
+        // Place a child in a region of columns by rows cells.
+        const auto place = [&](const auto& c, const BBox& cell, const size_t columns, const size_t rows, BBox& b) {
+            const auto regionWidth  = cellWidth * static_cast<int32_t>(columns);
+            const auto regionHeight = cellHeight * static_cast<int32_t>(rows);
+
+            // Calculate absolute size of child.
+            const auto cWidth =
+              c.getSize().getWidth().get(width) * static_cast<int32_t>(columns) / static_cast<int32_t>(columnCount);
+            const auto cHeight =
+              c.getSize().getHeight().get(height) * static_cast<int32_t>(rows) / static_cast<int32_t>(rowCount);
+
+            const auto center = cell.x0 + regionWidth / 2;
+            switch (horAlign)
+            {
+            // Align to left of grid cell.
+            case HorizontalAlignment::Left:
+                b.x0 = cell.x0 + c.getOuterMargin().getLeft().get(regionWidth);
+                b.x1 = b.x0 + cWidth;
+                break;
+            // Align around center of grid cell.
+            case HorizontalAlignment::Center:
+                b.x0 = center - (cWidth + 1) / 2;  // Add 1 so odd widths are respected.
+                b.x1 = center + cWidth / 2;
+                break;
+            // Align to right of grid cell.
+            case HorizontalAlignment::Right:
+                b.x1 = cell.x1 - c.getOuterMargin().getRight().get(regionWidth);
+                b.x0 = b.x1 - cWidth;
+                break;
+            }
+
+            const auto middle = cell.y0 + regionHeight / 2;
+            switch (verAlign)
+            {
+            // Align to top of grid cell.
+            case VerticalAlignment::Top:
+                b.y0 = cell.y0 + c.getOuterMargin().getTop().get(regionHeight);
+                b.y1 = b.y0 + cHeight;
+                break;
+            // Align around middle of grid cell.
+            case VerticalAlignment::Middle:
+                b.y0 = middle - (cHeight + 1) / 2;  // Add 1 so odd heights are respected.
+                b.y1 = middle + cHeight / 2;
+                break;
+            // Align to bottom of grid cell.
+            case VerticalAlignment::Bottom:
+                b.y1 = cell.y1 - c.getOuterMargin().getBottom().get(regionHeight);
+                b.y0 = b.y1 - cHeight;
+                break;
+            }
+        };
 
-        size_t offset = 0;
+        // Calculate the bounds of all cells of a row at once, then place each child in the union of the cells it
+        // spans.
+        const auto cells = scratch.allocate<BBox>(columnCount);
         for (size_t j = 0; j < rowCount; j++)
         {
+            calculateCellBounds(geometry, 0, j, cells);
             for (size_t i = 0; i < columnCount; i++)
             {
-                const auto& c = children[i + j * columnCount];
+                const auto  index = i + j * columnCount;
+                const auto& c     = children[index];
+                const auto& cell  = cells[i];
+                const auto  span  = spanAt(i, j);
                 if (!c) continue;
 
-                c->generate(blocks, blocks[block.firstChild + offset++]);
+                const BBox region{.x0 = cell.x0,
+                                  .y0 = cell.y0,
+                                  .x1 = cell.x0 + cellWidth * static_cast<int32_t>(span.columns),
+                                  .y1 = cell.y0 + cellHeight * static_cast<int32_t>(span.rows)};
+                place(*c, region, span.columns, span.rows, childBounds[index]);
             }
         }
     }
@@ -196,30 +466,35 @@ namespace floah
 
     void Grid::prependColumn() { insertColumn(0); }
 
-    void Grid::insertRow(size_t y)
+    void Grid::insertRow(const size_t y) { insertRows(y, 1); }
+
+    void Grid::insertRows(size_t y, const size_t count)
     {
+        prepareStructureChange();
         y = std::min(rowCount, y);
-        rowCount++;
+        rowCount += count;
 
-        // Resize, resulting in empty row at end.
+        // Resize, resulting in empty rows at end.
         // 0 1 2 3
         // 4 5 6 7
         // - - - -
         children.resize(columnCount * rowCount);
 
         // 0 1 2 3
-        // - - - -  <-- Shift all rows with index >= y.
+        // - - - -  <-- Shift all rows with index >= y in a single pass.
         // 4 5 6 7
-        const auto shift = (rowCount - 1 - y) * columnCount;
-        for (size_t i = 0; i < shift; i++)
-        {
-            children[columnCount * rowCount - 1 - i] =
-              std::move(children[columnCount * rowCount - 1 - i - columnCount]);
-        }
+        const auto first = children.begin() + static_cast<ptrdiff_t>(y * columnCount);
+        const auto last  = children.begin() + static_cast<ptrdiff_t>((rowCount - count) * columnCount);
+        std::move_backward(first, last, children.end());
+
+        insertOccupancyRows(y, count);
+        invalidateStructure();
     }
 
-    void Grid::insertColumn(const size_t x)
+    void Grid::insertColumn(size_t x)
     {
+        prepareStructureChange();
+        x = std::min(columnCount, x);
         columnCount++;
         children.resize(rowCount * columnCount);
 
@@ -247,14 +522,20 @@ namespace floah
                 }
             }
         }
+
+        insertOccupancyColumn(x);
+        invalidateStructure();
     }
 
     void Grid::removeRow(const size_t y)
     {
         if (y >= rowCount) throw FloahError("Cannot remove row. Index is out of range.");
 
+        prepareStructureChange();
         if (rowCount > 0)
         {
+            removeOccupancyRow(y);
+            removeChildren(std::span(children).subspan(y * columnCount, columnCount));
             children.erase(children.begin() + y * columnCount, children.begin() + (y + 1) * columnCount);
             rowCount--;
         }
@@ -264,6 +545,13 @@ namespace floah
     {
         if (x >= columnCount) throw FloahError("Cannot remove column. Index is out of range.");
 
+        prepareStructureChange();
+        for (size_t j = 0; j < rowCount; j++)
+        {
+            if (const auto& c = children[x + j * columnCount]) removeChild(*c);
+        }
+
+        removeOccupancyColumn(x);
         columnCount--;
 
         for (size_t j = 0; j < rowCount; j++)
@@ -286,12 +574,16 @@ namespace floah
         }
 
         children.resize(rowCount * columnCount);
+        invalidateStructure();
     }
 
     std::vector<LayoutElementPtr> Grid::extractRow(const size_t y)
     {
         if (y >= rowCount) throw FloahError("Cannot extract row. Index is out of range.");
 
+        prepareStructureChange();
+        removeOccupancyRow(y);
+
         std::vector<LayoutElementPtr> elems;
         elems.reserve(columnCount);
 
@@ -300,10 +592,7 @@ namespace floah
 
         rowCount--;
 
-        for (auto& c : elems)
-        {
-            if (c) removeChild(*c);
-        }
+        removeChildren(elems);
 
         return elems;
     }
@@ -312,6 +601,9 @@ namespace floah
     {
         if (x >= columnCount) throw FloahError("Cannot extract column. Index is out of range.");
 
+        prepareStructureChange();
+        removeOccupancyColumn(x);
+
         std::vector<LayoutElementPtr> elems;
         elems.reserve(rowCount);
 
@@ -352,21 +644,46 @@ namespace floah
 
         children.resize(rowCount * columnCount);
 
-        for (auto& c : elems)
-        {
-            if (c) removeChild(*c);
-        }
+        removeChildren(elems);
 
         return elems;
     }
 
     void Grid::removeAllRowsAndColumns()
     {
+        prepareStructureChange();
+        removeChildren(children);
         children.clear();
+        spans.clear();
+        occupancy.clear();
         rowCount    = 0;
         columnCount = 0;
     }
 
+    ////////////////////////////////////////////////////////////////
+    // Memory.
+    ////////////////////////////////////////////////////////////////
+
+    void Grid::addMemoryUsage(MemoryUsage& usage) const
+    {
+        const auto bytes  = children.capacity() * sizeof(LayoutElementPtr) + spans.capacity() * sizeof(Span) +
+                            occupancy.capacity() * sizeof(uint64_t);
+        const auto wasted = (children.capacity() - children.size()) * sizeof(LayoutElementPtr) +
+                            (spans.capacity() - spans.size()) * sizeof(Span) +
+                            (occupancy.capacity() - occupancy.size()) * sizeof(uint64_t);
+        usage.addElement(typeid(*this).name(), sizeof(Grid) + bytes, wasted);
+        usage.gridSlotCount += children.size();
+        usage.nullGridSlotCount +=
+          static_cast<size_t>(std::ranges::count_if(children, [](const LayoutElementPtr& c) { return !c; }));
+    }
+
+    void Grid::shrinkToFit()
+    {
+        children.shrink_to_fit();
+        spans.shrink_to_fit();
+        occupancy.shrink_to_fit();
+    }
+
     ////////////////////////////////////////////////////////////////
     // Elements.
     ////////////////////////////////////////////////////////////////
@@ -382,24 +699,273 @@ namespace floah
     {
         if (x >= columnCount || y >= rowCount) throw FloahError("Cannot remove element. Index is out of range.");
 
-        children[x + y * columnCount].reset();
+        auto& elem = children[x + y * columnCount];
+        if (elem)
+        {
+            prepareStructureChange();
+            releaseCells(x, y);
+            removeChild(*elem);
+            elem.reset();
+        }
+    }
+
+    void Grid::fillRegion(
+      std::vector<LayoutElementPtr> elems, const size_t x, const size_t y, const size_t width, const size_t height)
+    {
+        if (x > columnCount || width > columnCount - x || y > rowCount || height > rowCount - y)
+            throw FloahError("Cannot fill region. Index is out of range.");
+        if (elems.size() != width * height) throw FloahError("Cannot fill region. Element count does not match region.");
+        for (const auto& span : spans)
+        {
+            const auto anchored = span.x >= x && span.x < x + width && span.y >= y && span.y < y + height;
+            const auto overlaps =
+              span.x < x + width && span.x + span.columns > x && span.y < y + height && span.y + span.rows > y;
+            if (overlaps && !anchored)
+                throw FloahError("Cannot fill region. Region overlaps an element anchored outside of it.");
+        }
+
+        prepareStructureChange();
+
+        // Free the cells of the elements that are replaced.
+        for (size_t j = y; j < y + height; j++)
+        {
+            for (size_t i = x; i < x + width; i++)
+            {
+                if (children[i + j * columnCount]) releaseCells(i, j);
+            }
+        }
+
+        // Swap the new elements into the region, leaving the replaced elements in their place in the list, so that
+        // the layout is notified once for the whole region.
+        makeChildren(elems);
+        for (size_t j = 0; j < height; j++)
+        {
+            for (size_t i = 0; i < width; i++)
+            {
+                auto& elem = elems[i + j * width];
+                if (elem) setRegionOccupied(x + i, y + j, 1, 1, true);
+                children[x + i + (y + j) * columnCount].swap(elem);
+            }
+        }
+        removeChildren(elems);
     }
 
     LayoutElementPtr Grid::extract(const size_t x, const size_t y)
     {
         if (x >= columnCount || y >= rowCount) throw FloahError("Cannot extract element. Index is out of range.");
 
-        auto elem = std::move(children[x + y * columnCount]);
-        if (elem) removeChild(*elem);
+        auto& slot = children[x + y * columnCount];
+        if (!slot) return nullptr;
+
+        prepareStructureChange();
+        auto elem = std::move(slot);
+        releaseCells(x, y);
+        removeChild(*elem);
         return elem;
     }
 
-    void Grid::insertImpl(LayoutElementPtr elem, const size_t x, const size_t y)
+    void Grid::insertImpl(LayoutElementPtr elem, const size_t x, const size_t y, const size_t columns, const size_t rows)
     {
-        if (x >= columnCount || y >= rowCount) throw FloahError("Cannot insert element. Index is out of range.");
+        if (x >= columnCount || y >= rowCount || columns == 0 || rows == 0 || columns > columnCount - x ||
+            rows > rowCount - y)
+            throw FloahError("Cannot insert element. Index is out of range.");
+
+        prepareStructureChange();
+
+        // The region may only overlap the element that is replaced.
+        auto&      slot    = children[x + y * columnCount];
+        const auto old     = findSpan(x, y);
+        const auto oldSpan = old == spans.end() ? Span{.x = x, .y = y} : *old;
+        if (slot) setRegionOccupied(oldSpan.x, oldSpan.y, oldSpan.columns, oldSpan.rows, false);
+        if (isRegionOccupied(x, y, columns, rows))
+        {
+            if (slot) setRegionOccupied(oldSpan.x, oldSpan.y, oldSpan.columns, oldSpan.rows, true);
+            throw FloahError("Cannot insert element. Region overlaps another element.");
+        }
+
+        if (old != spans.end()) spans.erase(old);
+        if (columns > 1 || rows > 1)
+        {
+            const auto pos = std::ranges::upper_bound(
+              spans, x + y * columnCount, {}, [this](const Span& span) { return span.x + span.y * columnCount; });
+            spans.insert(pos, Span{.x = x, .y = y, .columns = columns, .rows = rows});
+        }
+        setRegionOccupied(x, y, columns, rows, true);
+
+        if (slot) removeChild(*slot);
+        slot = std::move(elem);
+        makeChild(*slot);
+    }
 
-        makeChild(*elem);
-        children[x + y * columnCount] = std::move(elem);
+    ////////////////////////////////////////////////////////////////
+    // Occupancy.
+    ////////////////////////////////////////////////////////////////
+
+    std::vector<Grid::Span>::const_iterator Grid::findSpan(const size_t x, const size_t y) const noexcept
+    {
+        // Spans are sorted by the row-major index of their anchor.
+        const auto index = x + y * columnCount;
+        const auto it    = std::ranges::lower_bound(
+          spans, index, {}, [this](const Span& span) { return span.x + span.y * columnCount; });
+        return it != spans.end() && it->x == x && it->y == y ? it : spans.end();
     }
 
+    void Grid::releaseCells(const size_t x, const size_t y) noexcept
+    {
+        const auto it = findSpan(x, y);
+        if (it == spans.end())
+        {
+            setRegionOccupied(x, y, 1, 1, false);
+            return;
+        }
+
+        setRegionOccupied(it->x, it->y, it->columns, it->rows, false);
+        spans.erase(it);
+    }
+
+    size_t Grid::getOccupancyStride() const noexcept { return (columnCount + wordBits - 1) / wordBits; }
+
+    size_t Grid::findOccupied(const size_t x, const size_t y, const size_t count) const noexcept
+    {
+        const auto* row = occupancy.data() + y * getOccupancyStride();
+        for (auto i = x; i < x + count;)
+        {
+            const auto offset = i % wordBits;
+            const auto n      = std::min(wordBits - offset, x + count - i);
+            const auto bits   = row[i / wordBits] & maskBits(offset, n);
+            if (bits != 0) return i - offset + static_cast<size_t>(std::countr_zero(bits));
+            i += n;
+        }
+        return columnCount;
+    }
+
+    bool Grid::isRegionOccupied(const size_t x, const size_t y, const size_t columns, const size_t rows) const noexcept
+    {
+        for (auto j = y; j < y + rows; j++)
+        {
+            if (findOccupied(x, j, columns) != columnCount) return true;
+        }
+        return false;
+    }
+
+    void Grid::setRegionOccupied(
+      const size_t x, const size_t y, const size_t columns, const size_t rows, const bool value) noexcept
+    {
+        const auto stride = getOccupancyStride();
+        for (auto j = y; j < y + rows; j++)
+        {
+            auto* row = occupancy.data() + j * stride;
+            for (auto i = x; i < x + columns;)
+            {
+                const auto offset = i % wordBits;
+                const auto n      = std::min(wordBits - offset, x + columns - i);
+                const auto mask   = maskBits(offset, n);
+                if (value)
+                    row[i / wordBits] |= mask;
+                else
+                    row[i / wordBits] &= ~mask;
+                i += n;
+            }
+        }
+    }
+
+    void Grid::insertOccupancyRows(const size_t y, const size_t count)
+    {
+        const auto stride = getOccupancyStride();
+        occupancy.insert(occupancy.begin() + static_cast<ptrdiff_t>(y * stride), count * stride, 0);
+
+        for (auto& span : spans)
+        {
+            if (span.y >= y)
+                span.y += count;
+            else if (span.y + span.rows > y)
+            {
+                span.rows += count;
+                setRegionOccupied(span.x, y, span.columns, count, true);
+            }
+        }
+    }
+
+    void Grid::insertOccupancyColumn(const size_t x)
+    {
+        // Copy each row around the new column. The stride can change, so write to a new bitmap.
+        const auto            oldCount  = columnCount - 1;
+        const auto            oldStride = (oldCount + wordBits - 1) / wordBits;
+        const auto            stride    = getOccupancyStride();
+        std::vector<uint64_t> bits(rowCount * stride, 0);
+        for (size_t j = 0; j < rowCount; j++)
+        {
+            const auto* src = occupancy.data() + j * oldStride;
+            auto*       dst = bits.data() + j * stride;
+            copyBits(src, oldCount, 0, dst, 0, x);
+            copyBits(src, oldCount, x, dst, x + 1, oldCount - x);
+        }
+        occupancy = std::move(bits);
+
+        for (auto& span : spans)
+        {
+            if (span.x >= x)
+                span.x++;
+            else if (span.x + span.columns > x)
+            {
+                span.columns++;
+                setRegionOccupied(x, span.y, 1, span.rows, true);
+            }
+        }
+    }
+
+    void Grid::removeOccupancyRow(const size_t y) noexcept
+    {
+        // Spans anchored in the row are removed together with their element.
+        std::erase_if(spans, [&](const Span& span) {
+            if (span.y != y) return false;
+            setRegionOccupied(span.x, span.y, span.columns, span.rows, false);
+            return true;
+        });
+
+        const auto stride = getOccupancyStride();
+        occupancy.erase(occupancy.begin() + static_cast<ptrdiff_t>(y * stride),
+                        occupancy.begin() + static_cast<ptrdiff_t>((y + 1) * stride));
+
+        for (auto& span : spans)
+        {
+            if (span.y > y)
+                span.y--;
+            else if (span.y + span.rows > y)
+                span.rows--;
+        }
+        std::erase_if(spans, [](const Span& span) { return span.columns == 1 && span.rows == 1; });
+    }
+
+    void Grid::removeOccupancyColumn(const size_t x)
+    {
+        // Spans anchored in the column are removed together with their element.
+        std::erase_if(spans, [&](const Span& span) {
+            if (span.x != x) return false;
+            setRegionOccupied(span.x, span.y, span.columns, span.rows, false);
+            return true;
+        });
+
+        // Copy each row around the removed column. The stride can change, so write to a new bitmap.
+        const auto            oldStride = getOccupancyStride();
+        const auto            stride    = (columnCount - 1 + wordBits - 1) / wordBits;
+        std::vector<uint64_t> bits(rowCount * stride, 0);
+        for (size_t j = 0; j < rowCount; j++)
+        {
+            const auto* src = occupancy.data() + j * oldStride;
+            auto*       dst = bits.data() + j * stride;
+            copyBits(src, columnCount, 0, dst, 0, x);
+            copyBits(src, columnCount, x + 1, dst, x, columnCount - x - 1);
+        }
+        occupancy = std::move(bits);
+
+        for (auto& span : spans)
+        {
+            if (span.x > x)
+                span.x--;
+            else if (span.x + span.columns > x)
+                span.columns--;
+        }
+        std::erase_if(spans, [](const Span& span) { return span.columns == 1 && span.rows == 1; });
+    }
 }  // namespace floah
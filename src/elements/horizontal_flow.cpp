@@ -1,13 +1,129 @@
 #include "floah-layout/elements/horizontal_flow.h"
 
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <iterator>
+#include <typeinfo>
+#include <utility>
+
 ////////////////////////////////////////////////////////////////
 // Current target includes.
 ////////////////////////////////////////////////////////////////
 
 #include "floah-common/floah_error.h"
+#include "../flex_solver.h"
+#include "../hash.h"
+#include "../snapshot_node.h"
 
 namespace floah
 {
+    namespace
+    {
+        /**
+         * \brief Lay out the children of a HorizontalFlow or of a snapshot node captured from one.
+         * \tparam Flow HorizontalFlow or SnapshotNode.
+         * \tparam Children List of children (see FlexSolver::solve).
+         */
+        template<typename Flow, typename Children>
+        void layoutFlow(const Flow&           flow,
+                        const Children&       children,
+                        const BBox&           bounds,
+                        const std::span<BBox> childBounds,
+                        LayoutScratch&        scratch)
+        {
+            if (children.empty()) return;
+
+            const auto& innerMargin = flow.getInnerMargin();
+            const auto  horAlign    = flow.getHorizontalAlignment();
+            const auto  verAlign    = flow.getVerticalAlignment();
+
+            // Total width is bounds.width minus left and right margin.
+            const auto boundsWidth = bounds.width();
+            const auto leftMargin  = innerMargin.getLeft().get(boundsWidth);
+            const auto rightMargin = innerMargin.getRight().get(boundsWidth);
+            const auto width       = boundsWidth - leftMargin - rightMargin;
+
+            // Total height is bounds.height minus top and bottom margin.
+            const auto boundsHeight = bounds.height();
+            const auto topMargin    = innerMargin.getTop().get(boundsHeight);
+            const auto bottomMargin = innerMargin.getBottom().get(boundsHeight);
+            const auto height       = boundsHeight - topMargin - bottomMargin;
+
+            // Start at left or right of bounds.
+            int32_t x = 0;
+            switch (horAlign)
+            {
+            // Center is rejected by setHorizontalAlignment, so there is nothing to validate here.
+            case HorizontalAlignment::Center:
+            case HorizontalAlignment::Left: x = bounds.x0 + leftMargin; break;
+            case HorizontalAlignment::Right: x = bounds.x1 - rightMargin;
+            }
+
+            // Offset from top or bottom of bounds, or center around horizontal axis.
+            int32_t y = 0;
+            switch (verAlign)
+            {
+            case VerticalAlignment::Top: y = bounds.y0 + topMargin; break;
+            // Round down (also for negative heights), so that the result does not depend on the position of the bounds.
+            case VerticalAlignment::Middle: y = bounds.y0 + topMargin + (height >> 1); break;
+            case VerticalAlignment::Bottom: y = bounds.y1 - bottomMargin;
+            }
+
+            // Resolve sizes of children with a flex weight.
+            const auto flexSizes = FlexSolver::solve(children, true, width, scratch);
+
+            for (size_t i = 0; i < children.size(); i++)
+            {
+                const auto& c = children[i];
+                auto&       b = childBounds[i];
+
+                // Calculate absolute size of child.
+                const auto cWidth  = !flexSizes.empty() ? flexSizes[i] : c->getSize().getWidth().get(width);
+                const auto cHeight = c->getSize().getHeight().get(height);
+
+                switch (horAlign)
+                {
+                // Append to right of elements and move x further right.
+                case HorizontalAlignment::Left:
+                    b.x0 = x + c->getOuterMargin().getLeft().get(width);
+                    b.x1 = b.x0 + cWidth;
+                    x    = b.x1 + c->getOuterMargin().getRight().get(width);
+                    break;
+                case HorizontalAlignment::Center: break;
+                // Append to left of elements and move x further left.
+                case HorizontalAlignment::Right:
+                    b.x1 = x - c->getOuterMargin().getRight().get(width);
+                    b.x0 = b.x1 - cWidth;
+                    x    = b.x0 - c->getOuterMargin().getLeft().get(width);
+                    break;
+                }
+
+                switch (verAlign)
+                {
+                // Offset from top of parent.
+                case VerticalAlignment::Top:
+                    b.y0 = y + c->getOuterMargin().getTop().get(height);
+                    b.y1 = b.y0 + cHeight;
+                    break;
+                // Center around middle of parent.
+                case VerticalAlignment::Middle:
+                    b.y0 = y - (cHeight + 1) / 2;  // Add 1 so odd heights are respected.
+                    b.y1 = y + cHeight / 2;
+                    break;
+                // Offset from bottom of parent.
+                case VerticalAlignment::Bottom:
+                    b.y1 = y - c->getOuterMargin().getBottom().get(height);
+                    b.y0 = b.y1 - cHeight;
+                    break;
+                }
+
+            }
+        }
+    }  // namespace
+
     ////////////////////////////////////////////////////////////////
     // Constructors.
     ////////////////////////////////////////////////////////////////
@@ -19,6 +135,17 @@ namespace floah
     {
     }
 
+    HorizontalFlow::HorizontalFlow(HorizontalFlow&& other) noexcept :
+        LayoutElement(std::move(other)),
+        horAlign(other.horAlign),
+        verAlign(other.verAlign),
+        children(std::move(other.children))
+    {
+        other.children.clear();
+        other.invalidateStructure();
+        reparentChildren();
+    }
+
     HorizontalFlow::~HorizontalFlow() noexcept = default;
 
     HorizontalFlow& HorizontalFlow::operator=(const HorizontalFlow& other)
@@ -29,6 +156,20 @@ namespace floah
         return *this;
     }
 
+    HorizontalFlow& HorizontalFlow::operator=(HorizontalFlow&& other) noexcept
+    {
+        if (this == &other) return *this;
+        LayoutElement::operator=(std::move(other));
+        horAlign = other.horAlign;
+        verAlign = other.verAlign;
+        children = std::move(other.children);
+        other.children.clear();
+        other.invalidateStructure();
+        reparentChildren();
+        invalidateStructure();
+        return *this;
+    }
+
     LayoutElementPtr HorizontalFlow::clone(Layout* l, LayoutElement* p) const
     {
         auto elem = std::make_unique<HorizontalFlow>(*this);
@@ -50,16 +191,38 @@ namespace floah
 
     size_t HorizontalFlow::getChildCount() const noexcept { return children.size(); }
 
-    ////////////////////////////////////////////////////////////////
-    // Setters.
-    ////////////////////////////////////////////////////////////////
+    bool HorizontalFlow::isLayoutEqual(const LayoutElement& other) const noexcept
+    {
+        if (!LayoutElement::isLayoutEqual(other)) return false;
+        const auto& o = static_cast<const HorizontalFlow&>(other);
+        return horAlign == o.horAlign && verAlign == o.verAlign;
+    }
+
+    uint64_t HorizontalFlow::getLayoutHash() const noexcept
+    {
+        auto h = LayoutElement::getLayoutHash();
+        hashCombine(h, static_cast<uint64_t>(horAlign));
+        hashCombine(h, static_cast<uint64_t>(verAlign));
+        return h;
+    }
+
+    std::span<const LayoutElementPtr> HorizontalFlow::getChildren() const noexcept { return children; }
 
-    void HorizontalFlow::setLayout(Layout* l) noexcept
+    std::span<LayoutElementPtr> HorizontalFlow::getChildSlots() noexcept { return children; }
+
+    bool HorizontalFlow::swapChildren(LayoutElement& other) noexcept
     {
-        LayoutElement::setLayout(l);
-        for (auto& c : children) LayoutElement::setLayout(l, *c);
+        auto& flow = static_cast<HorizontalFlow&>(other);
+        children.swap(flow.children);
+        reparentChildren();
+        flow.reparentChildren();
+        return true;
     }
 
+    ////////////////////////////////////////////////////////////////
+    // Setters.
+    ////////////////////////////////////////////////////////////////
+
     void HorizontalFlow::setHorizontalAlignment(const HorizontalAlignment alignment)
     {
         if (alignment == HorizontalAlignment::Center)
@@ -79,96 +242,35 @@ namespace floah
         for (const auto& c : children) c->countBlocks(count);
     }
 
-    void HorizontalFlow::generate(std::vector<Block>& blocks, Block& block) const
+    void HorizontalFlow::layoutChildren(const BBox&           bounds,
+                                        const std::span<BBox> childBounds,
+                                        LayoutScratch&        scratch) const
     {
-        if (children.empty()) return;
-
-        block.firstChild = blocks.size();
-        block.childCount = children.size();
-
-        const auto& bounds = block.bounds;
-
-        // Total width is bounds.width minus left and right margin.
-        const auto boundsWidth = bounds.width();
-        const auto leftMargin  = innerMargin.getLeft().get(boundsWidth);
-        const auto rightMargin = innerMargin.getRight().get(boundsWidth);
-        const auto width       = boundsWidth - leftMargin - rightMargin;
-
-        // Total height is bounds.height minus top and bottom margin.
-        const auto boundsHeight = bounds.height();
-        const auto topMargin    = innerMargin.getTop().get(boundsHeight);
-        const auto bottomMargin = innerMargin.getBottom().get(boundsHeight);
-        const auto height       = boundsHeight - topMargin - bottomMargin;
-
-        // Start at left or right of bounds.
-        int32_t x = 0;
-        switch (horAlign)
-        {
-        case HorizontalAlignment::Left: x = bounds.x0 + leftMargin; break;
-        case HorizontalAlignment::Center:
-            throw FloahError("Cannot generate. Center not supported for horizontal alignment.");
-        case HorizontalAlignment::Right: x = bounds.x1 - rightMargin;
-        }
-
-        // Offset from top or bottom of bounds, or center around horizontal axis.
-        int32_t y = 0;
-        switch (verAlign)
-        {
-        case VerticalAlignment::Top: y = bounds.y0 + topMargin; break;
-        case VerticalAlignment::Middle: y = (bounds.y0 + topMargin + bounds.y1 - bottomMargin) / 2; break;
-        case VerticalAlignment::Bottom: y = bounds.y1 - bottomMargin;
-        }
-
-        for (const auto& c : children)
-        {
-            // Calculate absolute size of child.
-            const auto cWidth  = c->getSize().getWidth().get(width);
-            const auto cHeight = c->getSize().getHeight().get(height);
-
-            BBox b;
-
-            switch (horAlign)
-            {
-            // Append to right of elements and move x further right.
-            case HorizontalAlignment::Left:
-                b.x0 = x + c->getOuterMargin().getLeft().get(width);
-                b.x1 = b.x0 + cWidth;
-                x    = b.x1 + c->getOuterMargin().getRight().get(width);
-                break;
-            case HorizontalAlignment::Center: break;
-            // Append to left of elements and move x further left.
-            case HorizontalAlignment::Right:
-                b.x1 = x - c->getOuterMargin().getRight().get(width);
-                b.x0 = b.x1 - cWidth;
-                x    = b.x0 - c->getOuterMargin().getLeft().get(width);
-                break;
-            }
+        layoutFlow(*this, std::span<const LayoutElementPtr>(children), bounds, childBounds, scratch);
+    }
 
-            switch (verAlign)
-            {
-            // Offset from top of parent.
-            case VerticalAlignment::Top:
-                b.y0 = y + c->getOuterMargin().getTop().get(height);
-                b.y1 = b.y0 + cHeight;
-                break;
-            // Center around middle of parent.
-            case VerticalAlignment::Middle:
-                b.y0 = y - (cHeight + 1) / 2;  // Add 1 so odd heights are respected.
-                b.y1 = y + cHeight / 2;
-                break;
-            // Offset from bottom of parent.
-            case VerticalAlignment::Bottom:
-                b.y1 = y - c->getOuterMargin().getBottom().get(height);
-                b.y0 = b.y0 - cHeight;
-                break;
-            }
+    void HorizontalFlow::layoutNode(const SnapshotNode&     node,
+                                    const SnapshotChildren& children,
+                                    const BBox&             bounds,
+                                    const std::span<BBox>   childBounds,
+                                    LayoutScratch&          scratch)
+    {
+        layoutFlow(node, children, bounds, childBounds, scratch);
+    }
 
-            blocks.emplace_back(c->getId(), b);
-        }
+    ////////////////////////////////////////////////////////////////
+    // Memory.
+    ////////////////////////////////////////////////////////////////
 
-        for (size_t i = 0; i < children.size(); i++) { children[i]->generate(blocks, blocks[block.firstChild + i]); }
+    void HorizontalFlow::addMemoryUsage(MemoryUsage& usage) const
+    {
+        const auto bytes  = children.capacity() * sizeof(LayoutElementPtr);
+        const auto wasted = (children.capacity() - children.size()) * sizeof(LayoutElementPtr);
+        usage.addElement(typeid(*this).name(), sizeof(HorizontalFlow) + bytes, wasted);
     }
 
+    void HorizontalFlow::shrinkToFit() { children.shrink_to_fit(); }
+
     ////////////////////////////////////////////////////////////////
     // Elements.
     ////////////////////////////////////////////////////////////////
@@ -184,6 +286,8 @@ namespace floah
     {
         if (index >= children.size()) throw FloahError("Cannot remove element. Index is out of range.");
 
+        prepareStructureChange();
+        removeChild(*children[index]);
         children.erase(children.begin() + index);
     }
 
@@ -191,23 +295,60 @@ namespace floah
     {
         if (index >= children.size()) throw FloahError("Cannot extract element. Index is out of range.");
 
+        prepareStructureChange();
         auto elem = std::move(children[index]);
         children.erase(children.begin() + index);
         removeChild(*elem);
         return elem;
     }
 
+    void HorizontalFlow::appendRange(std::vector<LayoutElementPtr> elems)
+    {
+        insertRange(std::move(elems), children.size());
+    }
+
+    void HorizontalFlow::insertRange(std::vector<LayoutElementPtr> elems, const size_t index)
+    {
+        for (const auto& elem : elems)
+        {
+            if (!elem) throw FloahError("Cannot insert elements. Element is nullptr.");
+        }
+
+        prepareStructureChange();
+        const auto first = children.insert(children.begin() + std::min(children.size(), index),
+                                           std::make_move_iterator(elems.begin()),
+                                           std::make_move_iterator(elems.end()));
+        makeChildren(std::span(first, elems.size()));
+    }
+
+    void HorizontalFlow::reserve(const size_t count) { children.reserve(count); }
+
+    std::vector<LayoutElementPtr> HorizontalFlow::extractRange(const size_t index, const size_t count)
+    {
+        if (index > children.size() || count > children.size() - index)
+            throw FloahError("Cannot extract elements. Index is out of range.");
+
+        prepareStructureChange();
+        const auto                    first = children.begin() + index;
+        std::vector<LayoutElementPtr> elems(std::make_move_iterator(first), std::make_move_iterator(first + count));
+        children.erase(first, first + count);
+        removeChildren(elems);
+        return elems;
+    }
+
     void HorizontalFlow::appendImpl(LayoutElementPtr elem)
     {
-        makeChild(*elem);
+        prepareStructureChange();
         children.push_back(std::move(elem));
+        makeChild(*children.back());
     }
 
     void HorizontalFlow::prependImpl(LayoutElementPtr elem) { insertImpl(std::move(elem), 0); }
 
     void HorizontalFlow::insertImpl(LayoutElementPtr elem, const size_t index)
     {
-        makeChild(*elem);
-        children.insert(children.begin() + std::min(children.size(), index), std::move(elem));
+        prepareStructureChange();
+        const auto it = children.insert(children.begin() + std::min(children.size(), index), std::move(elem));
+        makeChild(**it);
     }
 }  // namespace floah
@@ -0,0 +1,316 @@
+#include "floah-layout/elements/scroll_view.h"
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-common/floah_error.h"
+#include "../compare.h"
+#include "../hash.h"
+#include "../snapshot_node.h"
+
+namespace floah
+{
+    ////////////////////////////////////////////////////////////////
+    // Constructors.
+    ////////////////////////////////////////////////////////////////
+
+    ScrollView::ScrollView() = default;
+
+    ScrollView::ScrollView(const ScrollView& other) :
+        LayoutElement(other), contentSize(other.contentSize), scrollX(other.scrollX), scrollY(other.scrollY)
+    {
+    }
+
+    ScrollView::ScrollView(ScrollView&& other) noexcept :
+        LayoutElement(std::move(other)),
+        contentSize(other.contentSize),
+        scrollX(other.scrollX),
+        scrollY(other.scrollY),
+        content(std::move(other.content))
+    {
+        other.invalidateStructure();
+        reparentChildren();
+    }
+
+    ScrollView::~ScrollView() noexcept = default;
+
+    ScrollView& ScrollView::operator=(const ScrollView& other)
+    {
+        LayoutElement::operator=(other);
+        contentSize = other.contentSize;
+        scrollX     = other.scrollX;
+        scrollY     = other.scrollY;
+        return *this;
+    }
+
+    ScrollView& ScrollView::operator=(ScrollView&& other) noexcept
+    {
+        if (this == &other) return *this;
+        LayoutElement::operator=(std::move(other));
+        contentSize = other.contentSize;
+        scrollX     = other.scrollX;
+        scrollY     = other.scrollY;
+        content     = std::move(other.content);
+        other.invalidateStructure();
+        reparentChildren();
+        invalidateStructure();
+        return *this;
+    }
+
+    LayoutElementPtr ScrollView::clone(Layout* l, LayoutElement* p) const
+    {
+        auto elem = std::make_unique<ScrollView>(*this);
+        elem->cloneImpl(l, p);
+
+        if (content) elem->content = content->clone(l, elem.get());
+
+        return elem;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Getters.
+    ////////////////////////////////////////////////////////////////
+
+    Size& ScrollView::getContentSize() noexcept { return contentSize; }
+
+    const Size& ScrollView::getContentSize() const noexcept { return contentSize; }
+
+    int32_t ScrollView::getScrollX() const noexcept { return scrollX; }
+
+    int32_t ScrollView::getScrollY() const noexcept { return scrollY; }
+
+    LayoutElement* ScrollView::getContent() const noexcept { return content.get(); }
+
+    bool ScrollView::isLayoutEqual(const LayoutElement& other) const noexcept
+    {
+        if (!LayoutElement::isLayoutEqual(other)) return false;
+        const auto& o = static_cast<const ScrollView&>(other);
+        return isEqual(contentSize, o.contentSize) && scrollX == o.scrollX && scrollY == o.scrollY;
+    }
+
+    uint64_t ScrollView::getLayoutHash() const noexcept
+    {
+        auto h = LayoutElement::getLayoutHash();
+        hashCombine(h, contentSize);
+        hashCombine(h, static_cast<uint32_t>(scrollX));
+        hashCombine(h, static_cast<uint32_t>(scrollY));
+        return h;
+    }
+
+    std::span<const LayoutElementPtr> ScrollView::getChildren() const noexcept
+    {
+        return {&content, content ? size_t{1} : size_t{0}};
+    }
+
+    std::span<LayoutElementPtr> ScrollView::getChildSlots() noexcept
+    {
+        return {&content, content ? size_t{1} : size_t{0}};
+    }
+
+    bool ScrollView::swapChildren(LayoutElement& other) noexcept
+    {
+        auto& view = static_cast<ScrollView&>(other);
+        content.swap(view.content);
+        reparentChildren();
+        view.reparentChildren();
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Setters.
+    ////////////////////////////////////////////////////////////////
+
+    void ScrollView::setScrollOffset(const int32_t x, const int32_t y) noexcept
+    {
+        scrollX = x;
+        scrollY = y;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Generate.
+    ////////////////////////////////////////////////////////////////
+
+    void ScrollView::countBlocks(size_t& count) const noexcept
+    {
+        count++;
+        if (content) content->countBlocks(count);
+    }
+
+    void ScrollView::layoutChildren(const BBox& bounds, const std::span<BBox> childBounds, LayoutScratch&) const
+    {
+        if (!content) return;
+
+        const auto area = calculateContentArea(contentSize, calculateViewport(innerMargin, bounds), scrollX, scrollY);
+        placeContent(*content, area, childBounds[0]);
+    }
+
+    bool ScrollView::getContentClip(const BBox& bounds, BBox& clip) const noexcept
+    {
+        clip = calculateViewport(innerMargin, bounds);
+        return true;
+    }
+
+    void ScrollView::layoutNode(const SnapshotNode&     node,
+                                const SnapshotChildren& children,
+                                const BBox&             bounds,
+                                const std::span<BBox>   childBounds)
+    {
+        if (children.empty() || !children[0]) return;
+
+        const auto viewport = calculateViewport(node.getInnerMargin(), bounds);
+        const auto area = calculateContentArea(node.getContentSize(), viewport, node.getScrollX(), node.getScrollY());
+        placeContent(*children[0], area, childBounds[0]);
+    }
+
+    template<typename T>
+    void ScrollView::placeContent(const T& content, const BBox& area, BBox& b) noexcept
+    {
+        const auto width  = area.width();
+        const auto height = area.height();
+
+        // Place content at top-left of content area.
+        b.x0 = area.x0 + content.getOuterMargin().getLeft().get(width);
+        b.y0 = area.y0 + content.getOuterMargin().getTop().get(height);
+        b.x1 = b.x0 + content.getSize().getWidth().get(width);
+        b.y1 = b.y0 + content.getSize().getHeight().get(height);
+    }
+
+    void ScrollView::scroll(const std::span<Block> blocks,
+                            const size_t           index,
+                            const int32_t          x,
+                            const int32_t          y,
+                            const CoordinateMode   coordinates,
+                            const bool             cull)
+    {
+        if (index >= blocks.size()) throw FloahError("Cannot scroll. Index is out of range.");
+
+        // Work in coordinates relative to the top-left of this element, which is also the origin of the content block
+        // in CoordinateMode::ParentRelative.
+        const auto& block    = blocks[index];
+        const auto  origin   = BBox{.x0 = 0, .y0 = 0, .x1 = block.bounds.width(), .y1 = block.bounds.height()};
+        const auto  viewport = calculateViewport(innerMargin, origin);
+        const auto  oldArea  = calculateContentArea(contentSize, viewport, scrollX, scrollY);
+        const auto  newArea  = calculateContentArea(contentSize, viewport, x, y);
+        const auto  dx       = newArea.x0 - oldArea.x0;
+        const auto  dy       = newArea.y0 - oldArea.y0;
+
+        // Validate before modifying anything, so that a failed call leaves the offset and the blocks unchanged.
+        const auto first = index + 1;
+        const auto last  = block.subtreeEnd;
+        if (block.childCount != 0 && (last <= first || last > blocks.size() || blocks[first].parent != index))
+            throw FloahError("Cannot scroll. Blocks were not generated in depth-first order.");
+
+        setScrollOffset(x, y);
+        if (block.childCount == 0) return;
+
+        const auto isAbsolute = coordinates == CoordinateMode::Absolute;
+        translateBlocks(blocks.subspan(first, isAbsolute ? last - first : 1), dx, dy);
+        if (!cull) return;
+
+        // Origin of this element in the coordinates of the blocks.
+        const auto ox = isAbsolute ? block.bounds.x0 : 0;
+        const auto oy = isAbsolute ? block.bounds.y0 : 0;
+
+        // In relative mode, keep track of the origins of all ancestors between this element and the current block.
+        struct Ancestor
+        {
+            size_t  end;
+            int32_t x;
+            int32_t y;
+        };
+        std::vector<Ancestor> ancestors;
+
+        for (auto i = first; i < last;)
+        {
+            auto& b = blocks[i];
+            while (!ancestors.empty() && ancestors.back().end <= i) ancestors.pop_back();
+            const auto px = isAbsolute ? -ox : ancestors.empty() ? 0 : ancestors.back().x;
+            const auto py = isAbsolute ? -oy : ancestors.empty() ? 0 : ancestors.back().y;
+
+            // Bounds relative to this element.
+            const auto x0 = b.bounds.x0 + px;
+            const auto y0 = b.bounds.y0 + py;
+            const auto x1 = b.bounds.x1 + px;
+            const auto y1 = b.bounds.y1 + py;
+            if (x0 < viewport.x1 && x1 > viewport.x0 && y0 < viewport.y1 && y1 > viewport.y0)
+                b.flags &= ~BlockFlags::Clipped;
+            else
+                b.flags |= BlockFlags::Clipped;
+
+            // Descendants of nested clipping elements keep their flags.
+            if (any(b.flags, BlockFlags::ClipsContent))
+            {
+                i = std::max(b.subtreeEnd, i + 1);
+                continue;
+            }
+
+            if (!isAbsolute && b.childCount > 0) ancestors.push_back(Ancestor{.end = b.subtreeEnd, .x = x0, .y = y0});
+            i++;
+        }
+    }
+
+    BBox ScrollView::calculateViewport(const Margin& innerMargin, const BBox& bounds) noexcept
+    {
+        const auto boundsWidth  = bounds.width();
+        const auto boundsHeight = bounds.height();
+        return BBox{.x0 = bounds.x0 + innerMargin.getLeft().get(boundsWidth),
+                    .y0 = bounds.y0 + innerMargin.getTop().get(boundsHeight),
+                    .x1 = bounds.x1 - innerMargin.getRight().get(boundsWidth),
+                    .y1 = bounds.y1 - innerMargin.getBottom().get(boundsHeight)};
+    }
+
+    BBox ScrollView::calculateContentArea(const Size&   contentSize,
+                                          const BBox&   viewport,
+                                          const int32_t x,
+                                          const int32_t y) noexcept
+    {
+        const auto viewportWidth  = viewport.width();
+        const auto viewportHeight = viewport.height();
+        const auto width          = contentSize.getWidth().get(viewportWidth);
+        const auto height         = contentSize.getHeight().get(viewportHeight);
+
+        // Keep viewport inside of content area. If the content is smaller than the viewport, it is not scrolled.
+        const auto cx = std::clamp(x, 0, std::max(0, width - viewportWidth));
+        const auto cy = std::clamp(y, 0, std::max(0, height - viewportHeight));
+        return BBox{.x0 = viewport.x0 - cx, .y0 = viewport.y0 - cy, .x1 = viewport.x0 - cx + width, .y1 = viewport.y0 - cy + height};
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Memory.
+    ////////////////////////////////////////////////////////////////
+
+    void ScrollView::addMemoryUsage(MemoryUsage& usage) const
+    {
+        usage.addElement(typeid(*this).name(), sizeof(ScrollView), 0);
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Elements.
+    ////////////////////////////////////////////////////////////////
+
+    LayoutElementPtr ScrollView::extractContent()
+    {
+        if (content) prepareStructureChange();
+        auto elem = std::move(content);
+        if (elem) removeChild(*elem);
+        return elem;
+    }
+
+    void ScrollView::setContentImpl(LayoutElementPtr elem)
+    {
+        prepareStructureChange();
+        if (content) removeChild(*content);
+        content = std::move(elem);
+        makeChild(*content);
+    }
+}  // namespace floah
@@ -1,13 +1,129 @@
 #include "floah-layout/elements/vertical_flow.h"
 
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <iterator>
+#include <typeinfo>
+#include <utility>
+
 ////////////////////////////////////////////////////////////////
 // Current target includes.
 ////////////////////////////////////////////////////////////////
 
 #include "floah-common/floah_error.h"
+#include "../flex_solver.h"
+#include "../hash.h"
+#include "../snapshot_node.h"
 
 namespace floah
 {
+    namespace
+    {
+        /**
+         * \brief Lay out the children of a VerticalFlow or of a snapshot node captured from one.
+         * \tparam Flow VerticalFlow or SnapshotNode.
+         * \tparam Children List of children (see FlexSolver::solve).
+         */
+        template<typename Flow, typename Children>
+        void layoutFlow(const Flow&           flow,
+                        const Children&       children,
+                        const BBox&           bounds,
+                        const std::span<BBox> childBounds,
+                        LayoutScratch&        scratch)
+        {
+            if (children.empty()) return;
+
+            const auto& innerMargin = flow.getInnerMargin();
+            const auto  horAlign    = flow.getHorizontalAlignment();
+            const auto  verAlign    = flow.getVerticalAlignment();
+
+            // Total width is bounds.width minus left and right margin.
+            const auto boundsWidth = bounds.width();
+            const auto leftMargin  = innerMargin.getLeft().get(boundsWidth);
+            const auto rightMargin = innerMargin.getRight().get(boundsWidth);
+            const auto width       = boundsWidth - leftMargin - rightMargin;
+
+            // Total height is bounds.height minus top and bottom margin.
+            const auto boundsHeight = bounds.height();
+            const auto topMargin    = innerMargin.getTop().get(boundsHeight);
+            const auto bottomMargin = innerMargin.getBottom().get(boundsHeight);
+            const auto height       = boundsHeight - topMargin - bottomMargin;
+
+            // Start at top or bottom of bounds.
+            int32_t y = 0;
+            switch (verAlign)
+            {
+            // Middle is rejected by setVerticalAlignment, so there is nothing to validate here.
+            case VerticalAlignment::Middle:
+            case VerticalAlignment::Top: y = bounds.y0 + topMargin; break;
+            case VerticalAlignment::Bottom: y = bounds.y1 - bottomMargin;
+            }
+
+            // Offset from left or right of bounds, or center around vertical axis.
+            int32_t x = 0;
+            switch (horAlign)
+            {
+            case HorizontalAlignment::Left: x = bounds.x0 + leftMargin; break;
+            // Round down (also for negative widths), so that the result does not depend on the position of the bounds.
+            case HorizontalAlignment::Center: x = bounds.x0 + leftMargin + (width >> 1); break;
+            case HorizontalAlignment::Right: x = bounds.x1 - rightMargin;
+            }
+
+            // Resolve sizes of children with a flex weight.
+            const auto flexSizes = FlexSolver::solve(children, false, height, scratch);
+
+            for (size_t i = 0; i < children.size(); i++)
+            {
+                const auto& c = children[i];
+                auto&       b = childBounds[i];
+
+                // Calculate absolute size of child.
+                const auto cWidth  = c->getSize().getWidth().get(width);
+                const auto cHeight = !flexSizes.empty() ? flexSizes[i] : c->getSize().getHeight().get(height);
+
+                switch (verAlign)
+                {
+                // Append to bottom of elements and move y further down.
+                case VerticalAlignment::Top:
+                    b.y0 = y + c->getOuterMargin().getTop().get(height);
+                    b.y1 = b.y0 + cHeight;
+                    y    = b.y1 + c->getOuterMargin().getBottom().get(height);
+                    break;
+                case VerticalAlignment::Middle: break;
+                // Append to top of elements and move y further up.
+                case VerticalAlignment::Bottom:
+                    b.y1 = y - c->getOuterMargin().getBottom().get(height);
+                    b.y0 = b.y1 - cHeight;
+                    y    = b.y0 - c->getOuterMargin().getTop().get(height);
+                    break;
+                }
+
+                switch (horAlign)
+                {
+                // Offset from left of parent.
+                case HorizontalAlignment::Left:
+                    b.x0 = x + c->getOuterMargin().getLeft().get(width);
+                    b.x1 = b.x0 + cWidth;
+                    break;
+                // Center around middle of parent.
+                case HorizontalAlignment::Center:
+                    b.x0 = x - (cWidth + 1) / 2;  // Add 1 so odd widths are respected.
+                    b.x1 = x + cWidth / 2;
+                    break;
+                // Offset from right of parent.
+                case HorizontalAlignment::Right:
+                    b.x1 = x - c->getOuterMargin().getRight().get(width);
+                    b.x0 = b.x1 - cWidth;
+                    break;
+                }
+
+            }
+        }
+    }  // namespace
+
     ////////////////////////////////////////////////////////////////
     // Constructors.
     ////////////////////////////////////////////////////////////////
@@ -19,6 +135,17 @@ namespace floah
     {
     }
 
+    VerticalFlow::VerticalFlow(VerticalFlow&& other) noexcept :
+        LayoutElement(std::move(other)),
+        horAlign(other.horAlign),
+        verAlign(other.verAlign),
+        children(std::move(other.children))
+    {
+        other.children.clear();
+        other.invalidateStructure();
+        reparentChildren();
+    }
+
     VerticalFlow::~VerticalFlow() noexcept = default;
 
     VerticalFlow& VerticalFlow::operator=(const VerticalFlow& other)
@@ -29,6 +156,20 @@ namespace floah
         return *this;
     }
 
+    VerticalFlow& VerticalFlow::operator=(VerticalFlow&& other) noexcept
+    {
+        if (this == &other) return *this;
+        LayoutElement::operator=(std::move(other));
+        horAlign = other.horAlign;
+        verAlign = other.verAlign;
+        children = std::move(other.children);
+        other.children.clear();
+        other.invalidateStructure();
+        reparentChildren();
+        invalidateStructure();
+        return *this;
+    }
+
     LayoutElementPtr VerticalFlow::clone(Layout* l, LayoutElement* p) const
     {
         auto elem = std::make_unique<VerticalFlow>(*this);
@@ -50,16 +191,38 @@ namespace floah
 
     size_t VerticalFlow::getChildCount() const noexcept { return children.size(); }
 
-    ////////////////////////////////////////////////////////////////
-    // Setters.
-    ////////////////////////////////////////////////////////////////
+    bool VerticalFlow::isLayoutEqual(const LayoutElement& other) const noexcept
+    {
+        if (!LayoutElement::isLayoutEqual(other)) return false;
+        const auto& o = static_cast<const VerticalFlow&>(other);
+        return horAlign == o.horAlign && verAlign == o.verAlign;
+    }
+
+    uint64_t VerticalFlow::getLayoutHash() const noexcept
+    {
+        auto h = LayoutElement::getLayoutHash();
+        hashCombine(h, static_cast<uint64_t>(horAlign));
+        hashCombine(h, static_cast<uint64_t>(verAlign));
+        return h;
+    }
+
+    std::span<const LayoutElementPtr> VerticalFlow::getChildren() const noexcept { return children; }
 
-    void VerticalFlow::setLayout(Layout* l) noexcept
+    std::span<LayoutElementPtr> VerticalFlow::getChildSlots() noexcept { return children; }
+
+    bool VerticalFlow::swapChildren(LayoutElement& other) noexcept
     {
-        LayoutElement::setLayout(l);
-        for (auto& c : children) LayoutElement::setLayout(l, *c);
+        auto& flow = static_cast<VerticalFlow&>(other);
+        children.swap(flow.children);
+        reparentChildren();
+        flow.reparentChildren();
+        return true;
     }
 
+    ////////////////////////////////////////////////////////////////
+    // Setters.
+    ////////////////////////////////////////////////////////////////
+
     void VerticalFlow::setHorizontalAlignment(const HorizontalAlignment alignment) noexcept { horAlign = alignment; }
 
     void VerticalFlow::setVerticalAlignment(const VerticalAlignment alignment)
@@ -79,96 +242,35 @@ namespace floah
         for (const auto& c : children) c->countBlocks(count);
     }
 
-    void VerticalFlow::generate(std::vector<Block>& blocks, Block& block) const
+    void VerticalFlow::layoutChildren(const BBox&           bounds,
+                                      const std::span<BBox> childBounds,
+                                      LayoutScratch&        scratch) const
     {
-        if (children.empty()) return;
-
-        block.firstChild = blocks.size();
-        block.childCount = children.size();
-
-        const auto& bounds = block.bounds;
-
-        // Total width is bounds.width minus left and right margin.
-        const auto boundsWidth = bounds.width();
-        const auto leftMargin  = innerMargin.getLeft().get(boundsWidth);
-        const auto rightMargin = innerMargin.getRight().get(boundsWidth);
-        const auto width       = boundsWidth - leftMargin - rightMargin;
-
-        // Total height is bounds.height minus top and bottom margin.
-        const auto boundsHeight = bounds.height();
-        const auto topMargin    = innerMargin.getTop().get(boundsHeight);
-        const auto bottomMargin = innerMargin.getBottom().get(boundsHeight);
-        const auto height       = boundsHeight - topMargin - bottomMargin;
-
-        // Start at top or bottom of bounds.
-        int32_t y = 0;
-        switch (verAlign)
-        {
-        case VerticalAlignment::Top: y = bounds.y0 + topMargin; break;
-        case VerticalAlignment::Middle:
-            throw FloahError("Cannot generate. Middle not supported for vertical alignment.");
-        case VerticalAlignment::Bottom: y = bounds.y1 - bottomMargin;
-        }
-
-        // Offset from left or right of bounds, or center around vertical axis.
-        int32_t x = 0;
-        switch (horAlign)
-        {
-        case HorizontalAlignment::Left: x = bounds.x0 + leftMargin; break;
-        case HorizontalAlignment::Center: x = (bounds.x0 + leftMargin + bounds.x1 - rightMargin) / 2; break;
-        case HorizontalAlignment::Right: x = bounds.x1 - rightMargin;
-        }
-
-        for (const auto& c : children)
-        {
-            // Calculate absolute size of child.
-            const auto cWidth  = c->getSize().getWidth().get(width);
-            const auto cHeight = c->getSize().getHeight().get(height);
-
-            BBox b;
-
-            switch (verAlign)
-            {
-            // Append to bottom of elements and move y further down.
-            case VerticalAlignment::Top:
-                b.y0 = y + c->getOuterMargin().getTop().get(height);
-                b.y1 = b.y0 + cHeight;
-                y    = b.y1 + c->getOuterMargin().getBottom().get(height);
-                break;
-            case VerticalAlignment::Middle: break;
-            // Append to top of elements and move y further up.
-            case VerticalAlignment::Bottom:
-                b.y1 = y - c->getOuterMargin().getBottom().get(height);
-                b.y0 = b.y1 - cHeight;
-                y    = b.y0 - c->getOuterMargin().getTop().get(height);
-                break;
-            }
+        layoutFlow(*this, std::span<const LayoutElementPtr>(children), bounds, childBounds, scratch);
+    }
 
-            switch (horAlign)
-            {
-            // Offset from left of parent.
-            case HorizontalAlignment::Left:
-                b.x0 = x + c->getOuterMargin().getLeft().get(width);
-                b.x1 = b.x0 + cWidth;
-                break;
-            // Center around middle of parent.
-            case HorizontalAlignment::Center:
-                b.x0 = x - (cWidth + 1) / 2;  // Add 1 so odd widths are respected.
-                b.x1 = x + cWidth / 2;
-                break;
-            // Offset from right of parent.
-            case HorizontalAlignment::Right:
-                b.x1 = x - c->getOuterMargin().getRight().get(width);
-                b.x0 = b.x0 - cWidth;
-                break;
-            }
+    void VerticalFlow::layoutNode(const SnapshotNode&     node,
+                                  const SnapshotChildren& children,
+                                  const BBox&             bounds,
+                                  const std::span<BBox>   childBounds,
+                                  LayoutScratch&          scratch)
+    {
+        layoutFlow(node, children, bounds, childBounds, scratch);
+    }
 
-            blocks.emplace_back(c->getId(), b);
-        }
+    ////////////////////////////////////////////////////////////////
+    // Memory.
+    ////////////////////////////////////////////////////////////////
 
-        for (size_t i = 0; i < children.size(); i++) { children[i]->generate(blocks, blocks[block.firstChild + i]); }
+    void VerticalFlow::addMemoryUsage(MemoryUsage& usage) const
+    {
+        const auto bytes  = children.capacity() * sizeof(LayoutElementPtr);
+        const auto wasted = (children.capacity() - children.size()) * sizeof(LayoutElementPtr);
+        usage.addElement(typeid(*this).name(), sizeof(VerticalFlow) + bytes, wasted);
     }
 
+    void VerticalFlow::shrinkToFit() { children.shrink_to_fit(); }
+
     ////////////////////////////////////////////////////////////////
     // Elements.
     ////////////////////////////////////////////////////////////////
@@ -184,6 +286,8 @@ namespace floah
     {
         if (index >= children.size()) throw FloahError("Cannot remove element. Index is out of range.");
 
+        prepareStructureChange();
+        removeChild(*children[index]);
         children.erase(children.begin() + index);
     }
 
@@ -191,23 +295,60 @@ namespace floah
     {
         if (index >= children.size()) throw FloahError("Cannot extract element. Index is out of range.");
 
+        prepareStructureChange();
         auto elem = std::move(children[index]);
         children.erase(children.begin() + index);
         removeChild(*elem);
         return elem;
     }
 
+    void VerticalFlow::appendRange(std::vector<LayoutElementPtr> elems)
+    {
+        insertRange(std::move(elems), children.size());
+    }
+
+    void VerticalFlow::insertRange(std::vector<LayoutElementPtr> elems, const size_t index)
+    {
+        for (const auto& elem : elems)
+        {
+            if (!elem) throw FloahError("Cannot insert elements. Element is nullptr.");
+        }
+
+        prepareStructureChange();
+        const auto first = children.insert(children.begin() + std::min(children.size(), index),
+                                           std::make_move_iterator(elems.begin()),
+                                           std::make_move_iterator(elems.end()));
+        makeChildren(std::span(first, elems.size()));
+    }
+
+    void VerticalFlow::reserve(const size_t count) { children.reserve(count); }
+
+    std::vector<LayoutElementPtr> VerticalFlow::extractRange(const size_t index, const size_t count)
+    {
+        if (index > children.size() || count > children.size() - index)
+            throw FloahError("Cannot extract elements. Index is out of range.");
+
+        prepareStructureChange();
+        const auto                    first = children.begin() + index;
+        std::vector<LayoutElementPtr> elems(std::make_move_iterator(first), std::make_move_iterator(first + count));
+        children.erase(first, first + count);
+        removeChildren(elems);
+        return elems;
+    }
+
     void VerticalFlow::appendImpl(LayoutElementPtr elem)
     {
-        makeChild(*elem);
+        prepareStructureChange();
         children.push_back(std::move(elem));
+        makeChild(*children.back());
     }
 
     void VerticalFlow::prependImpl(LayoutElementPtr elem) { insertImpl(std::move(elem), 0); }
 
     void VerticalFlow::insertImpl(LayoutElementPtr elem, const size_t index)
     {
-        makeChild(*elem);
-        children.insert(children.begin() + std::min(children.size(), index), std::move(elem));
+        prepareStructureChange();
+        const auto it = children.insert(children.begin() + std::min(children.size(), index), std::move(elem));
+        makeChild(**it);
     }
 }  // namespace floah
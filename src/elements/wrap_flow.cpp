@@ -0,0 +1,430 @@
+#include "floah-layout/elements/wrap_flow.h"
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <iterator>
+#include <typeinfo>
+#include <utility>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-common/floah_error.h"
+#include "../hash.h"
+#include "../snapshot_node.h"
+
+namespace floah
+{
+    ////////////////////////////////////////////////////////////////
+    // Constructors.
+    ////////////////////////////////////////////////////////////////
+
+    WrapFlow::WrapFlow() = default;
+
+    WrapFlow::WrapFlow(const WrapFlow& other) :
+        LayoutElement(other), horAlign(other.horAlign), verAlign(other.verAlign)
+    {
+    }
+
+    WrapFlow::WrapFlow(WrapFlow&& other) noexcept :
+        LayoutElement(std::move(other)),
+        horAlign(other.horAlign),
+        verAlign(other.verAlign),
+        children(std::move(other.children))
+    {
+        other.children.clear();
+        other.invalidateStructure();
+        reparentChildren();
+    }
+
+    WrapFlow::~WrapFlow() noexcept = default;
+
+    WrapFlow& WrapFlow::operator=(const WrapFlow& other)
+    {
+        LayoutElement::operator=(other);
+        horAlign         = other.horAlign;
+        verAlign         = other.verAlign;
+        return *this;
+    }
+
+    WrapFlow& WrapFlow::operator=(WrapFlow&& other) noexcept
+    {
+        if (this == &other) return *this;
+        LayoutElement::operator=(std::move(other));
+        horAlign = other.horAlign;
+        verAlign = other.verAlign;
+        children = std::move(other.children);
+        other.children.clear();
+        other.invalidateStructure();
+        reparentChildren();
+        invalidateStructure();
+        return *this;
+    }
+
+    LayoutElementPtr WrapFlow::clone(Layout* l, LayoutElement* p) const
+    {
+        auto elem = std::make_unique<WrapFlow>(*this);
+        elem->cloneImpl(l, p);
+
+        elem->children.reserve(children.size());
+        for (const auto& c : children) elem->children.push_back(c->clone(l, elem.get()));
+
+        return elem;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Getters.
+    ////////////////////////////////////////////////////////////////
+
+    HorizontalAlignment WrapFlow::getHorizontalAlignment() const noexcept { return horAlign; }
+
+    VerticalAlignment WrapFlow::getVerticalAlignment() const noexcept { return verAlign; }
+
+    size_t WrapFlow::getChildCount() const noexcept { return children.size(); }
+
+    size_t WrapFlow::getLineCount(const BBox& bounds) const
+    {
+        const auto          area = calculateInnerArea(innerMargin, bounds);
+        std::vector<Extent> extents(children.size());
+        calculateExtents(std::span<const LayoutElementPtr>(children), area.width(), area.height(), extents);
+
+        size_t count = 0;
+        for (size_t i = 0; i < extents.size(); count++) i = breakLine(extents, i, area.width()).end;
+        return count;
+    }
+
+    bool WrapFlow::isLayoutEqual(const LayoutElement& other) const noexcept
+    {
+        if (!LayoutElement::isLayoutEqual(other)) return false;
+        const auto& o = static_cast<const WrapFlow&>(other);
+        return horAlign == o.horAlign && verAlign == o.verAlign;
+    }
+
+    uint64_t WrapFlow::getLayoutHash() const noexcept
+    {
+        auto h = LayoutElement::getLayoutHash();
+        hashCombine(h, static_cast<uint64_t>(horAlign));
+        hashCombine(h, static_cast<uint64_t>(verAlign));
+        return h;
+    }
+
+    std::span<const LayoutElementPtr> WrapFlow::getChildren() const noexcept { return children; }
+
+    std::span<LayoutElementPtr> WrapFlow::getChildSlots() noexcept { return children; }
+
+    bool WrapFlow::swapChildren(LayoutElement& other) noexcept
+    {
+        auto& flow = static_cast<WrapFlow&>(other);
+        children.swap(flow.children);
+        reparentChildren();
+        flow.reparentChildren();
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Setters.
+    ////////////////////////////////////////////////////////////////
+
+    void WrapFlow::setHorizontalAlignment(const HorizontalAlignment alignment) noexcept { horAlign = alignment; }
+
+    void WrapFlow::setVerticalAlignment(const VerticalAlignment alignment) noexcept { verAlign = alignment; }
+
+    ////////////////////////////////////////////////////////////////
+    // Generate.
+    ////////////////////////////////////////////////////////////////
+
+    void WrapFlow::countBlocks(size_t& count) const noexcept
+    {
+        count++;
+        for (const auto& c : children) c->countBlocks(count);
+    }
+
+    void WrapFlow::layoutChildren(const BBox& bounds, const std::span<BBox> childBounds, LayoutScratch& scratch) const
+    {
+        layoutFlow(*this, std::span<const LayoutElementPtr>(children), bounds, childBounds, scratch);
+    }
+
+    void WrapFlow::layoutNode(const SnapshotNode&     node,
+                              const SnapshotChildren& children,
+                              const BBox&             bounds,
+                              const std::span<BBox>   childBounds,
+                              LayoutScratch&          scratch)
+    {
+        layoutFlow(node, children, bounds, childBounds, scratch);
+    }
+
+    template<typename Flow, typename Children>
+    void WrapFlow::layoutFlow(const Flow&           flow,
+                              const Children&       children,
+                              const BBox&           bounds,
+                              const std::span<BBox> childBounds,
+                              LayoutScratch&        scratch)
+    {
+        if (children.empty()) return;
+
+        const auto horAlign = flow.getHorizontalAlignment();
+        const auto verAlign = flow.getVerticalAlignment();
+        const auto area     = calculateInnerArea(flow.getInnerMargin(), bounds);
+        const auto width    = area.width();
+        auto       y        = area.y0;
+
+        // Reuse the line breaks of the previous generate if there is a cache to keep them in.
+        if (auto* breaks = scratch.getLineBreaks(flow.getId()))
+        {
+            updateLineBreaks(children, *breaks, width, area.height());
+            for (const auto& line : breaks->lines)
+                y = placeLine(horAlign, verAlign, line, breaks->extents, area, y, childBounds);
+            return;
+        }
+
+        const auto extents = scratch.allocate<Extent>(children.size());
+        calculateExtents(children, width, area.height(), extents);
+        for (size_t first = 0; first < children.size();)
+        {
+            const auto line = breakLine(extents, first, width);
+            y               = placeLine(horAlign, verAlign, line, extents, area, y, childBounds);
+            first           = line.end;
+        }
+    }
+
+    int32_t WrapFlow::placeLine(const HorizontalAlignment     horAlign,
+                                const VerticalAlignment       verAlign,
+                                const Line&                   line,
+                                const std::span<const Extent> extents,
+                                const BBox&                   area,
+                                const int32_t                 y,
+                                const std::span<BBox>         childBounds) noexcept
+    {
+        // Start at left, center or right of bounds. Round down, so that the result does not depend on the position of
+        // the bounds.
+        const auto width = area.width();
+        auto       x     = area.x0;
+        switch (horAlign)
+        {
+        case HorizontalAlignment::Left: break;
+        case HorizontalAlignment::Center: x += (width - line.width) >> 1; break;
+        case HorizontalAlignment::Right: x += width - line.width; break;
+        }
+
+        for (auto i = line.first; i < line.end; i++)
+        {
+            const auto& e = extents[i];
+            auto&       b = childBounds[i];
+
+            // Append to right of elements and move x further right.
+            b.x0 = x + e.left;
+            b.x1 = b.x0 + e.width;
+            x    = b.x1 + e.right;
+
+            switch (verAlign)
+            {
+            // Offset from top of line.
+            case VerticalAlignment::Top: b.y0 = y + e.top; break;
+            // Center in line.
+            case VerticalAlignment::Middle: b.y0 = y + ((line.height - e.outerHeight()) >> 1) + e.top; break;
+            // Offset from bottom of line.
+            case VerticalAlignment::Bottom: b.y0 = y + line.height - e.bottom - e.height; break;
+            }
+            b.y1 = b.y0 + e.height;
+        }
+
+        return y + line.height;
+    }
+
+    BBox WrapFlow::calculateInnerArea(const Margin& innerMargin, const BBox& bounds) noexcept
+    {
+        // Total width is bounds.width minus left and right margin.
+        const auto boundsWidth = bounds.width();
+        const auto leftMargin  = innerMargin.getLeft().get(boundsWidth);
+        const auto rightMargin = innerMargin.getRight().get(boundsWidth);
+
+        // Total height is bounds.height minus top and bottom margin.
+        const auto boundsHeight = bounds.height();
+        const auto topMargin    = innerMargin.getTop().get(boundsHeight);
+        const auto bottomMargin = innerMargin.getBottom().get(boundsHeight);
+
+        return BBox{.x0 = bounds.x0 + leftMargin,
+                    .y0 = bounds.y0 + topMargin,
+                    .x1 = bounds.x1 - rightMargin,
+                    .y1 = bounds.y1 - bottomMargin};
+    }
+
+    template<typename Children>
+    void WrapFlow::calculateExtents(const Children&         children,
+                                    const int32_t           width,
+                                    const int32_t           height,
+                                    const std::span<Extent> extents) noexcept
+    {
+        for (size_t i = 0; i < children.size(); i++)
+        {
+            const auto& c = children[i];
+            extents[i]    = Extent{.width  = c->getSize().getWidth().get(width),
+                                   .height = c->getSize().getHeight().get(height),
+                                   .left   = c->getOuterMargin().getLeft().get(width),
+                                   .top    = c->getOuterMargin().getTop().get(height),
+                                   .right  = c->getOuterMargin().getRight().get(width),
+                                   .bottom = c->getOuterMargin().getBottom().get(height)};
+        }
+    }
+
+    WrapFlow::Line WrapFlow::breakLine(const std::span<const Extent> extents,
+                                       const size_t                  first,
+                                       const int32_t                 width) noexcept
+    {
+        // A line holds at least one element, even if that element does not fit.
+        Line line{.first = first, .end = first};
+        for (auto i = first; i < extents.size(); i++)
+        {
+            const auto w = extents[i].outerWidth();
+            if (line.end > line.first && line.width + w > width) break;
+            line.end++;
+            line.width += w;
+            line.height = std::max(line.height, extents[i].outerHeight());
+        }
+        return line;
+    }
+
+    template<typename Children>
+    void WrapFlow::updateLineBreaks(const Children& children,
+                                    LineBreaks&     breaks,
+                                    const int32_t   width,
+                                    const int32_t   height)
+    {
+        // Find first child element whose extent changed since the last generate.
+        auto&      extents      = breaks.extents;
+        auto&      lines        = breaks.lines;
+        const auto count        = children.size();
+        size_t     firstChanged = std::min(count, extents.size());
+        extents.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            const auto& c = children[i];
+            const Extent e{.width  = c->getSize().getWidth().get(width),
+                           .height = c->getSize().getHeight().get(height),
+                           .left   = c->getOuterMargin().getLeft().get(width),
+                           .top    = c->getOuterMargin().getTop().get(height),
+                           .right  = c->getOuterMargin().getRight().get(width),
+                           .bottom = c->getOuterMargin().getBottom().get(height)};
+            if (i < firstChanged && extents[i] != e) firstChanged = i;
+            extents[i] = e;
+        }
+
+        // Keep all leading lines that contain only unchanged elements, still fit, and still break before an unchanged
+        // element that does not fit. The last line is never kept, since elements may have been added after it.
+        size_t kept = 0;
+        while (kept < lines.size())
+        {
+            const auto& line = lines[kept];
+            if (line.end >= firstChanged) break;
+            if (line.width > width && line.end - line.first > 1) break;
+            if (line.width + extents[line.end].outerWidth() <= width) break;
+            kept++;
+        }
+        lines.resize(kept);
+
+        // Break remaining lines in a single pass.
+        for (auto first = kept > 0 ? lines.back().end : 0; first < count; first = lines.back().end)
+            lines.push_back(breakLine(extents, first, width));
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Memory.
+    ////////////////////////////////////////////////////////////////
+
+    void WrapFlow::addMemoryUsage(MemoryUsage& usage) const
+    {
+        const auto bytes  = children.capacity() * sizeof(LayoutElementPtr);
+        const auto wasted = (children.capacity() - children.size()) * sizeof(LayoutElementPtr);
+        usage.addElement(typeid(*this).name(), sizeof(WrapFlow) + bytes, wasted);
+    }
+
+    void WrapFlow::shrinkToFit()
+    {
+        children.shrink_to_fit();
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Elements.
+    ////////////////////////////////////////////////////////////////
+
+    LayoutElement& WrapFlow::get(const size_t index) const
+    {
+        if (index >= children.size()) throw FloahError("Cannot get element. Index is out of range.");
+
+        return *children[index];
+    }
+
+    void WrapFlow::remove(const size_t index)
+    {
+        if (index >= children.size()) throw FloahError("Cannot remove element. Index is out of range.");
+
+        prepareStructureChange();
+        removeChild(*children[index]);
+        children.erase(children.begin() + index);
+    }
+
+    LayoutElementPtr WrapFlow::extract(const size_t index)
+    {
+        if (index >= children.size()) throw FloahError("Cannot extract element. Index is out of range.");
+
+        prepareStructureChange();
+        auto elem = std::move(children[index]);
+        children.erase(children.begin() + index);
+        removeChild(*elem);
+        return elem;
+    }
+
+    void WrapFlow::appendRange(std::vector<LayoutElementPtr> elems)
+    {
+        insertRange(std::move(elems), children.size());
+    }
+
+    void WrapFlow::insertRange(std::vector<LayoutElementPtr> elems, const size_t index)
+    {
+        for (const auto& elem : elems)
+        {
+            if (!elem) throw FloahError("Cannot insert elements. Element is nullptr.");
+        }
+
+        prepareStructureChange();
+        const auto first = children.insert(children.begin() + std::min(children.size(), index),
+                                           std::make_move_iterator(elems.begin()),
+                                           std::make_move_iterator(elems.end()));
+        makeChildren(std::span(first, elems.size()));
+    }
+
+    void WrapFlow::reserve(const size_t count) { children.reserve(count); }
+
+    std::vector<LayoutElementPtr> WrapFlow::extractRange(const size_t index, const size_t count)
+    {
+        if (index > children.size() || count > children.size() - index)
+            throw FloahError("Cannot extract elements. Index is out of range.");
+
+        prepareStructureChange();
+        const auto                    first = children.begin() + index;
+        std::vector<LayoutElementPtr> elems(std::make_move_iterator(first), std::make_move_iterator(first + count));
+        children.erase(first, first + count);
+        removeChildren(elems);
+        return elems;
+    }
+
+    void WrapFlow::appendImpl(LayoutElementPtr elem)
+    {
+        prepareStructureChange();
+        children.push_back(std::move(elem));
+        makeChild(*children.back());
+    }
+
+    void WrapFlow::prependImpl(LayoutElementPtr elem) { insertImpl(std::move(elem), 0); }
+
+    void WrapFlow::insertImpl(LayoutElementPtr elem, const size_t index)
+    {
+        prepareStructureChange();
+        const auto it = children.insert(children.begin() + std::min(children.size(), index), std::move(elem));
+        makeChild(**it);
+    }
+}  // namespace floah
@@ -0,0 +1,120 @@
+#include "flex_solver.h"
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "snapshot_node.h"
+
+namespace floah
+{
+    template<typename Children>
+    std::span<int32_t> FlexSolver::solve(const Children& children,
+                                         const bool      horizontal,
+                                         const int32_t   space,
+                                         LayoutScratch&  scratch)
+    {
+        size_t count = 0;
+        for (const auto& c : children)
+        {
+            if (c && c->getFlex().weight > 0) count++;
+        }
+        if (count == 0) return {};
+
+        // Place fixed-size children and collect flexible children. Each item has at most two events.
+        auto    sizes      = scratch.allocate<int32_t>(children.size());
+        auto    items      = scratch.allocate<Item>(count);
+        auto    events     = scratch.allocate<Event>(count * 2);
+        size_t  itemCount  = 0;
+        size_t  eventCount = 0;
+        int32_t remaining  = space;
+        for (size_t i = 0; i < children.size(); i++)
+        {
+            const auto& c = children[i];
+            if (!c) continue;
+
+            const auto& margin = c->getOuterMargin();
+            remaining -= horizontal ? margin.getLeft().get(space) + margin.getRight().get(space) :
+                                      margin.getTop().get(space) + margin.getBottom().get(space);
+
+            const auto& flex = c->getFlex();
+            if (flex.weight > 0)
+            {
+                const auto min = std::max(0, flex.min.get(space));
+                const auto max = flex.max ? std::max(min, flex.max->get(space)) : std::numeric_limits<int32_t>::max();
+                items[itemCount++] = Item{.index = i, .weight = flex.weight, .min = min, .max = max};
+                continue;
+            }
+
+            sizes[i] = horizontal ? c->getSize().getWidth().get(space) : c->getSize().getHeight().get(space);
+            remaining -= sizes[i];
+        }
+
+        // The size of item i is clamp(ratio * weight, min, max), which is non-decreasing in ratio. Find the ratio at
+        // which all sizes add up to the remaining space by sweeping over the ratios at which items become unclamped
+        // (reach min) or clamped again (reach max). Between two such ratios, the total is linear in the ratio.
+        double fixed = 0;
+        for (const auto& item : items)
+        {
+            fixed += item.min;
+            events[eventCount++] = Event{.ratio  = static_cast<double>(item.min) / item.weight,
+                                         .weight = item.weight,
+                                         .size   = -double(item.min)};
+            if (item.max != std::numeric_limits<int32_t>::max())
+            {
+                events[eventCount++] = Event{.ratio  = static_cast<double>(item.max) / item.weight,
+                                             .weight = -item.weight,
+                                             .size   = double(item.max)};
+            }
+        }
+        events = events.first(eventCount);
+        std::ranges::sort(events, {}, &Event::ratio);
+
+        auto   ratio  = std::numeric_limits<double>::infinity();
+        double weight = 0;
+        for (const auto& event : events)
+        {
+            if (weight > 0 && fixed + weight * event.ratio >= remaining)
+            {
+                ratio = (remaining - fixed) / weight;
+                break;
+            }
+            weight += event.weight;
+            fixed += event.size;
+        }
+        if (std::isinf(ratio) && weight > 0) ratio = (remaining - fixed) / weight;
+        if (remaining <= 0) ratio = 0;
+
+        // Round down and hand out the pixels that are left one by one to items that are not at their max.
+        int32_t used = 0;
+        for (const auto& item : items)
+        {
+            const auto size = std::isinf(ratio) ? double(item.max) : std::floor(ratio * item.weight);
+            sizes[item.index] = static_cast<int32_t>(std::clamp(size, double(item.min), double(item.max)));
+            used += sizes[item.index];
+        }
+        for (auto it = items.begin(); it != items.end() && used < remaining; ++it)
+        {
+            if (ratio * it->weight >= it->min && sizes[it->index] < it->max)
+            {
+                sizes[it->index]++;
+                used++;
+            }
+        }
+
+        return sizes;
+    }
+
+    template std::span<int32_t>
+      FlexSolver::solve(const std::span<const LayoutElementPtr>&, bool, int32_t, LayoutScratch&);
+
+    template std::span<int32_t> FlexSolver::solve(const SnapshotChildren&, bool, int32_t, LayoutScratch&);
+}  // namespace floah
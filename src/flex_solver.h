@@ -0,0 +1,67 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <cstdint>
+#include <span>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-layout/layout_element.h"
+#include "floah-layout/layout_scratch.h"
+
+namespace floah
+{
+    /**
+     * \brief Calculates the sizes of the children of a flow along its main axis, distributing the remaining space over
+     * children with a flex weight.
+     */
+    class FlexSolver
+    {
+    public:
+        /**
+         * \brief Calculate sizes along the main axis.
+         * \tparam Children List of child elements (see LayoutElement::getChildren) or child nodes of a snapshot (see
+         * SnapshotChildren). Instantiated for both in flex_solver.cpp.
+         * \param children Child elements.
+         * \param horizontal If true, the main axis is horizontal.
+         * \param space Inner size of the flow along the main axis.
+         * \param scratch Scratch memory to allocate the sizes and intermediate results from.
+         * \return Sizes, one per child. Empty if no child has a flex weight.
+         */
+        template<typename Children>
+        [[nodiscard]] static std::span<int32_t>
+          solve(const Children& children, bool horizontal, int32_t space, LayoutScratch& scratch);
+
+    private:
+        struct Item
+        {
+            size_t  index  = 0;
+            float   weight = 0;
+            int32_t min    = 0;
+            int32_t max    = 0;
+        };
+
+        struct Event
+        {
+            /**
+             * \brief Space per unit of weight at which the item reaches its min or max.
+             */
+            double ratio = 0;
+
+            /**
+             * \brief Change in total weight of unclamped items.
+             */
+            double weight = 0;
+
+            /**
+             * \brief Change in total size of clamped items.
+             */
+            double size = 0;
+        };
+    };
+}  // namespace floah
@@ -0,0 +1,135 @@
+#include "floah-layout/generate_cache.h"
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "hash.h"
+
+namespace floah
+{
+    namespace
+    {
+        /**
+         * \brief Erase all but the keep most recently used values of a map whose values have a lastUse member.
+         */
+        template<typename Map>
+        void evictLeastRecentlyUsed(Map& map, const size_t keep)
+        {
+            if (map.size() <= keep) return;
+            if (keep == 0)
+            {
+                map.clear();
+                return;
+            }
+
+            std::vector<uint64_t> uses;
+            uses.reserve(map.size());
+            for (const auto& [key, value] : map) uses.push_back(value.lastUse);
+
+            // Use counts are unique, so exactly the keep most recent values are at or above the threshold.
+            const auto nth = uses.begin() + static_cast<ptrdiff_t>(uses.size() - keep);
+            std::ranges::nth_element(uses, nth);
+            const auto threshold = *nth;
+            std::erase_if(map, [threshold](const auto& kv) { return kv.second.lastUse < threshold; });
+        }
+    }  // namespace
+
+    ////////////////////////////////////////////////////////////////
+    // Constructors.
+    ////////////////////////////////////////////////////////////////
+
+    GenerateCache::GenerateCache() = default;
+
+    GenerateCache::GenerateCache(const size_t cap) : capacity(cap) {}
+
+    GenerateCache::GenerateCache(const GenerateCache&) = default;
+
+    GenerateCache::GenerateCache(GenerateCache&&) noexcept = default;
+
+    GenerateCache::~GenerateCache() noexcept = default;
+
+    GenerateCache& GenerateCache::operator=(const GenerateCache&) = default;
+
+    GenerateCache& GenerateCache::operator=(GenerateCache&&) noexcept = default;
+
+    ////////////////////////////////////////////////////////////////
+    // Getters.
+    ////////////////////////////////////////////////////////////////
+
+    size_t GenerateCache::size() const noexcept { return entries.size(); }
+
+    size_t GenerateCache::getCapacity() const noexcept { return capacity; }
+
+    size_t GenerateCache::getHitCount() const noexcept { return hits; }
+
+    size_t GenerateCache::getMissCount() const noexcept { return misses; }
+
+    size_t GenerateCache::KeyHash::operator()(const Key& key) const noexcept
+    {
+        auto h = key.hash;
+        hashCombine(h, static_cast<uint32_t>(key.width));
+        hashCombine(h, static_cast<uint32_t>(key.height));
+        hashCombine(h, static_cast<uint64_t>(key.order));
+        return static_cast<size_t>(h);
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Modifiers.
+    ////////////////////////////////////////////////////////////////
+
+    void GenerateCache::clear() noexcept
+    {
+        entries.clear();
+        lineBreaks.clear();
+        hits   = 0;
+        misses = 0;
+        clock  = 0;
+    }
+
+    void GenerateCache::setCapacity(const size_t value)
+    {
+        capacity = value;
+        evict(capacity);
+    }
+
+    LineBreaks* GenerateCache::getLineBreaks(const uuids::uuid& id)
+    {
+        if (capacity == 0) return nullptr;
+
+        auto it = lineBreaks.find(id);
+        if (it == lineBreaks.end())
+        {
+            if (lineBreaks.size() >= capacity) evictLeastRecentlyUsed(lineBreaks, capacity - 1 - (capacity - 1) / 4);
+            it = lineBreaks.try_emplace(id).first;
+        }
+
+        it->second.lastUse = ++clock;
+        return &it->second.breaks;
+    }
+
+    void GenerateCache::insert(const Key& key, Entry entry)
+    {
+        if (capacity == 0) return;
+
+        // Evict a quarter at once, so that the cost of finding the least recently used subtrees is spread over many
+        // inserts.
+        if (entries.size() >= capacity && !entries.contains(key))
+            evictLeastRecentlyUsed(entries, capacity - 1 - (capacity - 1) / 4);
+
+        entry.lastUse = ++clock;
+        entries.insert_or_assign(key, std::move(entry));
+    }
+
+    void GenerateCache::evict(const size_t keep)
+    {
+        evictLeastRecentlyUsed(entries, keep);
+        evictLeastRecentlyUsed(lineBreaks, keep);
+    }
+}  // namespace floah
@@ -0,0 +1,466 @@
+#include "generator.h"
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <chrono>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "hash.h"
+#include "snapshot_node.h"
+
+namespace floah
+{
+    namespace
+    {
+        constexpr size_t noParent = static_cast<size_t>(-1);
+
+        [[nodiscard]] BBox translate(BBox bounds, const int32_t dx, const int32_t dy) noexcept
+        {
+            bounds.x0 += dx;
+            bounds.y0 += dy;
+            bounds.x1 += dx;
+            bounds.y1 += dy;
+            return bounds;
+        }
+
+        [[nodiscard]] bool intersects(const BBox& bounds, const BBox& clip) noexcept
+        {
+            return bounds.x0 < clip.x1 && bounds.x1 > clip.x0 && bounds.y0 < clip.y1 && bounds.y1 > clip.y0;
+        }
+
+        [[nodiscard]] const LayoutElement* toPointer(const LayoutElementPtr& child) noexcept { return child.get(); }
+
+        [[nodiscard]] const SnapshotNode* toPointer(const SnapshotNode* child) noexcept { return child; }
+    }  // namespace
+
+    ////////////////////////////////////////////////////////////////
+    // Constructors.
+    ////////////////////////////////////////////////////////////////
+
+    template<typename Tree>
+    Generator<Tree>::Generator(const GenerateOptions& opts, Tree t) :
+        options(opts),
+        tree(std::move(t)),
+        scratch(opts.cache),
+        cache(opts.clip.empty() && opts.minExtent <= 0 ? opts.cache : nullptr)
+    {
+    }
+
+    template<typename Tree>
+    Generator<Tree>::~Generator() noexcept = default;
+
+    ////////////////////////////////////////////////////////////////
+    // Generate.
+    ////////////////////////////////////////////////////////////////
+
+    template<typename Tree>
+    void Generator<Tree>::generate(const Element& root,
+                                   const BBox&    rootBounds,
+                                   const size_t   maxCount,
+                                   BlockSink&     sink)
+    {
+        begin(root, rootBounds, maxCount, sink);
+        step({});
+    }
+
+    template<typename Tree>
+    void Generator<Tree>::begin(const Element& root,
+                                const BBox&    rootBounds,
+                                const size_t   maxCount,
+                                BlockSink&     sink)
+    {
+        sink.begin(maxCount);
+        output    = &sink;
+        next      = 0;
+        written   = 0;
+        recording = 0;
+        done      = false;
+        stack.clear();
+        captured.clear();
+        if (cache) hashSubtrees(root);
+
+        if (!push(root, rootBounds, noParent))
+        {
+            sink.end(0);
+            done = true;
+        }
+    }
+
+    template<typename Tree>
+    bool Generator<Tree>::step(const GenerateBudget& budget)
+    {
+        if (done) return true;
+
+        using clock         = std::chrono::steady_clock;
+        const auto timed    = budget.time > std::chrono::nanoseconds::zero();
+        const auto deadline = timed ? clock::now() + budget.time : clock::time_point::max();
+        const auto limit    = budget.blocks > 0 ? written + budget.blocks : static_cast<size_t>(-1);
+
+        // Reading the clock is not free, so only check it every so many steps.
+        constexpr size_t clockInterval = 64;
+        size_t           steps         = 0;
+
+        while (!stack.empty())
+        {
+            if (written >= limit) return false;
+            if (timed && ++steps % clockInterval == 0 && clock::now() >= deadline) return false;
+
+            if (!stack.back().visited)
+            {
+                stack.back().visited = true;
+                visit(stack.size() - 1);
+                continue;
+            }
+
+            // Subtree is done. Accumulate into parent and write block.
+            const auto frame = stack.back();
+            stack.pop_back();
+            if (frame.parent != noParent)
+            {
+                auto& parent = stack[frame.parent].block;
+                parent.childBounds += frame.block.childBounds;
+                parent.subtreeEnd = std::max(parent.subtreeEnd, frame.block.subtreeEnd);
+            }
+            if (frame.recordStart != noRecord)
+            {
+                record(frame);
+                recording--;
+            }
+            if (frame.parent == noParent)
+                emit(frame.index, frame.block, 0, 0);
+            else
+            {
+                const auto& origin = stack[frame.parent].block.bounds;
+                emit(frame.index, frame.block, origin.x0, origin.y0);
+            }
+        }
+
+        output->end(next);
+        done = true;
+        return true;
+    }
+
+    template<typename Tree>
+    size_t Generator<Tree>::getWrittenCount() const noexcept { return written; }
+
+    template<typename Tree>
+    bool Generator<Tree>::push(const Element& element, const BBox& bounds, const size_t parent)
+    {
+        const auto culled = isCulled(bounds);
+        if (culled && options.cullMode == CullMode::Skip) return false;
+
+        // In sibling order, indices are assigned when the parent lays out its children. In depth-first order, they are
+        // assigned when the element itself is visited.
+        const auto index = options.order == BlockOrder::Siblings ? next++ : 0;
+
+        auto flags = culled ? BlockFlags::Culled : BlockFlags::None;
+        if (!culled && isCollapsed(element, bounds)) flags |= BlockFlags::Collapsed;
+
+        // Inherit the clip rectangle of the parent.
+        BBox clip    = {};
+        bool hasClip = false;
+        if (parent != noParent && stack[parent].hasClip)
+        {
+            clip    = stack[parent].clip;
+            hasClip = true;
+            if (!intersects(bounds, clip)) flags |= BlockFlags::Clipped;
+        }
+
+        stack.push_back(Frame{.element = &element,
+                              .block   = Block{.id          = element.getId(),
+                                               .bounds      = bounds,
+                                               .childBounds = bounds,
+                                               .depth       = parent == noParent ? 0 : stack[parent].block.depth + 1,
+                                               .flags       = flags},
+                              .index   = index,
+                              .parent  = parent,
+                              .clip    = clip,
+                              .hasClip = hasClip});
+        return true;
+    }
+
+    template<typename Tree>
+    void Generator<Tree>::visit(const size_t slot)
+    {
+        {
+            auto& frame = stack[slot];
+            if (options.order == BlockOrder::DepthFirst) frame.index = next++;
+            frame.block.parent     = frame.parent == noParent ? Block::noParent : stack[frame.parent].index;
+            frame.block.subtreeEnd = frame.index + 1;
+            if (any(frame.block.flags, BlockFlags::Culled | BlockFlags::Collapsed)) return;
+        }
+
+        const auto* element  = stack[slot].element;
+        const auto  children = tree.getChildren(*element);
+        if (children.empty()) return;
+
+        // Stamped geometry is translation invariant, flags relative to a clip rectangle of an ancestor are not. The
+        // clip rectangle of the element itself moves with it, so set it up before stamping, so that a stamped block
+        // keeps BlockFlags::ClipsContent.
+        const auto clipped = stack[slot].hasClip;
+        if (BBox clip; tree.getContentClip(*element, stack[slot].block.bounds, clip))
+        {
+            auto& frame   = stack[slot];
+            frame.clip    = clip;
+            frame.hasClip = true;
+            frame.block.flags |= BlockFlags::ClipsContent;
+        }
+
+        if (cache && !clipped && stamp(slot)) return;
+
+        childBounds.assign(children.size(), BBox{});
+        scratch.reset();
+        tree.layoutChildren(*element, stack[slot].block.bounds, childBounds, scratch);
+
+        // Push frames for all children that are not skipped.
+        const auto firstFrame = stack.size();
+        const auto firstChild = options.order == BlockOrder::Siblings ? next : stack[slot].index + 1;
+        for (size_t i = 0; i < children.size(); i++)
+        {
+            if (children[i]) push(*children[i], childBounds[i], slot);
+        }
+
+        auto& block      = stack[slot].block;
+        block.childCount = stack.size() - firstFrame;
+        if (block.childCount > 0) block.firstChild = firstChild;
+
+        // Reverse so that the first child is on top of the stack and its subtree is done first.
+        std::reverse(stack.begin() + static_cast<ptrdiff_t>(firstFrame), stack.end());
+    }
+
+    template<typename Tree>
+    bool Generator<Tree>::isCulled(const BBox& bounds) const noexcept
+    {
+        if (options.clip.empty()) return false;
+
+        return std::ranges::none_of(options.clip, [&bounds](const BBox& clip) { return intersects(bounds, clip); });
+    }
+
+    template<typename Tree>
+    bool Generator<Tree>::isCollapsed(const Element& element, const BBox& bounds) const noexcept
+    {
+        if (options.minExtent <= 0) return false;
+        if (bounds.width() >= options.minExtent || bounds.height() >= options.minExtent) return false;
+
+        for (const auto& c : tree.getChildren(element))
+        {
+            if (c) return true;
+        }
+        return false;
+    }
+
+    template<typename Tree>
+    void Generator<Tree>::emit(const size_t index, const Block& block, const int32_t originX, const int32_t originY)
+    {
+        if (options.coordinates == CoordinateMode::ParentRelative)
+        {
+            auto relative        = block;
+            relative.bounds      = translate(block.bounds, -originX, -originY);
+            relative.childBounds = translate(block.childBounds, -originX, -originY);
+            output->write(index, relative);
+        }
+        else
+            output->write(index, block);
+        written++;
+
+        // Always capture absolute blocks, the cache does not depend on the coordinate mode.
+        if (recording > 0)
+            captured.emplace_back(index, block);
+        else
+            captured.clear();
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Cache.
+    ////////////////////////////////////////////////////////////////
+
+    template<typename Tree>
+    void Generator<Tree>::hashSubtrees(const Element& root)
+    {
+        subtreeHashes.clear();
+        hashCounts.clear();
+
+        // Post-order walk, so that the hashes of all children are known when the parent is hashed.
+        std::vector<std::pair<const Element*, bool>> pending;
+        pending.emplace_back(&root, false);
+        while (!pending.empty())
+        {
+            auto [element, expanded] = pending.back();
+            const auto children      = tree.getChildren(*element);
+            if (!expanded)
+            {
+                pending.back().second = true;
+                for (const auto& child : children)
+                {
+                    if (child) pending.emplace_back(toPointer(child), false);
+                }
+                continue;
+            }
+            pending.pop_back();
+
+            // Empty positions (e.g. grid cells) are part of the structure as well.
+            auto h = tree.getLayoutHash(*element);
+            hashCombine(h, children.size());
+            for (const auto& child : children) hashCombine(h, child ? subtreeHashes[toPointer(child)] : 0);
+            subtreeHashes[element] = h;
+            if (!children.empty()) hashCounts[h]++;
+        }
+    }
+
+    template<typename Tree>
+    bool Generator<Tree>::stamp(const size_t slot)
+    {
+        auto&      frame = stack[slot];
+        const auto key   = makeKey(frame);
+        auto       it    = cache->entries.find(key);
+        if (it != cache->entries.end())
+        {
+            // The key is only a hash, so check that the cached subtree has the same shape before using it. A collision
+            // is treated as a miss and the entry is replaced when this subtree is recorded.
+            collectDescendants(*frame.element);
+            if (hashes.size() != it->second.blocks.size() || !std::ranges::equal(hashes, it->second.hashes))
+                it = cache->entries.end();
+        }
+
+        if (it == cache->entries.end())
+        {
+            // Only record subtrees that can be reused.
+            if (hashCounts[key.hash] > 1)
+            {
+                frame.recordStart = captured.size();
+                recording++;
+            }
+            return false;
+        }
+
+        auto&      entry = it->second;
+        const auto count = entry.blocks.size();
+        const auto base  = options.order == BlockOrder::Siblings ? next : frame.index + 1;
+        const auto dx    = frame.block.bounds.x0;
+        const auto dy    = frame.block.bounds.y0;
+        next += count;
+        entry.lastUse = ++cache->clock;
+
+        frame.block.childCount  = entry.childCount;
+        frame.block.childBounds = translate(entry.childBounds, dx, dy);
+        if (count > 0)
+        {
+            frame.block.firstChild = base;
+            frame.block.subtreeEnd = base + count;
+        }
+
+        // Descendants always have larger indices, so writing in reverse keeps every block after its subtree.
+        for (size_t i = count; i-- > 0;)
+        {
+            auto block = entry.blocks[i];
+
+            // Absolute origin of parent, which is either the subtree root or another stamped block.
+            auto ox = frame.block.bounds.x0;
+            auto oy = frame.block.bounds.y0;
+            if (block.parent != Block::noParent)
+            {
+                ox = entry.blocks[block.parent].bounds.x0 + dx;
+                oy = entry.blocks[block.parent].bounds.y0 + dy;
+            }
+
+            block.id          = ids[i];
+            block.bounds      = translate(block.bounds, dx, dy);
+            block.childBounds = translate(block.childBounds, dx, dy);
+            if (block.childCount > 0) block.firstChild += base;
+            block.parent = block.parent == Block::noParent ? frame.index : block.parent + base;
+            block.subtreeEnd += base;
+            block.depth += frame.block.depth;
+            emit(base + i, block, ox, oy);
+        }
+
+        cache->hits++;
+        return true;
+    }
+
+    template<typename Tree>
+    void Generator<Tree>::record(const Frame& frame)
+    {
+        const auto count = captured.size() - frame.recordStart;
+        const auto base  = options.order == BlockOrder::Siblings ? frame.block.firstChild : frame.index + 1;
+        const auto dx    = -frame.block.bounds.x0;
+        const auto dy    = -frame.block.bounds.y0;
+
+        collectDescendants(*frame.element);
+        if (hashes.size() != count) return;
+
+        GenerateCache::Entry entry;
+        entry.childBounds = translate(frame.block.childBounds, dx, dy);
+        entry.childCount  = frame.block.childCount;
+        entry.hashes      = hashes;
+        entry.blocks.resize(count);
+        for (size_t i = frame.recordStart; i < captured.size(); i++)
+        {
+            auto [index, block] = captured[i];
+            block.id            = {};
+            block.bounds        = translate(block.bounds, dx, dy);
+            block.childBounds   = translate(block.childBounds, dx, dy);
+            if (block.childCount > 0) block.firstChild -= base;
+            block.parent = block.parent == frame.index ? Block::noParent : block.parent - base;
+            block.subtreeEnd -= base;
+            block.depth -= frame.block.depth;
+            entry.blocks[index - base] = block;
+        }
+
+        cache->insert(makeKey(frame), std::move(entry));
+        cache->misses++;
+    }
+
+    template<typename Tree>
+    void Generator<Tree>::collectDescendants(const Element& root)
+    {
+        // Replays the traversal of generate without laying out anything. In sibling order, children are indexed when
+        // their parent is visited. In depth-first order, elements are indexed when they are visited themselves.
+        ids.clear();
+        hashes.clear();
+        walk.clear();
+        walk.push_back(&root);
+        while (!walk.empty())
+        {
+            const auto* element = walk.back();
+            walk.pop_back();
+            if (options.order == BlockOrder::DepthFirst && element != &root)
+            {
+                ids.push_back(element->getId());
+                hashes.push_back(subtreeHashes[element]);
+            }
+
+            const auto first = walk.size();
+            for (const auto& child : tree.getChildren(*element))
+            {
+                if (!child) continue;
+                if (options.order == BlockOrder::Siblings)
+                {
+                    ids.push_back(child->getId());
+                    hashes.push_back(subtreeHashes[toPointer(child)]);
+                }
+                walk.push_back(toPointer(child));
+            }
+            std::reverse(walk.begin() + static_cast<ptrdiff_t>(first), walk.end());
+        }
+    }
+
+    template<typename Tree>
+    GenerateCache::Key Generator<Tree>::makeKey(const Frame& frame) const noexcept
+    {
+        const auto it = subtreeHashes.find(frame.element);
+        return GenerateCache::Key{.hash   = it == subtreeHashes.end() ? 0 : it->second,
+                                  .width  = frame.block.bounds.width(),
+                                  .height = frame.block.bounds.height(),
+                                  .order  = options.order};
+    }
+
+    template class Generator<ElementTree>;
+
+    template class Generator<SnapshotTree>;
+}  // namespace floah
@@ -0,0 +1,310 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-layout/block.h"
+#include "floah-layout/block_sink.h"
+#include "floah-layout/generate_cache.h"
+#include "floah-layout/generate_options.h"
+#include "floah-layout/layout.h"
+#include "floah-layout/layout_element.h"
+#include "floah-layout/layout_scratch.h"
+
+namespace floah
+{
+    /**
+     * \brief Lets a Generator traverse a tree of LayoutElements. The generator accesses elements only through a tree,
+     * so that it can traverse the nodes of a LayoutSnapshot as well (see SnapshotTree).
+     */
+    class ElementTree
+    {
+    public:
+        using Element = LayoutElement;
+
+        [[nodiscard]] static std::span<const LayoutElementPtr> getChildren(const LayoutElement& elem) noexcept
+        {
+            return elem.getChildren();
+        }
+
+        [[nodiscard]] static bool getContentClip(const LayoutElement& elem, const BBox& bounds, BBox& clip) noexcept
+        {
+            return elem.getContentClip(bounds, clip);
+        }
+
+        static void layoutChildren(const LayoutElement& elem,
+                                   const BBox&          bounds,
+                                   std::span<BBox>      childBounds,
+                                   LayoutScratch&       scratch)
+        {
+            elem.layoutChildren(bounds, childBounds, scratch);
+        }
+
+        [[nodiscard]] static uint64_t getLayoutHash(const LayoutElement& elem) noexcept { return elem.getLayoutHash(); }
+    };
+
+    /**
+     * \brief Generates the blocks of an element tree. Traverses the tree with an explicit stack instead of recursion.
+     * When an element is visited, its direct children are laid out and pushed on the stack. A block is written once its
+     * whole subtree is done, so it is written only once, with childBounds and subtreeEnd already final.
+     *
+     * Since all state lives in the stack, generation can be suspended between any two steps and resumed later (see
+     * begin and step). The element tree must not change in between.
+     *
+     * \tparam Tree Type through which elements are accessed, either ElementTree or SnapshotTree. Instantiated for both
+     * in generator.cpp.
+     */
+    template<typename Tree>
+    class Generator
+    {
+    public:
+        using Element = typename Tree::Element;
+
+        ////////////////////////////////////////////////////////////////
+        // Constructors.
+        ////////////////////////////////////////////////////////////////
+
+        Generator(const GenerateOptions& opts, Tree t);
+
+        Generator(const Generator&) = delete;
+
+        Generator(Generator&&) noexcept = delete;
+
+        ~Generator() noexcept;
+
+        Generator& operator=(const Generator&) = delete;
+
+        Generator& operator=(Generator&&) noexcept = delete;
+
+        ////////////////////////////////////////////////////////////////
+        // Generate.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Generate all blocks.
+         * \param root Root element.
+         * \param rootBounds Absolute bounds of root element.
+         * \param maxCount Upper bound on the number of blocks (see LayoutElement::countBlocks).
+         * \param sink Sink to write blocks to.
+         */
+        void generate(const Element& root, const BBox& rootBounds, size_t maxCount, BlockSink& sink);
+
+        /**
+         * \brief Start generating. Only calls BlockSink::begin (and BlockSink::end if there is nothing to generate).
+         * Call step until it returns true to generate the blocks.
+         * \param root Root element.
+         * \param rootBounds Absolute bounds of root element.
+         * \param maxCount Upper bound on the number of blocks (see LayoutElement::countBlocks).
+         * \param sink Sink to write blocks to.
+         */
+        void begin(const Element& root, const BBox& rootBounds, size_t maxCount, BlockSink& sink);
+
+        /**
+         * \brief Continue generating until done or until the budget is used up.
+         * \param budget Budget.
+         * \return True if done, in which case BlockSink::end was called.
+         */
+        bool step(const GenerateBudget& budget);
+
+        /**
+         * \brief Get the number of blocks written since begin.
+         * \return Count.
+         */
+        [[nodiscard]] size_t getWrittenCount() const noexcept;
+
+    private:
+        static constexpr size_t noRecord = static_cast<size_t>(-1);
+
+        struct Frame
+        {
+            const Element* element = nullptr;
+
+            Block block;
+
+            /**
+             * \brief Index of block in output.
+             */
+            size_t index = 0;
+
+            /**
+             * \brief Position of frame of parent element on the stack.
+             */
+            size_t parent = 0;
+
+            /**
+             * \brief Position in the list of captured blocks where the blocks of the subtree of this element start, or
+             * noRecord if the subtree is not added to the cache.
+             */
+            size_t recordStart = noRecord;
+
+            /**
+             * \brief Absolute clip rectangle of nearest clipping ancestor. Replaced by the clip rectangle of the element
+             * itself once visited, so that it applies to its children.
+             */
+            BBox clip;
+
+            bool hasClip = false;
+
+            /**
+             * \brief Whether this element was visited, i.e. its children were laid out and pushed.
+             */
+            bool visited = false;
+        };
+
+        /**
+         * \brief Push a frame for an element, unless it is culled and culled elements are skipped.
+         * \param element Element.
+         * \param bounds Absolute bounds of element.
+         * \param parent Position of frame of parent element on the stack.
+         * \return True if pushed.
+         */
+        bool push(const Element& element, const BBox& bounds, size_t parent);
+
+        /**
+         * \brief Assign index of element (in depth-first order) and lay out and push its children.
+         * \param slot Position of frame on the stack.
+         */
+        void visit(size_t slot);
+
+        [[nodiscard]] bool isCulled(const BBox& bounds) const noexcept;
+
+        /**
+         * \brief Get whether the children of an element are left out because its bounds are below the level of detail
+         * threshold. Elements without children are never collapsed.
+         * \param element Element.
+         * \param bounds Bounds of element.
+         * \return True if collapsed.
+         */
+        [[nodiscard]] bool isCollapsed(const Element& element, const BBox& bounds) const noexcept;
+
+        /**
+         * \brief Write block to sink, converting it to the output coordinate mode. Captures it if a subtree is being
+         * recorded for the cache.
+         * \param index Index of block.
+         * \param block Block with absolute bounds.
+         * \param originX Absolute left of parent block (0 for the root).
+         * \param originY Absolute top of parent block (0 for the root).
+         */
+        void emit(size_t index, const Block& block, int32_t originX, int32_t originY);
+
+        ////////////////////////////////////////////////////////////////
+        // Cache.
+        ////////////////////////////////////////////////////////////////
+
+        /**
+         * \brief Calculate the hash of all subtrees and count how often each hash occurs.
+         * \param root Root element.
+         */
+        void hashSubtrees(const Element& root);
+
+        /**
+         * \brief Try to stamp out the subtree of the element from the cache. If it is not cached but occurs more than
+         * once, start recording it.
+         * \param slot Position of frame on the stack.
+         * \return True if stamped.
+         */
+        bool stamp(size_t slot);
+
+        /**
+         * \brief Add the captured blocks of a finished subtree to the cache.
+         * \param frame Frame of subtree root.
+         */
+        void record(const Frame& frame);
+
+        /**
+         * \brief Collect the identifiers and subtree hashes of all descendants of an element in the order in which they
+         * are indexed.
+         * \param root Subtree root.
+         */
+        void collectDescendants(const Element& root);
+
+        [[nodiscard]] GenerateCache::Key makeKey(const Frame& frame) const noexcept;
+
+        ////////////////////////////////////////////////////////////////
+        // Member variables.
+        ////////////////////////////////////////////////////////////////
+
+        const GenerateOptions& options;
+
+        /**
+         * \brief Tree through which all elements are accessed.
+         */
+        Tree tree;
+
+        std::vector<Frame> stack;
+
+        /**
+         * \brief Scratch list for LayoutElement::layoutChildren.
+         */
+        std::vector<BBox> childBounds;
+
+        /**
+         * \brief Scratch memory for LayoutElement::layoutChildren. Reset before each call.
+         */
+        LayoutScratch scratch;
+
+        /**
+         * \brief Sink of current generate.
+         */
+        BlockSink* output = nullptr;
+
+        /**
+         * \brief Index of next block.
+         */
+        size_t next = 0;
+
+        /**
+         * \brief Number of blocks written to the sink.
+         */
+        size_t written = 0;
+
+        /**
+         * \brief Whether the last begin has been completed.
+         */
+        bool done = true;
+
+        /**
+         * \brief Cache, or nullptr if subtrees are not cached in this generate.
+         */
+        GenerateCache* cache = nullptr;
+
+        /**
+         * \brief Hash of the subtree of every element.
+         */
+        std::unordered_map<const Element*, uint64_t> subtreeHashes;
+
+        /**
+         * \brief Number of occurrences of every subtree hash.
+         */
+        std::unordered_map<uint64_t, uint32_t> hashCounts;
+
+        /**
+         * \brief Blocks written while one or more subtrees are recorded.
+         */
+        std::vector<std::pair<size_t, Block>> captured;
+
+        /**
+         * \brief Number of subtrees that are being recorded.
+         */
+        size_t recording = 0;
+
+        /**
+         * \brief Scratch lists for collectDescendants.
+         */
+        std::vector<const Element*> walk;
+
+        std::vector<uuids::uuid> ids;
+
+        std::vector<uint64_t> hashes;
+    };
+}  // namespace floah
@@ -0,0 +1,78 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <bit>
+#include <cstdint>
+#include <string_view>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "compare.h"
+
+namespace floah
+{
+    /**
+     * \brief Mix a value into a hash.
+     * \param seed Hash.
+     * \param value Value.
+     */
+    inline void hashCombine(uint64_t& seed, const uint64_t value) noexcept
+    {
+        seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+    }
+
+    /**
+     * \brief Hash a string with FNV-1a. Unlike std::hash, the result does not change between runs.
+     * \param str String.
+     * \return Hash.
+     */
+    [[nodiscard]] inline uint64_t hashString(const std::string_view str) noexcept
+    {
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (const auto c : str)
+        {
+            h ^= static_cast<uint8_t>(c);
+            h *= 0x100000001b3ull;
+        }
+        return h;
+    }
+
+    /**
+     * \brief Mix a length into a hash. Relative lengths are hashed at the compareReference, so that lengths that are
+     * considered equal by isEqual also have the same hash.
+     * \param seed Hash.
+     * \param length Length.
+     */
+    inline void hashCombine(uint64_t& seed, const Length& length) noexcept
+    {
+        hashCombine(seed, length.isRelative() ? 1 : 0);
+        hashCombine(seed, static_cast<uint64_t>(static_cast<uint32_t>(length.get(compareReference))));
+    }
+
+    inline void hashCombine(uint64_t& seed, const Size& size) noexcept
+    {
+        hashCombine(seed, size.getWidth());
+        hashCombine(seed, size.getHeight());
+    }
+
+    inline void hashCombine(uint64_t& seed, const Margin& margin) noexcept
+    {
+        hashCombine(seed, margin.getLeft());
+        hashCombine(seed, margin.getTop());
+        hashCombine(seed, margin.getRight());
+        hashCombine(seed, margin.getBottom());
+    }
+
+    inline void hashCombine(uint64_t& seed, const Flex& flex) noexcept
+    {
+        hashCombine(seed, std::bit_cast<uint32_t>(flex.weight));
+        hashCombine(seed, flex.min);
+        hashCombine(seed, flex.max.has_value() ? 1 : 0);
+        if (flex.max) hashCombine(seed, *flex.max);
+    }
+}  // namespace floah
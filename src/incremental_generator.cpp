@@ -0,0 +1,122 @@
+#include "floah-layout/incremental_generator.h"
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-common/floah_error.h"
+#include "generator.h"
+#include "snapshot_node.h"
+
+namespace floah
+{
+    ////////////////////////////////////////////////////////////////
+    // Constructors.
+    ////////////////////////////////////////////////////////////////
+
+    IncrementalGenerator::IncrementalGenerator() = default;
+
+    IncrementalGenerator::~IncrementalGenerator() noexcept = default;
+
+    ////////////////////////////////////////////////////////////////
+    // Getters.
+    ////////////////////////////////////////////////////////////////
+
+    std::shared_ptr<const GeneratedBlocks> IncrementalGenerator::getResult() const noexcept
+    {
+        return front.load(std::memory_order_acquire);
+    }
+
+    bool IncrementalGenerator::isRunning() const noexcept { return back != nullptr; }
+
+    size_t IncrementalGenerator::getWrittenCount() const noexcept
+    {
+        // A layout without root element has no generator.
+        return generator ? generator->getWrittenCount() : 0;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Generate.
+    ////////////////////////////////////////////////////////////////
+
+    void IncrementalGenerator::start(std::shared_ptr<const LayoutSnapshot> snapshot, const GenerateOptions& opts)
+    {
+        cancel();
+
+        const auto& snap   = *snapshot;
+        auto        buffer = spare ? std::move(spare) : std::make_shared<GeneratedBlocks>();
+        spare.reset();
+        buffer->snapshot = std::move(snapshot);
+        options          = opts;
+        sink             = std::make_unique<VectorBlockSink>(buffer->blocks, &buffer->index);
+
+        if (snap.nodeCount == 0)
+        {
+            sink->begin(0);
+            sink->end(0);
+            back = std::move(buffer);
+            return;
+        }
+
+        // Everything that can throw before the first step is done here, so that a failed start leaves no state behind.
+        try
+        {
+            if (const GenerateStatus status = snap.validation; !status) throw FloahError(status.getMessage());
+
+            generator = std::make_unique<Generator<SnapshotTree>>(options, SnapshotTree(snap));
+            generator->begin(snap.getRoot(), snap.calculateRootBounds(), snap.elementCount, *sink);
+        }
+        catch (...)
+        {
+            generator.reset();
+            buffer->snapshot.reset();
+            spare = std::move(buffer);
+            throw;
+        }
+
+        back = std::move(buffer);
+    }
+
+    bool IncrementalGenerator::resume(const GenerateBudget& budget)
+    {
+        if (!back) return true;
+
+        // A layout without root element has no generator state.
+        if (back->snapshot->nodeCount > 0)
+        {
+            try
+            {
+                if (!generator->step(budget)) return false;
+            }
+            catch (...)
+            {
+                cancel();
+                throw;
+            }
+        }
+
+        // Publish. If no reader holds on to the previous front buffer, reuse it as the next back buffer.
+        generator.reset();
+        sink.reset();
+        auto old = front.exchange(std::move(back), std::memory_order_acq_rel);
+        back.reset();
+        if (old && old.use_count() == 1)
+        {
+            spare = std::const_pointer_cast<GeneratedBlocks>(std::move(old));
+            spare->snapshot.reset();
+        }
+
+        return true;
+    }
+
+    void IncrementalGenerator::cancel() noexcept
+    {
+        if (!back) return;
+
+        generator.reset();
+        sink.reset();
+        back->snapshot.reset();
+        spare = std::move(back);
+        back.reset();
+    }
+}  // namespace floah
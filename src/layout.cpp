@@ -1,79 +1,688 @@
 #include "floah-layout/layout.h"
 
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <functional>
+#include <new>
+
 ////////////////////////////////////////////////////////////////
 // Current target includes.
 ////////////////////////////////////////////////////////////////
 
+#include "floah-layout/layout_snapshot.h"
 #include "floah-common/floah_error.h"
+#include "generator.h"
 
 namespace floah
 {
+    namespace
+    {
+        [[nodiscard]] LayoutElement* findInTree(LayoutElement& elem, const uuids::uuid& id) noexcept
+        {
+            if (elem.getId() == id) return &elem;
+
+            for (const auto& c : elem.getChildren())
+            {
+                if (!c) continue;
+                if (auto* found = findInTree(*c, id)) return found;
+            }
+
+            return nullptr;
+        }
+
+        [[nodiscard]] size_t countTree(const LayoutElement& elem) noexcept
+        {
+            size_t count = 1;
+            for (const auto& c : elem.getChildren())
+            {
+                if (c) count += countTree(*c);
+            }
+            return count;
+        }
+
+        void insertTree(IdIndex<LayoutElement*>& index, LayoutElement& elem)
+        {
+            index.insert(elem.getId(), &elem);
+            for (const auto& c : elem.getChildren())
+            {
+                if (c) insertTree(index, *c);
+            }
+        }
+    }  // namespace
+
     ////////////////////////////////////////////////////////////////
     // Constructors.
     ////////////////////////////////////////////////////////////////
 
     Layout::Layout() = default;
 
+    Layout::Layout(Layout&& other) noexcept :
+        size(std::move(other.size)),
+        offset(std::move(other.offset)),
+        validation(other.validation.load(std::memory_order_relaxed)),
+        structureVersion(other.structureVersion),
+        elements(std::move(other.elements)),
+        elementIndexStale(other.elementIndexStale.exchange(false)),
+        root(std::move(other.root)),
+        lastSnapshot(std::move(other.lastSnapshot)),
+        transactionDepth(other.transactionDepth),
+        transactionChanged(other.transactionChanged),
+        transactionChangedRoot(other.transactionChangedRoot),
+        transactionChanges(std::move(other.transactionChanges)),
+        invalidatedElements(std::move(other.invalidatedElements)),
+        undoDepth(other.undoDepth),
+        undoLog(std::move(other.undoLog)),
+        undoStart(other.undoStart),
+        undoPositions(std::move(other.undoPositions)),
+        rootUndoPosition(other.rootUndoPosition)
+    {
+        if (root) root->setLayout(this);
+        other.invalidateStructure();
+    }
+
     Layout::~Layout() noexcept = default;
 
+    Layout& Layout::operator=(Layout&& other) noexcept
+    {
+        if (this == &other) return *this;
+        size                   = std::move(other.size);
+        offset                 = std::move(other.offset);
+        validation             = other.validation.load(std::memory_order_relaxed);
+        root                   = std::move(other.root);
+        elements               = std::move(other.elements);
+        elementIndexStale      = other.elementIndexStale.exchange(false);
+        structureVersion       = other.structureVersion;
+        lastSnapshot           = std::move(other.lastSnapshot);
+        transactionDepth       = other.transactionDepth;
+        transactionChanged     = other.transactionChanged;
+        transactionChangedRoot = other.transactionChangedRoot;
+        transactionChanges     = std::move(other.transactionChanges);
+        invalidatedElements    = std::move(other.invalidatedElements);
+        undoDepth              = other.undoDepth;
+        undoLog                = std::move(other.undoLog);
+        undoStart              = other.undoStart;
+        undoPositions          = std::move(other.undoPositions);
+        rootUndoPosition       = other.rootUndoPosition;
+        if (root) root->setLayout(this);
+        other.invalidateStructure();
+        return *this;
+    }
+
     ////////////////////////////////////////////////////////////////
     // Getters.
     ////////////////////////////////////////////////////////////////
 
-    Size& Layout::getSize() noexcept { return size; }
+    Size& Layout::getSize() noexcept
+    {
+        validation.store(unvalidated, std::memory_order_relaxed);
+        return size;
+    }
 
     const Size& Layout::getSize() const noexcept { return size; }
 
-    Size& Layout::getOffset() noexcept { return offset; }
+    Size& Layout::getOffset() noexcept
+    {
+        validation.store(unvalidated, std::memory_order_relaxed);
+        return offset;
+    }
 
     const Size& Layout::getOffset() const noexcept { return offset; }
 
     LayoutElement* Layout::getRootElement() const noexcept { return root.get(); }
 
+    uint64_t Layout::getStructureVersion() const noexcept { return structureVersion; }
+
+    LayoutElement* Layout::findElement(const uuids::uuid& id) const noexcept
+    {
+        if (!updateElementIndex()) return root ? findInTree(*root, id) : nullptr;
+
+        const auto* elem = elements.find(id);
+        return elem ? *elem : nullptr;
+    }
+
+    std::span<const uuids::uuid> Layout::getInvalidatedElements() const noexcept { return invalidatedElements; }
+
+    ////////////////////////////////////////////////////////////////
+    // Setters.
+    ////////////////////////////////////////////////////////////////
+
+    void Layout::setSize(const Size& s) noexcept
+    {
+        size = s;
+        validation.store(static_cast<uint8_t>(validateSize()), std::memory_order_relaxed);
+    }
+
+    void Layout::setOffset(const Size& o) noexcept
+    {
+        offset = o;
+        validation.store(static_cast<uint8_t>(validateSize()), std::memory_order_relaxed);
+    }
+
     ////////////////////////////////////////////////////////////////
     // ...
     ////////////////////////////////////////////////////////////////
 
-    std::vector<Block> Layout::generate() const
+    std::vector<Block> Layout::generate() const { return generate(GenerateOptions{}); }
+
+    std::vector<Block> Layout::generate(const GenerateOptions& options) const
+    {
+        // No index is returned, so do not build one.
+        std::vector<Block> blocks;
+        VectorBlockSink    sink(blocks);
+        generate(sink, options);
+        return blocks;
+    }
+
+    std::vector<Block> Layout::generate(BlockIndex& index) const
+    {
+        std::vector<Block> blocks;
+        generate(blocks, index);
+        return blocks;
+    }
+
+    void Layout::generate(std::vector<Block>& blocks, BlockIndex& index, const GenerateOptions& options) const
+    {
+        VectorBlockSink sink(blocks, &index);
+        generate(sink, options);
+    }
+
+    void Layout::generate(BlockSink& sink, const GenerateOptions& options) const
+    {
+        if (const GenerateStatus status = validate(); !status) throw FloahError(status.getMessage());
+
+        generateValidated(sink, options);
+    }
+
+    GenerateStatus Layout::tryGenerate(std::vector<Block>&    blocks,
+                                       BlockIndex&            index,
+                                       const GenerateOptions& options) const noexcept
+    {
+        if (const auto error = validate(); error != GenerateError::None) return error;
+
+        // The vector sink only throws when allocating, so every exception is mapped to a status.
+        VectorBlockSink sink(blocks, &index);
+        const auto      status = tryGenerateValidated(sink, options);
+        if (!status)
+        {
+            blocks.clear();
+            index.clear();
+        }
+        return status;
+    }
+
+    GenerateStatus Layout::tryGenerate(BlockSink& sink, const GenerateOptions& options) const
     {
-        if (!root) return {};
+        if (const auto error = validate(); error != GenerateError::None) return error;
 
-        if (size.getWidth().isRelative() || size.getHeight().isRelative())
-            throw FloahError("Cannot generate. Layout must have an absolute size.");
-        if (offset.getWidth().isRelative() || offset.getHeight().isRelative())
-            throw FloahError("Cannot generate. Layout must have an absolute offset.");
+        return tryGenerateValidated(sink, options);
+    }
+
+    GenerateError Layout::validate() const noexcept
+    {
+        if (!root) return GenerateError::None;
+
+        // Validation only depends on the size and offset, so it is redone only after those changed.
+        if (const auto cached = validation.load(std::memory_order_relaxed); cached != unvalidated)
+            return static_cast<GenerateError>(cached);
+        const auto error = validateSize();
+        validation.store(static_cast<uint8_t>(error), std::memory_order_relaxed);
+        return error;
+    }
+
+    GenerateError Layout::validateSize() const noexcept
+    {
+        if (size.getWidth().isRelative() || size.getHeight().isRelative()) return GenerateError::RelativeSize;
+        if (offset.getWidth().isRelative() || offset.getHeight().isRelative()) return GenerateError::RelativeOffset;
+        return GenerateError::None;
+    }
 
-        // Reserve enough space for all blocks to keep stable iterators.
+    GenerateStatus Layout::tryGenerateValidated(BlockSink& sink, const GenerateOptions& options) const
+    {
+        try
+        {
+            generateValidated(sink, options);
+        }
+        catch (const std::bad_alloc&)
+        {
+            return GenerateError::OutOfMemory;
+        }
+        return {};
+    }
+
+    void Layout::generateValidated(BlockSink& sink, const GenerateOptions& options) const
+    {
+        if (!root)
+        {
+            sink.begin(0);
+            sink.end(0);
+            return;
+        }
+
+        // Count blocks to reserve enough space.
         size_t count = 0;
         root->countBlocks(count);
-        std::vector<Block> blocks;
-        blocks.reserve(count);
 
-        // Calculate absolute bounds of root.
+        Generator<ElementTree> generator(options, ElementTree{});
+        generator.generate(*root, calculateRootBounds(), count, sink);
+    }
+
+    BBox Layout::calculateRootBounds() const noexcept
+    {
+        assert(root);
+        assert(validate() == GenerateError::None);
+
         const auto left   = root->getOuterMargin().getLeft().get(size.getWidth().get()) + offset.getWidth().get();
         const auto top    = root->getOuterMargin().getTop().get(size.getHeight().get()) + offset.getHeight().get();
         const auto width  = root->getSize().getWidth().get(size.getWidth().get());
         const auto height = root->getSize().getHeight().get(size.getHeight().get());
-        const BBox bb{.x0 = left, .y0 = top, .x1 = left + width, .y1 = top + height};
+        return BBox{.x0 = left, .y0 = top, .x1 = left + width, .y1 = top + height};
+    }
 
-        // Create root block and recurse on children.
-        auto& block = blocks.emplace_back(root->getId(), bb);
-        root->generate(blocks, block);
+    ////////////////////////////////////////////////////////////////
+    // Snapshots.
+    ////////////////////////////////////////////////////////////////
+
+    std::shared_ptr<const LayoutSnapshot> Layout::snapshot() const
+    {
+        lastSnapshot = LayoutSnapshot::capture(*this, lastSnapshot);
+        return lastSnapshot;
+    }
 
-        // Accumulate bounds of child elements.
-        std::function<BBox(const size_t)> func = [&blocks, &func](const size_t i) -> BBox {
-            auto& block = blocks[i];
+    void Layout::invalidateStructure() noexcept
+    {
+        if (transactionDepth == 0)
+        {
+            structureVersion++;
+            return;
+        }
 
-            BBox bounds = block.bounds;
-            for (size_t j = 0; j < block.childCount; j++) bounds += func(block.firstChild + j);
+        transactionChanged     = true;
+        transactionChangedRoot = true;
+    }
 
-            block.childBounds = bounds;
+    void Layout::invalidateStructure(const LayoutElement& elem) noexcept
+    {
+        if (transactionDepth == 0)
+        {
+            structureVersion++;
+            return;
+        }
 
-            return bounds;
-        };
-        static_cast<void>(func(0));
+        // Defer the version increment to the end of the transaction.
+        transactionChanged = true;
+        if (transactionChangedRoot) return;
 
-        return blocks;
+        try
+        {
+            transactionChanges.push_back(elem.getId());
+        }
+        catch (...)
+        {
+            transactionChangedRoot = true;
+        }
+    }
+
+    void Layout::invalidateElementIndex() noexcept { elementIndexStale.store(true, std::memory_order_relaxed); }
+
+    bool Layout::updateElementIndex() const noexcept
+    {
+        if (!elementIndexStale.load(std::memory_order_acquire)) return true;
+
+        std::scoped_lock lock(elementIndexMutex);
+        if (!elementIndexStale.load(std::memory_order_relaxed)) return true;
+
+        try
+        {
+            elements.clear();
+            if (root) insertTree(elements, *root);
+        }
+        catch (...)
+        {
+            elements.clear();
+            return false;
+        }
+
+        elementIndexStale.store(false, std::memory_order_release);
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Transactions.
+    ////////////////////////////////////////////////////////////////
+
+    void Layout::beginTransaction()
+    {
+        // Make sure the fallback in endTransaction does not need to allocate.
+        if (transactionDepth == 0) invalidatedElements.reserve(1);
+        transactionDepth++;
+    }
+
+    void Layout::endTransaction() noexcept
+    {
+        assert(transactionDepth > 0);
+        if (--transactionDepth > 0) return;
+
+        invalidatedElements.clear();
+        if (!transactionChanged) return;
+
+        structureVersion++;
+        try
+        {
+            mergeTransactionChanges();
+        }
+        catch (...)
+        {
+            invalidatedElements.clear();
+            if (root) invalidatedElements.push_back(root->getId());
+        }
+
+        transactionChanged     = false;
+        transactionChangedRoot = false;
+        transactionChanges.clear();
+    }
+
+    void Layout::mergeTransactionChanges()
+    {
+        if (!root) return;
+        if (transactionChangedRoot)
+        {
+            invalidatedElements.push_back(root->getId());
+            return;
+        }
+
+        // Value is true once the element was handled.
+        IdIndex<bool> changed;
+        changed.reserve(transactionChanges.size());
+        for (const auto& id : transactionChanges) changed.insert(id, false);
+
+        for (const auto& id : transactionChanges)
+        {
+            auto* handled = changed.find(id);
+            if (*handled) continue;
+            *handled = true;
+
+            // Skip elements that were removed and elements inside of another changed subtree.
+            const auto* elem = findElement(id);
+            if (!elem) continue;
+
+            auto inside = false;
+            for (const auto* p = elem->getParent(); p && !inside; p = p->getParent())
+                inside = changed.find(p->getId()) != nullptr;
+            if (!inside) invalidatedElements.push_back(id);
+        }
+    }
+
+    size_t Layout::beginUndoLog() noexcept
+    {
+        undoDepth++;
+        return std::exchange(undoStart, undoLog.size());
+    }
+
+    void Layout::endUndoLog(const size_t previousStart, const bool rollback) noexcept
+    {
+        assert(undoDepth > 0);
+
+        if (rollback)
+        {
+            // Make room in the element index for every copied element, so that restoring can register the copies that
+            // are put back. Without an index, elements are searched for in the tree instead.
+            auto             indexed = false;
+            const auto       updated = updateElementIndex();
+            std::scoped_lock lock(elementIndexMutex);
+            if (updated)
+            {
+                try
+                {
+                    auto count = elements.size();
+                    for (auto i = undoStart; i < undoLog.size(); i++)
+                    {
+                        if (undoLog[i].copy) count += countTree(*undoLog[i].copy);
+                    }
+                    elements.reserve(count);
+                    indexed = true;
+                }
+                catch (...)
+                {
+                }
+            }
+
+            // Later copies are taken from a tree in which the changes covered by earlier copies were already made, so
+            // undo in reverse order. Elements are only moved between the layout and the copies until all entries are
+            // restored, so every element stays at the same address and the element index stays valid.
+            for (auto i = undoLog.size(); i > undoStart; i--)
+            {
+                auto& entry = undoLog[i - 1];
+                restoreSubtree(entry.copy, entry.id, indexed);
+                if (entry.id.is_nil())
+                {
+                    if (rootUndoPosition == i - 1) rootUndoPosition = noUndoPosition;
+                }
+                else if (const auto* position = undoPositions.find(entry.id); position && *position == i - 1)
+                    undoPositions.erase(entry.id);
+            }
+
+            // Destroy the copies, together with the elements they replaced or that were added in the transaction.
+            undoLog.erase(undoLog.begin() + static_cast<std::ptrdiff_t>(undoStart), undoLog.end());
+            invalidateElementIndex();
+        }
+
+        undoStart = previousStart;
+        if (--undoDepth > 0) return;
+
+        undoLog.clear();
+        undoPositions.clear();
+        rootUndoPosition = noUndoPosition;
+    }
+
+    void Layout::saveSubtree(const LayoutElement& elem)
+    {
+        if (undoDepth == 0) return;
+        if (rootUndoPosition != noUndoPosition && rootUndoPosition >= undoStart) return;
+
+        // Rolling back can put the copy in place of the element, which requires the pointer through which the parent
+        // owns it. If the parent does not expose its children, save the subtree of the parent instead.
+        const auto* target  = &elem;
+        const auto  isOwned = [&target](const LayoutElementPtr& slot) { return slot.get() == target; };
+        while (target->parent && std::ranges::none_of(target->parent->getChildSlots(), isOwned))
+            target = target->parent;
+
+        // A copy of this subtree or of the subtree of an ancestor that was saved in the innermost transaction already
+        // restores the state before this change.
+        for (const auto* e = target; e; e = e->getParent())
+        {
+            if (const auto* position = undoPositions.find(e->getId()); position && *position >= undoStart) return;
+        }
+
+        // Reserve first, so that nothing is modified if copying fails.
+        auto copy = target->cloneTree(nullptr);
+        undoLog.reserve(undoLog.size() + 1);
+        if (auto* position = undoPositions.find(target->getId()))
+            *position = undoLog.size();
+        else
+            undoPositions.insert(target->getId(), undoLog.size());
+        undoLog.push_back(UndoEntry{.id = target->getId(), .copy = std::move(copy)});
+    }
+
+    void Layout::saveRoot()
+    {
+        if (undoDepth == 0) return;
+        if (rootUndoPosition != noUndoPosition && rootUndoPosition >= undoStart) return;
+
+        auto copy = root ? root->cloneTree(nullptr) : nullptr;
+        undoLog.reserve(undoLog.size() + 1);
+        rootUndoPosition = undoLog.size();
+        undoLog.push_back(UndoEntry{.id = {}, .copy = std::move(copy)});
+    }
+
+    void Layout::restoreSubtree(LayoutElementPtr& copy, const uuids::uuid& id, const bool indexed) noexcept
+    {
+        // The whole tree was saved. Put the copy in place of the root element, and restore it like any other element.
+        if (id.is_nil())
+        {
+            root.swap(copy);
+            attachElement(root, nullptr);
+            attachElement(copy, nullptr);
+            restoreElement(root, nullptr, indexed);
+            invalidateStructure();
+            return;
+        }
+
+        auto* elem = findRestoredElement(id, indexed);
+        if (!elem) return;
+
+        // The element takes over the children of its copy. If its type does not support that, the copy is put in its
+        // place instead.
+        if (!elem->swapChildren(*copy))
+        {
+            LayoutElement* owner = nullptr;
+            auto*          slot  = findElementSlot(*elem, owner);
+            if (!slot) return;
+
+            slot->swap(copy);
+            attachElement(*slot, owner);
+            attachElement(copy, nullptr);
+            elem = slot->get();
+            if (indexed) *elements.find(id) = elem;
+        }
+
+        for (auto& child : elem->getChildSlots()) restoreElement(child, elem, indexed);
+        invalidateStructure(*elem);
+    }
+
+    void Layout::restoreElement(LayoutElementPtr& slot, LayoutElement* owner, const bool indexed) noexcept
+    {
+        if (!slot) return;
+
+        // Move the element with the same identifier to this position, unless that would make it its own ancestor, and
+        // let it take over the children of the copy. The copy takes over the former position and children of the
+        // element, so that every element stays owned by something.
+        auto* elem = findRestoredElement(slot->getId(), indexed);
+        for (const auto* p = owner; p && elem; p = p->parent)
+        {
+            if (p == elem) elem = nullptr;
+        }
+
+        LayoutElement* elemOwner = nullptr;
+        auto*          elemSlot  = elem && elem != slot.get() ? findElementSlot(*elem, elemOwner) : nullptr;
+        if (elemSlot && elem->swapChildren(*slot))
+        {
+            slot.swap(*elemSlot);
+            attachElement(slot, owner);
+            attachElement(*elemSlot, elemOwner);
+        }
+        else if (indexed && elem != slot.get())
+        {
+            // The copy stays, so it is now the element with this identifier.
+            if (auto* e = elements.find(slot->getId()))
+                *e = slot.get();
+            else
+            {
+                try
+                {
+                    elements.insert(slot->getId(), slot.get());
+                }
+                catch (...)
+                {
+                }
+            }
+        }
+
+        for (auto& child : slot->getChildSlots()) restoreElement(child, slot.get(), indexed);
+    }
+
+    LayoutElement* Layout::findRestoredElement(const uuids::uuid& id, const bool indexed) noexcept
+    {
+        if (!indexed) return root ? findInTree(*root, id) : nullptr;
+
+        auto* elem = elements.find(id);
+        return elem ? *elem : nullptr;
+    }
+
+    LayoutElementPtr* Layout::findElementSlot(const LayoutElement& elem, LayoutElement*& owner) noexcept
+    {
+        owner = elem.parent;
+        if (owner)
+        {
+            for (auto& slot : owner->getChildSlots())
+            {
+                if (slot.get() == &elem) return &slot;
+            }
+            return nullptr;
+        }
+
+        if (root.get() == &elem) return &root;
+        for (auto& entry : undoLog)
+        {
+            if (entry.copy.get() == &elem) return &entry.copy;
+        }
+        return nullptr;
+    }
+
+    void Layout::attachElement(LayoutElementPtr& slot, LayoutElement* owner) noexcept
+    {
+        if (!slot) return;
+        slot->parent = owner;
+        slot->layout = &slot == &root ? this : nullptr;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Memory.
+    ////////////////////////////////////////////////////////////////
+
+    MemoryUsage Layout::memoryUsage() const
+    {
+        MemoryUsage usage;
+        {
+            std::scoped_lock lock(elementIndexMutex);
+            usage.layoutBytes = sizeof(Layout) + elements.getAllocatedBytes();
+            usage.wastedBytes = elements.getUnusedBytes();
+        }
+
+        std::vector<const LayoutElement*> stack;
+        if (root) stack.push_back(root.get());
+        while (!stack.empty())
+        {
+            const auto* elem = stack.back();
+            stack.pop_back();
+            elem->addMemoryUsage(usage);
+            for (const auto& c : elem->getChildren())
+            {
+                if (c) stack.push_back(c.get());
+            }
+        }
+
+        std::ranges::stable_sort(usage.elementTypes, std::ranges::greater{}, &MemoryUsage::ElementType::bytes);
+        return usage;
+    }
+
+    MemoryUsage Layout::memoryUsage(const std::vector<Block>& blocks, const BlockIndex& index) const
+    {
+        auto usage             = memoryUsage();
+        usage.blockCount       = blocks.size();
+        usage.blockBytes       = blocks.capacity() * sizeof(Block) + index.getAllocatedBytes();
+        usage.wastedBlockBytes = (blocks.capacity() - blocks.size()) * sizeof(Block) + index.getUnusedBytes();
+        return usage;
+    }
+
+    void Layout::shrinkToFit()
+    {
+        elements.shrinkToFit();
+
+        std::vector<LayoutElement*> stack;
+        if (root) stack.push_back(root.get());
+        while (!stack.empty())
+        {
+            auto* elem = stack.back();
+            stack.pop_back();
+            elem->shrinkToFit();
+            for (const auto& c : elem->getChildren())
+            {
+                if (c) stack.push_back(c.get());
+            }
+        }
     }
 
 }  // namespace floah
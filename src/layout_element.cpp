@@ -1,13 +1,37 @@
 #include "floah-layout/layout_element.h"
 
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <typeinfo>
+#include <utility>
+
 ////////////////////////////////////////////////////////////////
 // External includes.
 ////////////////////////////////////////////////////////////////
 
 #include "uuid_system_generator.h"
 
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-layout/layout.h"
+#include "compare.h"
+#include "hash.h"
+
 namespace floah
 {
+    namespace
+    {
+        /**
+         * \brief If true, copied elements take over the identifier of the original instead of generating a new one.
+         * Set by LayoutElement::cloneTree while it runs.
+         */
+        thread_local bool copyIdentifiers = false;
+    }  // namespace
+
     ////////////////////////////////////////////////////////////////
     // Constructors.
     ////////////////////////////////////////////////////////////////
@@ -15,13 +39,26 @@ namespace floah
     LayoutElement::LayoutElement() : id(uuids::uuid_system_generator{}()) {}
 
     LayoutElement::LayoutElement(const LayoutElement& other) :
-        id(uuids::uuid_system_generator{}()),
+        id(copyIdentifiers ? other.id : uuids::uuid_system_generator{}()),
         size(other.size),
         innerMargin(other.innerMargin),
-        outerMargin(other.outerMargin)
+        outerMargin(other.outerMargin),
+        flex(other.flex)
     {
     }
 
+    LayoutElement::LayoutElement(LayoutElement&& other) noexcept :
+        id(other.id),
+        size(std::move(other.size)),
+        innerMargin(std::move(other.innerMargin)),
+        outerMargin(std::move(other.outerMargin)),
+        flex(std::move(other.flex))
+    {
+        // The identifier and child elements of other leave its layout.
+        if (auto* l = other.getLayout()) l->invalidateElementIndex();
+        other.id = uuids::uuid{};
+    }
+
     LayoutElement::~LayoutElement() noexcept = default;
 
     LayoutElement& LayoutElement::operator=(const LayoutElement& other)
@@ -29,6 +66,23 @@ namespace floah
         size        = other.size;
         innerMargin = other.innerMargin;
         outerMargin = other.outerMargin;
+        flex        = other.flex;
+        return *this;
+    }
+
+    LayoutElement& LayoutElement::operator=(LayoutElement&& other) noexcept
+    {
+        if (this == &other) return *this;
+
+        // Child elements are moved by derived classes, which add them to the layout again in reparentChildren.
+        if (auto* l = getLayout()) l->invalidateElementIndex();
+        if (auto* l = other.getLayout()) l->invalidateElementIndex();
+
+        id          = std::exchange(other.id, uuids::uuid{});
+        size        = std::move(other.size);
+        innerMargin = std::move(other.innerMargin);
+        outerMargin = std::move(other.outerMargin);
+        flex        = std::move(other.flex);
         return *this;
     }
 
@@ -41,17 +95,34 @@ namespace floah
 
     void LayoutElement::cloneImpl(Layout* l, LayoutElement* p)
     {
-        layout = l;
+        layout = p ? nullptr : l;
         parent = p;
     }
 
+    LayoutElementPtr LayoutElement::cloneTree(Layout* l) const
+    {
+        struct Guard
+        {
+            bool previous = std::exchange(copyIdentifiers, true);
+
+            ~Guard() noexcept { copyIdentifiers = previous; }
+        } guard;
+
+        return clone(l, nullptr);
+    }
+
     ////////////////////////////////////////////////////////////////
     // Getters.
     ////////////////////////////////////////////////////////////////
 
     const uuids::uuid& LayoutElement::getId() const noexcept { return id; }
 
-    Layout* LayoutElement::getLayout() const noexcept { return layout; }
+    Layout* LayoutElement::getLayout() const noexcept
+    {
+        const auto* elem = this;
+        while (elem->parent) elem = elem->parent;
+        return elem->layout;
+    }
 
     LayoutElement* LayoutElement::getParent() const noexcept { return parent; }
 
@@ -67,24 +138,100 @@ namespace floah
 
     const Margin& LayoutElement::getOuterMargin() const noexcept { return outerMargin; }
 
+    Flex& LayoutElement::getFlex() noexcept { return flex; }
+
+    const Flex& LayoutElement::getFlex() const noexcept { return flex; }
+
+    bool LayoutElement::isLayoutEqual(const LayoutElement& other) const noexcept
+    {
+        return typeid(*this) == typeid(other) && isEqual(size, other.size) && isEqual(innerMargin, other.innerMargin) &&
+               isEqual(outerMargin, other.outerMargin) && isEqual(flex, other.flex);
+    }
+
+    uint64_t LayoutElement::getLayoutHash() const noexcept
+    {
+        auto h = hashString(typeid(*this).name());
+        hashCombine(h, size);
+        hashCombine(h, innerMargin);
+        hashCombine(h, outerMargin);
+        hashCombine(h, flex);
+        return h;
+    }
+
+    std::span<const LayoutElementPtr> LayoutElement::getChildren() const noexcept { return {}; }
+
     ////////////////////////////////////////////////////////////////
     // Setters.
     ////////////////////////////////////////////////////////////////
 
     void LayoutElement::setLayout(Layout* l) noexcept { layout = l; }
 
-    void LayoutElement::setLayout(Layout* l, LayoutElement& elem) noexcept { elem.setLayout(l); }
-
     void LayoutElement::makeChild(LayoutElement& elem)
     {
-        if (elem.layout != layout) elem.setLayout(layout);
+        elem.layout = nullptr;
         elem.parent = this;
+        invalidateMembership();
     }
 
     void LayoutElement::removeChild(LayoutElement& elem)
     {
-        if (elem.layout != nullptr) elem.setLayout(nullptr);
         elem.parent = nullptr;
+        invalidateMembership();
+    }
+
+    void LayoutElement::makeChildren(const std::span<const LayoutElementPtr> elems)
+    {
+        for (const auto& elem : elems)
+        {
+            if (!elem) continue;
+            elem->layout = nullptr;
+            elem->parent = this;
+        }
+        invalidateMembership();
+    }
+
+    void LayoutElement::removeChildren(const std::span<const LayoutElementPtr> elems)
+    {
+        for (const auto& elem : elems)
+        {
+            if (elem) elem->parent = nullptr;
+        }
+        invalidateMembership();
+    }
+
+    void LayoutElement::invalidateStructure() const noexcept
+    {
+        if (auto* l = getLayout()) l->invalidateStructure(*this);
+    }
+
+    void LayoutElement::invalidateMembership() const noexcept
+    {
+        if (auto* l = getLayout())
+        {
+            l->invalidateElementIndex();
+            l->invalidateStructure(*this);
+        }
+    }
+
+    void LayoutElement::prepareStructureChange() const
+    {
+        if (auto* l = getLayout()) l->saveSubtree(*this);
+    }
+
+    void LayoutElement::reparentChildren() noexcept
+    {
+        for (const auto& c : getChildren())
+        {
+            if (c) c->parent = this;
+        }
+        if (auto* l = getLayout()) l->invalidateElementIndex();
+    }
+
+    std::span<LayoutElementPtr> LayoutElement::getChildSlots() noexcept { return {}; }
+
+    bool LayoutElement::swapChildren(LayoutElement& other) noexcept
+    {
+        return getChildren().empty() && other.getChildren().empty();
     }
 
     ////////////////////////////////////////////////////////////////
@@ -93,5 +240,52 @@ namespace floah
 
     void LayoutElement::countBlocks(size_t& count) const noexcept { count++; }
 
-    void LayoutElement::generate(std::vector<Block>&, Block&) const {}
+    void LayoutElement::layoutChildren(const BBox&, std::span<BBox>, LayoutScratch&) const {}
+
+    void LayoutElement::generate(std::vector<Block>& blocks, Block& block) const
+    {
+        // Depth-first, appending all children of an element at once, as the recursive implementations used to.
+        std::vector<std::pair<const LayoutElement*, Block*>> stack{{this, &block}};
+        std::vector<BBox>                                    childBounds;
+        LayoutScratch                                        scratch;
+        while (!stack.empty())
+        {
+            const auto [elem, b] = stack.back();
+            stack.pop_back();
+
+            const auto children = elem->getChildren();
+            if (children.empty()) continue;
+
+            childBounds.assign(children.size(), BBox{});
+            scratch.reset();
+            elem->layoutChildren(b->bounds, childBounds, scratch);
+
+            const auto first = blocks.size();
+            for (size_t i = 0; i < children.size(); i++)
+            {
+                if (children[i])
+                    blocks.push_back(Block{.id = children[i]->getId(), .bounds = childBounds[i], .childBounds = {}});
+            }
+            b->firstChild = first;
+            b->childCount = blocks.size() - first;
+
+            for (auto i = children.size(), index = blocks.size(); i > 0; i--)
+            {
+                if (children[i - 1]) stack.emplace_back(children[i - 1].get(), &blocks[--index]);
+            }
+        }
+    }
+
+    bool LayoutElement::getContentClip(const BBox&, BBox&) const noexcept { return false; }
+
+    ////////////////////////////////////////////////////////////////
+    // Memory.
+    ////////////////////////////////////////////////////////////////
+
+    void LayoutElement::addMemoryUsage(MemoryUsage& usage) const
+    {
+        usage.addElement(typeid(*this).name(), sizeof(LayoutElement), 0);
+    }
+
+    void LayoutElement::shrinkToFit() {}
 }  // namespace floah
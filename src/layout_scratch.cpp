@@ -0,0 +1,89 @@
+#include "floah-layout/layout_scratch.h"
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <limits>
+#include <new>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-layout/generate_cache.h"
+
+namespace floah
+{
+    namespace
+    {
+        constexpr size_t minChunkSize = 4096;
+    }  // namespace
+
+    ////////////////////////////////////////////////////////////////
+    // Constructors.
+    ////////////////////////////////////////////////////////////////
+
+    LayoutScratch::LayoutScratch() = default;
+
+    LayoutScratch::LayoutScratch(GenerateCache* c) : cache(c) {}
+
+    LayoutScratch::LayoutScratch(LayoutScratch&&) noexcept = default;
+
+    LayoutScratch::~LayoutScratch() noexcept = default;
+
+    LayoutScratch& LayoutScratch::operator=(LayoutScratch&&) noexcept = default;
+
+    ////////////////////////////////////////////////////////////////
+    // Getters.
+    ////////////////////////////////////////////////////////////////
+
+    size_t LayoutScratch::getAllocatedBytes() const noexcept
+    {
+        size_t bytes = 0;
+        for (const auto& chunk : chunks) bytes += chunk.size;
+        return bytes;
+    }
+
+    LineBreaks* LayoutScratch::getLineBreaks(const uuids::uuid& id)
+    {
+        return cache ? cache->getLineBreaks(id) : nullptr;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Allocation.
+    ////////////////////////////////////////////////////////////////
+
+    void LayoutScratch::reset()
+    {
+        used = 0;
+        if (chunks.size() <= 1) return;
+
+        // Replace all chunks with a single one that fits everything that was allocated since the last reset.
+        const auto bytes = getAllocatedBytes();
+        chunks.clear();
+        chunks.push_back(Chunk{.memory = std::make_unique_for_overwrite<std::byte[]>(bytes), .size = bytes});
+    }
+
+    std::byte* LayoutScratch::allocateBytes(const size_t count, const size_t size, const size_t alignment)
+    {
+        // Report a size that cannot be represented like new[] does, so that callers handle all failed allocations
+        // alike.
+        if (count > std::numeric_limits<size_t>::max() / size) throw std::bad_array_new_length();
+        const auto bytes = count * size;
+
+        auto offset = (used + alignment - 1) / alignment * alignment;
+        if (chunks.empty() || offset + bytes > chunks.back().size)
+        {
+            // Grow geometrically, so that the number of chunks stays logarithmic in the total size.
+            const auto last = chunks.empty() ? 0 : chunks.back().size;
+            const auto n    = std::max({bytes, last * 2, minChunkSize});
+            chunks.push_back(Chunk{.memory = std::make_unique_for_overwrite<std::byte[]>(n), .size = n});
+            offset = 0;
+        }
+
+        used = offset + bytes;
+        return chunks.back().memory.get() + offset;
+    }
+}  // namespace floah
@@ -0,0 +1,349 @@
+#include "floah-layout/layout_snapshot.h"
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <new>
+#include <typeinfo>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-layout/elements/grid.h"
+#include "floah-layout/elements/horizontal_flow.h"
+#include "floah-layout/elements/scroll_view.h"
+#include "floah-layout/elements/vertical_flow.h"
+#include "floah-layout/elements/wrap_flow.h"
+#include "floah-common/floah_error.h"
+#include "compare.h"
+#include "generator.h"
+#include "snapshot_node.h"
+
+namespace floah
+{
+    namespace
+    {
+        [[nodiscard]] SnapshotNodeKind getKind(const LayoutElement& elem) noexcept
+        {
+            const auto& type = typeid(elem);
+            if (type == typeid(LayoutElement)) return SnapshotNodeKind::Element;
+            if (type == typeid(HorizontalFlow)) return SnapshotNodeKind::HorizontalFlow;
+            if (type == typeid(VerticalFlow)) return SnapshotNodeKind::VerticalFlow;
+            if (type == typeid(WrapFlow)) return SnapshotNodeKind::WrapFlow;
+            if (type == typeid(Grid)) return SnapshotNodeKind::Grid;
+            if (type == typeid(ScrollView)) return SnapshotNodeKind::ScrollView;
+            return SnapshotNodeKind::Custom;
+        }
+
+        /**
+         * \brief Alignments of a built-in element type that has them.
+         */
+        template<typename T>
+        void getAlignment(const LayoutElement& elem, HorizontalAlignment& hor, VerticalAlignment& ver) noexcept
+        {
+            const auto& e = static_cast<const T&>(elem);
+            hor           = e.getHorizontalAlignment();
+            ver           = e.getVerticalAlignment();
+        }
+    }  // namespace
+
+    ////////////////////////////////////////////////////////////////
+    // SnapshotNode.
+    ////////////////////////////////////////////////////////////////
+
+    bool SnapshotNode::isEqual(const SnapshotNode& other) const noexcept
+    {
+        if (kind != other.kind || kind == SnapshotNodeKind::Custom) return false;
+        if (kind == SnapshotNodeKind::Empty) return true;
+
+        return id == other.id && layoutHash == other.layoutHash && firstChild == other.firstChild &&
+               childCount == other.childCount && rowCount == other.rowCount && columnCount == other.columnCount &&
+               spanColumns == other.spanColumns && spanRows == other.spanRows && horAlign == other.horAlign &&
+               verAlign == other.verAlign && scrollX == other.scrollX && scrollY == other.scrollY &&
+               floah::isEqual(size, other.size) && floah::isEqual(innerMargin, other.innerMargin) &&
+               floah::isEqual(outerMargin, other.outerMargin) && floah::isEqual(flex, other.flex) &&
+               floah::isEqual(contentSize, other.contentSize);
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // SnapshotTree.
+    ////////////////////////////////////////////////////////////////
+
+    SnapshotChildren SnapshotTree::getChildren(const SnapshotNode& node) const noexcept
+    {
+        return SnapshotChildren(snapshot->chunks, node.firstChild, node.childCount);
+    }
+
+    bool SnapshotTree::getContentClip(const SnapshotNode& node, const BBox& bounds, BBox& clip) const noexcept
+    {
+        switch (node.kind)
+        {
+        case SnapshotNodeKind::ScrollView: clip = ScrollView::calculateViewport(node.innerMargin, bounds); return true;
+        case SnapshotNodeKind::Custom: return snapshot->customElements[node.custom]->getContentClip(bounds, clip);
+        default: return false;
+        }
+    }
+
+    void SnapshotTree::layoutChildren(const SnapshotNode&   node,
+                                      const BBox&           bounds,
+                                      const std::span<BBox> childBounds,
+                                      LayoutScratch&        scratch) const
+    {
+        const auto children = getChildren(node);
+        switch (node.kind)
+        {
+        case SnapshotNodeKind::HorizontalFlow:
+            HorizontalFlow::layoutNode(node, children, bounds, childBounds, scratch);
+            break;
+        case SnapshotNodeKind::VerticalFlow:
+            VerticalFlow::layoutNode(node, children, bounds, childBounds, scratch);
+            break;
+        case SnapshotNodeKind::WrapFlow: WrapFlow::layoutNode(node, children, bounds, childBounds, scratch); break;
+        case SnapshotNodeKind::Grid: Grid::layoutNode(node, children, bounds, childBounds, scratch); break;
+        case SnapshotNodeKind::ScrollView: ScrollView::layoutNode(node, children, bounds, childBounds); break;
+        case SnapshotNodeKind::Custom:
+            snapshot->customElements[node.custom]->layoutChildren(bounds, childBounds, scratch);
+            break;
+        default: break;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Constructors.
+    ////////////////////////////////////////////////////////////////
+
+    LayoutSnapshot::LayoutSnapshot() = default;
+
+    LayoutSnapshot::~LayoutSnapshot() noexcept = default;
+
+    std::shared_ptr<const LayoutSnapshot> LayoutSnapshot::capture(const Layout&                                layout,
+                                                                  const std::shared_ptr<const LayoutSnapshot>& previous)
+    {
+        std::shared_ptr<LayoutSnapshot> snap(new LayoutSnapshot());
+        snap->size             = layout.size;
+        snap->offset           = layout.offset;
+        snap->validation       = layout.validate();
+        snap->structureVersion = layout.structureVersion;
+
+        // Element each node is captured from. Custom elements and their descendants also have a copy, owned by the
+        // copy of the outermost custom element.
+        struct Source
+        {
+            const LayoutElement*                 element = nullptr;
+            const LayoutElement*                 copy    = nullptr;
+            std::shared_ptr<const LayoutElement> owner;
+        };
+
+        // Breadth-first, so that the children of every element get consecutive nodes.
+        std::vector<SnapshotNode> nodes;
+        std::vector<Source>       sources;
+        if (layout.root)
+        {
+            nodes.emplace_back();
+            sources.push_back(Source{.element = layout.root.get(), .copy = nullptr, .owner = nullptr});
+        }
+
+        for (size_t i = 0; i < nodes.size(); i++)
+        {
+            auto [element, copy, owner] = sources[i];
+            if (!element) continue;
+
+            // Copy the node, since adding the children below invalidates references into nodes.
+            auto node        = nodes[i];
+            node.kind        = getKind(*element);
+            node.id          = element->getId();
+            node.layoutHash  = element->getLayoutHash();
+            node.size        = element->getSize();
+            node.innerMargin = element->getInnerMargin();
+            node.outerMargin = element->getOuterMargin();
+            node.flex        = element->getFlex();
+            const Grid* grid = nullptr;
+            switch (node.kind)
+            {
+            case SnapshotNodeKind::HorizontalFlow:
+                getAlignment<HorizontalFlow>(*element, node.horAlign, node.verAlign);
+                break;
+            case SnapshotNodeKind::VerticalFlow:
+                getAlignment<VerticalFlow>(*element, node.horAlign, node.verAlign);
+                break;
+            case SnapshotNodeKind::WrapFlow: getAlignment<WrapFlow>(*element, node.horAlign, node.verAlign); break;
+            case SnapshotNodeKind::Grid:
+                grid = static_cast<const Grid*>(element);
+                getAlignment<Grid>(*element, node.horAlign, node.verAlign);
+                node.rowCount    = static_cast<uint32_t>(grid->getRowCount());
+                node.columnCount = static_cast<uint32_t>(grid->getColumnCount());
+                break;
+            case SnapshotNodeKind::ScrollView:
+            {
+                const auto& scrollView = static_cast<const ScrollView&>(*element);
+                node.contentSize       = scrollView.getContentSize();
+                node.scrollX           = scrollView.getScrollX();
+                node.scrollY           = scrollView.getScrollY();
+                break;
+            }
+            case SnapshotNodeKind::Custom:
+                // Custom elements can only be laid out by themselves, so lay out a copy of the subtree.
+                if (!copy)
+                {
+                    owner = element->clone(nullptr, nullptr);
+                    copy  = owner.get();
+                }
+                node.custom = static_cast<uint32_t>(snap->customElements.size());
+                snap->customElements.emplace_back(owner, copy);
+                break;
+            default: break;
+            }
+
+            const auto children     = element->getChildren();
+            const auto copyChildren = copy ? copy->getChildren() : std::span<const LayoutElementPtr>{};
+            node.firstChild         = static_cast<uint32_t>(nodes.size());
+            node.childCount         = static_cast<uint32_t>(children.size());
+            nodes[i]                = node;
+            snap->elementCount++;
+
+            for (size_t k = 0; k < children.size(); k++)
+            {
+                auto& child = nodes.emplace_back();
+                sources.push_back(Source{.element = children[k].get(),
+                                         .copy    = copy ? copyChildren[k].get() : nullptr,
+                                         .owner   = owner});
+                if (grid && children[k])
+                {
+                    const auto span   = grid->getSpan(k % grid->getColumnCount(), k / grid->getColumnCount());
+                    child.spanColumns = static_cast<uint32_t>(span.columns);
+                    child.spanRows    = static_cast<uint32_t>(span.rows);
+                }
+            }
+        }
+
+        // Share every chunk that is equal to the chunk at the same position in the previous snapshot.
+        const auto equal = [](const SnapshotNode& lhs, const SnapshotNode& rhs) { return lhs.isEqual(rhs); };
+        snap->nodeCount  = nodes.size();
+        for (size_t first = 0; first < nodes.size(); first += snapshotChunkSize)
+        {
+            const auto last  = std::min(first + snapshotChunkSize, nodes.size());
+            const auto chunk = first / snapshotChunkSize;
+            if (previous && chunk < previous->chunks.size())
+            {
+                const auto& prev = previous->chunks[chunk];
+                if (std::ranges::equal(nodes.begin() + first, nodes.begin() + last, prev->begin(), prev->end(), equal))
+                {
+                    snap->chunks.push_back(prev);
+                    continue;
+                }
+            }
+
+            snap->chunks.push_back(std::make_shared<const SnapshotChunk>(nodes.begin() + first, nodes.begin() + last));
+        }
+
+        if (previous && snap->isEqual(*previous)) return previous;
+        return snap;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Getters.
+    ////////////////////////////////////////////////////////////////
+
+    uint64_t LayoutSnapshot::getStructureVersion() const noexcept { return structureVersion; }
+
+    const Size& LayoutSnapshot::getSize() const noexcept { return size; }
+
+    const Size& LayoutSnapshot::getOffset() const noexcept { return offset; }
+
+    size_t LayoutSnapshot::getElementCount() const noexcept { return elementCount; }
+
+    bool LayoutSnapshot::isEqual(const LayoutSnapshot& other) const noexcept
+    {
+        return floah::isEqual(size, other.size) && floah::isEqual(offset, other.offset) &&
+               validation == other.validation && structureVersion == other.structureVersion &&
+               nodeCount == other.nodeCount && chunks == other.chunks;
+    }
+
+    const SnapshotNode& LayoutSnapshot::getRoot() const noexcept
+    {
+        assert(nodeCount > 0);
+        return chunks.front()->front();
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Generate.
+    ////////////////////////////////////////////////////////////////
+
+    void LayoutSnapshot::generate(std::vector<Block>& blocks, BlockIndex& index, const GenerateOptions& options) const
+    {
+        VectorBlockSink sink(blocks, &index);
+        generate(sink, options);
+    }
+
+    void LayoutSnapshot::generate(BlockSink& sink, const GenerateOptions& options) const
+    {
+        if (const GenerateStatus status = validation; !status) throw FloahError(status.getMessage());
+
+        generateValidated(sink, options);
+    }
+
+    GenerateStatus LayoutSnapshot::tryGenerate(std::vector<Block>&    blocks,
+                                               BlockIndex&            index,
+                                               const GenerateOptions& options) const noexcept
+    {
+        if (validation != GenerateError::None) return validation;
+
+        // The vector sink only throws when allocating, so every exception is mapped to a status.
+        VectorBlockSink sink(blocks, &index);
+        const auto      status = tryGenerateValidated(sink, options);
+        if (!status)
+        {
+            blocks.clear();
+            index.clear();
+        }
+        return status;
+    }
+
+    GenerateStatus LayoutSnapshot::tryGenerate(BlockSink& sink, const GenerateOptions& options) const
+    {
+        if (validation != GenerateError::None) return validation;
+
+        return tryGenerateValidated(sink, options);
+    }
+
+    GenerateStatus LayoutSnapshot::tryGenerateValidated(BlockSink& sink, const GenerateOptions& options) const
+    {
+        try
+        {
+            generateValidated(sink, options);
+        }
+        catch (const std::bad_alloc&)
+        {
+            return GenerateError::OutOfMemory;
+        }
+        return {};
+    }
+
+    void LayoutSnapshot::generateValidated(BlockSink& sink, const GenerateOptions& options) const
+    {
+        if (nodeCount == 0)
+        {
+            sink.begin(0);
+            sink.end(0);
+            return;
+        }
+
+        Generator<SnapshotTree> generator(options, SnapshotTree(*this));
+        generator.generate(getRoot(), calculateRootBounds(), elementCount, sink);
+    }
+
+    BBox LayoutSnapshot::calculateRootBounds() const noexcept
+    {
+        assert(validation == GenerateError::None);
+
+        const auto& root   = getRoot();
+        const auto  left   = root.getOuterMargin().getLeft().get(size.getWidth().get()) + offset.getWidth().get();
+        const auto  top    = root.getOuterMargin().getTop().get(size.getHeight().get()) + offset.getHeight().get();
+        const auto  width  = root.getSize().getWidth().get(size.getWidth().get());
+        const auto  height = root.getSize().getHeight().get(size.getHeight().get());
+        return BBox{.x0 = left, .y0 = top, .x1 = left + width, .y1 = top + height};
+    }
+}  // namespace floah
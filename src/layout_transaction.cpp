@@ -0,0 +1,61 @@
+#include "floah-layout/layout_transaction.h"
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-common/floah_error.h"
+
+namespace floah
+{
+    ////////////////////////////////////////////////////////////////
+    // Constructors.
+    ////////////////////////////////////////////////////////////////
+
+    LayoutTransaction::LayoutTransaction(Layout& l, const bool undoLog) :
+        layout(l), undo(undoLog), size(l.getSize()), offset(l.getOffset())
+    {
+        layout.beginTransaction();
+        if (undo) previousUndoStart = layout.beginUndoLog();
+    }
+
+    LayoutTransaction::~LayoutTransaction() noexcept
+    {
+        if (!open) return;
+        if (undo) layout.endUndoLog(previousUndoStart, false);
+        layout.endTransaction();
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Getters.
+    ////////////////////////////////////////////////////////////////
+
+    bool LayoutTransaction::isOpen() const noexcept { return open; }
+
+    bool LayoutTransaction::hasUndoLog() const noexcept { return open && undo; }
+
+    ////////////////////////////////////////////////////////////////
+    // Modifiers.
+    ////////////////////////////////////////////////////////////////
+
+    void LayoutTransaction::commit()
+    {
+        if (!open) throw FloahError("Cannot commit transaction. Transaction is not open.");
+
+        open = false;
+        if (undo) layout.endUndoLog(previousUndoStart, false);
+        layout.endTransaction();
+    }
+
+    void LayoutTransaction::rollback()
+    {
+        if (!open) throw FloahError("Cannot roll back transaction. Transaction is not open.");
+        if (!undo) throw FloahError("Cannot roll back transaction. Transaction has no undo log.");
+
+        open = false;
+        layout.endUndoLog(previousUndoStart, true);
+        layout.getSize()   = size;
+        layout.getOffset() = offset;
+        layout.endTransaction();
+    }
+}  // namespace floah
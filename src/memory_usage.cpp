@@ -0,0 +1,28 @@
+#include "floah-layout/memory_usage.h"
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstring>
+
+namespace floah
+{
+    void MemoryUsage::addElement(const char* type, const size_t bytes, const size_t wasted)
+    {
+        elementCount++;
+        elementBytes += bytes;
+        wastedBytes += wasted;
+
+        // There are only a handful of types, so a linear search is fine. Names are compared by value, since typeid
+        // names are not guaranteed to be unique pointers across shared libraries.
+        auto it = std::ranges::find_if(
+          elementTypes, [type](const ElementType& t) { return t.name == type || std::strcmp(t.name, type) == 0; });
+        if (it == elementTypes.end()) it = elementTypes.insert(it, ElementType{.name = type});
+
+        it->count++;
+        it->bytes += bytes;
+        it->wastedBytes += wasted;
+    }
+}  // namespace floah
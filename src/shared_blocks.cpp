@@ -0,0 +1,378 @@
+#include "floah-layout/shared_blocks.h"
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+////////////////////////////////////////////////////////////////
+// External includes.
+////////////////////////////////////////////////////////////////
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-common/floah_error.h"
+#include "compare.h"
+
+namespace floah
+{
+    namespace
+    {
+        constexpr uint32_t ringMagic = 0x464c4252;
+
+        /**
+         * \brief Incremented whenever the memory layout of the ring changes.
+         */
+        constexpr uint32_t ringFormat = 1;
+
+        /**
+         * \brief Alignment of the header and of each slot and array, to keep slots on separate cache lines.
+         */
+        constexpr size_t ringAlignment = 64;
+
+        static_assert(std::atomic<uint64_t>::is_always_lock_free, "Atomics in shared memory must be lock-free.");
+        static_assert(std::is_trivially_copyable_v<Block>, "Blocks are copied into shared memory.");
+
+        struct RingHeader
+        {
+            uint32_t magic = 0;
+
+            uint32_t format = 0;
+
+            /**
+             * \brief Size of a block, as a check that reader and writer agree on its layout.
+             */
+            uint64_t blockSize = 0;
+
+            uint64_t capacity = 0;
+
+            uint64_t slotCount = 0;
+
+            /**
+             * \brief Number of the last completed frame.
+             */
+            std::atomic<uint64_t> latest = 0;
+        };
+
+        struct RingSlot
+        {
+            /**
+             * \brief Sequence lock. Odd while the writer is writing to the slot.
+             */
+            std::atomic<uint64_t> sequence = 0;
+
+            uint64_t number = 0;
+
+            uint64_t base = 0;
+
+            uint64_t count = 0;
+
+            uint64_t totalCount = 0;
+        };
+
+        [[nodiscard]] constexpr size_t alignSize(const size_t size) noexcept
+        {
+            return (size + ringAlignment - 1) / ringAlignment * ringAlignment;
+        }
+
+        [[nodiscard]] constexpr size_t getIndicesOffset() noexcept { return alignSize(sizeof(RingSlot)); }
+
+        [[nodiscard]] constexpr size_t getBlocksOffset(const size_t capacity) noexcept
+        {
+            return getIndicesOffset() + alignSize(capacity * sizeof(uint64_t));
+        }
+
+        [[nodiscard]] constexpr size_t getSlotSize(const size_t capacity) noexcept
+        {
+            return getBlocksOffset(capacity) + alignSize(capacity * sizeof(Block));
+        }
+
+        [[nodiscard]] constexpr size_t getRingSize(const size_t capacity, const size_t slotCount) noexcept
+        {
+            return alignSize(sizeof(RingHeader)) + slotCount * getSlotSize(capacity);
+        }
+
+        /**
+         * \brief Get the start of a slot. Works for both mutable and const memory.
+         */
+        template<typename T>
+        [[nodiscard]] T* getSlotMemory(T* memory, const size_t capacity, const size_t slot) noexcept
+        {
+            return memory + alignSize(sizeof(RingHeader)) + slot * getSlotSize(capacity);
+        }
+    }  // namespace
+
+    ////////////////////////////////////////////////////////////////
+    // SharedBlockWriter.
+    ////////////////////////////////////////////////////////////////
+
+    SharedBlockWriter::SharedBlockWriter(std::string n, const size_t cap, const size_t slots) :
+        name(std::move(n)), capacity(cap), slotCount(slots), bytes(getRingSize(cap, slots))
+    {
+        if (capacity == 0) throw FloahError("Cannot create shared block ring. Capacity must be at least 1.");
+        if (slotCount < 2) throw FloahError("Cannot create shared block ring. Slot count must be at least 2.");
+
+        // Reserve now, so that publishing does not allocate.
+        previous.reserve(capacity);
+        changed.reserve(capacity);
+
+        // Never unlink an existing object: it may belong to another writer, whose readers would silently lose it.
+        const auto fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0 && errno == EEXIST)
+            throw FloahError("Cannot create shared block ring. A shared memory object with this name already exists.");
+        if (fd < 0) throw FloahError("Cannot create shared block ring. Failed to create shared memory object.");
+
+        if (ftruncate(fd, static_cast<off_t>(bytes)) != 0)
+        {
+            close(fd);
+            shm_unlink(name.c_str());
+            throw FloahError("Cannot create shared block ring. Failed to resize shared memory object.");
+        }
+
+        auto* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED)
+        {
+            shm_unlink(name.c_str());
+            throw FloahError("Cannot create shared block ring. Failed to map shared memory object.");
+        }
+
+        // The object is zero-filled on creation, but construct everything properly anyway.
+        memory = static_cast<std::byte*>(mapped);
+        for (size_t i = 0; i < slotCount; i++) new (getSlotMemory(memory, capacity, i)) RingSlot;
+        auto* header      = new (memory) RingHeader;
+        header->format    = ringFormat;
+        header->blockSize = sizeof(Block);
+        header->capacity  = capacity;
+        header->slotCount = slotCount;
+
+        // Written last, readers check it first.
+        std::atomic_thread_fence(std::memory_order_release);
+        header->magic = ringMagic;
+    }
+
+    SharedBlockWriter::~SharedBlockWriter() noexcept
+    {
+        munmap(memory, bytes);
+        shm_unlink(name.c_str());
+    }
+
+    const std::string& SharedBlockWriter::getName() const noexcept { return name; }
+
+    size_t SharedBlockWriter::getCapacity() const noexcept { return capacity; }
+
+    size_t SharedBlockWriter::getSlotCount() const noexcept { return slotCount; }
+
+    uint64_t SharedBlockWriter::getFrameNumber() const noexcept { return frameNumber; }
+
+    uint64_t SharedBlockWriter::publish(const std::span<const Block> blocks)
+    {
+        if (blocks.size() > capacity) throw FloahError("Cannot publish blocks. Block count exceeds capacity.");
+
+        // A full frame at least every half ring, so that there is always one in the ring to start from.
+        const auto number      = frameNumber + 1;
+        const auto keyInterval = slotCount / 2;
+        auto       delta       = keyFrame != 0 && number - keyFrame < keyInterval && blocks.size() == previous.size();
+        changed.clear();
+        if (delta)
+        {
+            for (size_t i = 0; i < blocks.size(); i++)
+            {
+                if (!isEqual(blocks[i], previous[i])) changed.push_back(i);
+            }
+
+            // A delta that holds most blocks is not worth it.
+            delta = changed.size() * 2 <= blocks.size();
+        }
+
+        auto*      slotMemory = getSlotMemory(memory, capacity, number % slotCount);
+        auto*      slot       = reinterpret_cast<RingSlot*>(slotMemory);
+        auto*      indices    = reinterpret_cast<uint64_t*>(slotMemory + getIndicesOffset());
+        auto*      data       = reinterpret_cast<Block*>(slotMemory + getBlocksOffset(capacity));
+        const auto sequence   = slot->sequence.load(std::memory_order_relaxed);
+
+        // Mark slot as being written.
+        slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot->number     = number;
+        slot->base       = delta ? number - 1 : 0;
+        slot->totalCount = blocks.size();
+        if (delta)
+        {
+            slot->count = changed.size();
+            for (size_t i = 0; i < changed.size(); i++)
+            {
+                indices[i] = changed[i];
+                data[i]    = blocks[changed[i]];
+            }
+        }
+        else
+        {
+            slot->count = blocks.size();
+            std::memcpy(data, blocks.data(), blocks.size() * sizeof(Block));
+        }
+
+        slot->sequence.store(sequence + 2, std::memory_order_release);
+        reinterpret_cast<RingHeader*>(memory)->latest.store(number, std::memory_order_release);
+
+        frameNumber = number;
+        if (!delta) keyFrame = number;
+        previous.assign(blocks.begin(), blocks.end());
+        return number;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // SharedBlockReader.
+    ////////////////////////////////////////////////////////////////
+
+    SharedBlockReader::SharedBlockReader(const std::string& name)
+    {
+        const auto fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) throw FloahError("Cannot open shared block ring. Failed to open shared memory object.");
+
+        struct stat info = {};
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(RingHeader))
+        {
+            close(fd);
+            throw FloahError("Cannot open shared block ring. Shared memory object is too small.");
+        }
+
+        bytes        = static_cast<size_t>(info.st_size);
+        auto* mapped = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED)
+            throw FloahError("Cannot open shared block ring. Failed to map shared memory object.");
+
+        memory             = static_cast<const std::byte*>(mapped);
+        const auto* header = reinterpret_cast<const RingHeader*>(memory);
+        const auto  magic  = header->magic;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        capacity  = static_cast<size_t>(header->capacity);
+        slotCount = static_cast<size_t>(header->slotCount);
+        if (magic != ringMagic || header->format != ringFormat || header->blockSize != sizeof(Block) ||
+            slotCount < 2 || getRingSize(capacity, slotCount) > bytes)
+        {
+            munmap(mapped, bytes);
+            throw FloahError("Cannot open shared block ring. Format does not match.");
+        }
+    }
+
+    SharedBlockReader::~SharedBlockReader() noexcept { munmap(const_cast<std::byte*>(memory), bytes); }
+
+    size_t SharedBlockReader::getCapacity() const noexcept { return capacity; }
+
+    size_t SharedBlockReader::getSlotCount() const noexcept { return slotCount; }
+
+    uint64_t SharedBlockReader::getLatestFrameNumber() const noexcept
+    {
+        return reinterpret_cast<const RingHeader*>(memory)->latest.load(std::memory_order_acquire);
+    }
+
+    bool SharedBlockReader::acquire(const uint64_t number, SharedBlockFrame& frame) const noexcept
+    {
+        if (number == 0) return false;
+
+        const auto  index      = static_cast<size_t>(number % slotCount);
+        const auto* slotMemory = getSlotMemory(memory, capacity, index);
+        const auto* slot       = reinterpret_cast<const RingSlot*>(slotMemory);
+        const auto  sequence   = slot->sequence.load(std::memory_order_acquire);
+        if (sequence & 1) return false;
+
+        const auto slotNumber = slot->number;
+        const auto base       = slot->base;
+        const auto count      = std::min<uint64_t>(slot->count, capacity);
+        const auto totalCount = slot->totalCount;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->sequence.load(std::memory_order_relaxed) != sequence || slotNumber != number) return false;
+
+        const auto* indices = reinterpret_cast<const uint64_t*>(slotMemory + getIndicesOffset());
+        const auto* data    = reinterpret_cast<const Block*>(slotMemory + getBlocksOffset(capacity));
+        frame.number        = number;
+        frame.base          = base;
+        frame.totalCount    = static_cast<size_t>(totalCount);
+        frame.indices       = base != 0 ? std::span(indices, count) : std::span<const uint64_t>();
+        frame.blocks        = std::span(data, count);
+        frame.sequence      = sequence;
+        frame.slot          = index;
+        return true;
+    }
+
+    bool SharedBlockReader::validate(const SharedBlockFrame& frame) const noexcept
+    {
+        const auto* slot = reinterpret_cast<const RingSlot*>(getSlotMemory(memory, capacity, frame.slot));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot->sequence.load(std::memory_order_relaxed) == frame.sequence;
+    }
+
+    bool SharedBlockReader::update(std::vector<Block>& blocks, uint64_t& number) const
+    {
+        const auto latest = getLatestFrameNumber();
+        if (latest == number) return false;
+
+        // Apply all frames since the local copy, if they are still in the ring.
+        if (number != 0 && latest > number && latest - number < slotCount && apply(blocks, number, latest))
+        {
+            number = latest;
+            return true;
+        }
+
+        // Otherwise start again from the most recent full frame.
+        for (auto key = latest; key > 0 && latest - key < slotCount; key--)
+        {
+            if (SharedBlockFrame frame; !acquire(key, frame) || frame.base != 0) continue;
+
+            if (apply(blocks, key - 1, latest))
+            {
+                number = latest;
+                return true;
+            }
+            break;
+        }
+
+        // Fell too far behind, or the writer is lapping this reader.
+        const auto hadBlocks = number != 0;
+        blocks.clear();
+        number = 0;
+        return hadBlocks;
+    }
+
+    bool SharedBlockReader::apply(std::vector<Block>& blocks, const uint64_t number, const uint64_t last) const
+    {
+        for (auto n = number + 1; n <= last; n++)
+        {
+            SharedBlockFrame frame;
+            if (!acquire(n, frame)) return false;
+
+            if (frame.base == 0)
+                blocks.assign(frame.blocks.begin(), frame.blocks.end());
+            else
+            {
+                if (frame.base != n - 1 || blocks.size() != frame.totalCount) return false;
+                for (size_t i = 0; i < frame.blocks.size(); i++)
+                {
+                    const auto index = frame.indices[i];
+                    if (index >= blocks.size()) return false;
+                    blocks[static_cast<size_t>(index)] = frame.blocks[i];
+                }
+            }
+
+            if (!validate(frame)) return false;
+        }
+
+        return true;
+    }
+}  // namespace floah
@@ -0,0 +1,286 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <vector>
+
+////////////////////////////////////////////////////////////////
+// External includes.
+////////////////////////////////////////////////////////////////
+
+#include "uuid.h"
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-layout/block.h"
+#include "floah-layout/flex.h"
+#include "floah-layout/layout_scratch.h"
+#include "floah-layout/elements/grid.h"
+#include "floah-common/alignment.h"
+#include "floah-common/margin.h"
+#include "floah-common/size.h"
+
+namespace floah
+{
+    class LayoutSnapshot;
+
+    /**
+     * \brief Type of the element a SnapshotNode was captured from.
+     */
+    enum class SnapshotNodeKind : uint8_t
+    {
+        /**
+         * \brief Empty position in the list of children, e.g. a free grid cell.
+         */
+        Empty,
+        Element,
+        HorizontalFlow,
+        VerticalFlow,
+        WrapFlow,
+        Grid,
+        ScrollView,
+
+        /**
+         * \brief Element of any other type. Laid out through a copy of the element kept by the snapshot.
+         */
+        Custom
+    };
+
+    /**
+     * \brief Layout parameters of a single element, captured by LayoutSnapshot. Plain data, so that nodes are copied
+     * and compared without touching any element. Parameters that the type of the element does not have keep their
+     * default value. The getters have the same names as those of the element types, so that the layout code of an
+     * element type can be shared between elements and nodes. Children are referenced by their position in the
+     * snapshot, so a node is only meaningful together with the snapshot it is part of (see SnapshotTree).
+     */
+    class SnapshotNode
+    {
+        friend class LayoutSnapshot;
+        friend class SnapshotTree;
+
+    public:
+        ////////////////////////////////////////////////////////////////
+        // Getters.
+        ////////////////////////////////////////////////////////////////
+
+        [[nodiscard]] SnapshotNodeKind getKind() const noexcept { return kind; }
+
+        [[nodiscard]] const uuids::uuid& getId() const noexcept { return id; }
+
+        [[nodiscard]] const Size& getSize() const noexcept { return size; }
+
+        [[nodiscard]] const Margin& getInnerMargin() const noexcept { return innerMargin; }
+
+        [[nodiscard]] const Margin& getOuterMargin() const noexcept { return outerMargin; }
+
+        [[nodiscard]] const Flex& getFlex() const noexcept { return flex; }
+
+        [[nodiscard]] HorizontalAlignment getHorizontalAlignment() const noexcept { return horAlign; }
+
+        [[nodiscard]] VerticalAlignment getVerticalAlignment() const noexcept { return verAlign; }
+
+        [[nodiscard]] size_t getRowCount() const noexcept { return rowCount; }
+
+        [[nodiscard]] size_t getColumnCount() const noexcept { return columnCount; }
+
+        /**
+         * \brief Get the number of cells covered by this node in its parent grid.
+         * \return Span. 1 by 1 if the parent is not a grid.
+         */
+        [[nodiscard]] Grid::CellSpan getCellSpan() const noexcept
+        {
+            return Grid::CellSpan{.columns = spanColumns, .rows = spanRows};
+        }
+
+        [[nodiscard]] const Size& getContentSize() const noexcept { return contentSize; }
+
+        [[nodiscard]] int32_t getScrollX() const noexcept { return scrollX; }
+
+        [[nodiscard]] int32_t getScrollY() const noexcept { return scrollY; }
+
+        /**
+         * \brief Get the hash of the element this node was captured from (see LayoutElement::getLayoutHash).
+         * \return Hash.
+         */
+        [[nodiscard]] uint64_t getLayoutHash() const noexcept { return layoutHash; }
+
+        /**
+         * \brief Returns whether the other node was captured from an element with the same identifier, type, layout
+         * parameters, layout hash and position of children. The hash also covers parameters that are stored in the
+         * children, like grid spans. Nodes of custom elements are never equal, since their parameters cannot be
+         * compared without the elements.
+         * \param other Other node.
+         * \return True if equal.
+         */
+        [[nodiscard]] bool isEqual(const SnapshotNode& other) const noexcept;
+
+    private:
+        ////////////////////////////////////////////////////////////////
+        // Member variables.
+        ////////////////////////////////////////////////////////////////
+
+        uuids::uuid id;
+
+        uint64_t layoutHash = 0;
+
+        Size size;
+
+        Margin innerMargin;
+
+        Margin outerMargin;
+
+        Flex flex;
+
+        /**
+         * \brief Content size of a ScrollView.
+         */
+        Size contentSize;
+
+        int32_t scrollX = 0;
+
+        int32_t scrollY = 0;
+
+        /**
+         * \brief Position of first child node in the snapshot. Children are stored next to each other.
+         */
+        uint32_t firstChild = 0;
+
+        uint32_t childCount = 0;
+
+        uint32_t rowCount = 0;
+
+        uint32_t columnCount = 0;
+
+        uint32_t spanColumns = 1;
+
+        uint32_t spanRows = 1;
+
+        /**
+         * \brief Index of the copy of a custom element in the snapshot.
+         */
+        uint32_t custom = 0;
+
+        SnapshotNodeKind kind = SnapshotNodeKind::Empty;
+
+        HorizontalAlignment horAlign = HorizontalAlignment::Left;
+
+        VerticalAlignment verAlign = VerticalAlignment::Top;
+    };
+
+    /**
+     * \brief Number of nodes per chunk of a snapshot. A power of 2, so that finding the chunk of a node is a shift.
+     */
+    inline constexpr size_t snapshotChunkSize = 256;
+
+    /**
+     * \brief Chunk of consecutive nodes. Chunks are immutable once created, so snapshots share the chunks that did not
+     * change between them.
+     */
+    using SnapshotChunk = std::vector<SnapshotNode>;
+
+    /**
+     * \brief List of the child nodes of a node. Behaves like the list returned by LayoutElement::getChildren, except
+     * that entries are pointers to nodes, and nullptr for empty positions.
+     */
+    class SnapshotChildren
+    {
+    public:
+        class Iterator
+        {
+        public:
+            using value_type      = const SnapshotNode*;
+            using difference_type = std::ptrdiff_t;
+
+            Iterator() = default;
+
+            Iterator(const SnapshotChildren* c, const size_t i) noexcept : children(c), index(i) {}
+
+            [[nodiscard]] const SnapshotNode* operator*() const noexcept { return (*children)[index]; }
+
+            Iterator& operator++() noexcept
+            {
+                index++;
+                return *this;
+            }
+
+            Iterator operator++(int) noexcept
+            {
+                auto it = *this;
+                index++;
+                return it;
+            }
+
+            [[nodiscard]] bool operator==(const Iterator& other) const noexcept { return index == other.index; }
+
+        private:
+            const SnapshotChildren* children = nullptr;
+
+            size_t index = 0;
+        };
+
+        SnapshotChildren() = default;
+
+        SnapshotChildren(const std::span<const std::shared_ptr<const SnapshotChunk>> c,
+                         const size_t                                               f,
+                         const size_t                                               count) noexcept :
+            chunks(c), first(f), childCount(count)
+        {
+        }
+
+        [[nodiscard]] size_t size() const noexcept { return childCount; }
+
+        [[nodiscard]] bool empty() const noexcept { return childCount == 0; }
+
+        [[nodiscard]] const SnapshotNode* operator[](const size_t i) const noexcept
+        {
+            const auto  index = first + i;
+            const auto& node  = (*chunks[index / snapshotChunkSize])[index % snapshotChunkSize];
+            return node.getKind() == SnapshotNodeKind::Empty ? nullptr : &node;
+        }
+
+        [[nodiscard]] Iterator begin() const noexcept { return {this, 0}; }
+
+        [[nodiscard]] Iterator end() const noexcept { return {this, childCount}; }
+
+    private:
+        std::span<const std::shared_ptr<const SnapshotChunk>> chunks;
+
+        size_t first = 0;
+
+        size_t childCount = 0;
+    };
+
+    /**
+     * \brief Lets a Generator traverse the nodes of a snapshot (see ElementTree).
+     */
+    class SnapshotTree
+    {
+    public:
+        using Element = SnapshotNode;
+
+        explicit SnapshotTree(const LayoutSnapshot& s) noexcept : snapshot(&s) {}
+
+        [[nodiscard]] SnapshotChildren getChildren(const SnapshotNode& node) const noexcept;
+
+        [[nodiscard]] bool getContentClip(const SnapshotNode& node, const BBox& bounds, BBox& clip) const noexcept;
+
+        void layoutChildren(const SnapshotNode& node,
+                            const BBox&         bounds,
+                            std::span<BBox>     childBounds,
+                            LayoutScratch&      scratch) const;
+
+        [[nodiscard]] static uint64_t getLayoutHash(const SnapshotNode& node) noexcept { return node.getLayoutHash(); }
+
+    private:
+        const LayoutSnapshot* snapshot = nullptr;
+    };
+}  // namespace floah
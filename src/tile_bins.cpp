@@ -0,0 +1,240 @@
+#include "floah-layout/tile_bins.h"
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <thread>
+#include <utility>
+
+////////////////////////////////////////////////////////////////
+// Current target includes.
+////////////////////////////////////////////////////////////////
+
+#include "floah-common/floah_error.h"
+
+namespace floah
+{
+    namespace
+    {
+        /**
+         * \brief Label of a block whose subtree lies outside of the area.
+         */
+        constexpr uint32_t outside = std::numeric_limits<uint32_t>::max();
+
+        /**
+         * \brief Label of a block whose subtree overlaps more than one tile.
+         */
+        constexpr uint32_t multiple = outside - 1;
+
+        /**
+         * \brief Below this number of blocks per thread, starting threads costs more than it saves.
+         */
+        constexpr size_t minBlocksPerThread = 4096;
+
+        /**
+         * \brief Get the number of tiles needed to cover [from, to) along one axis.
+         */
+        [[nodiscard]] int64_t getTileCount(const int32_t from, const int32_t to, const int32_t size) noexcept
+        {
+            if (to <= from) return 0;
+            return (static_cast<int64_t>(to) - from + size - 1) / size;
+        }
+
+        /**
+         * \brief Run a function once for each thread index in [0, count), on count threads.
+         */
+        template<typename F>
+        void parallelFor(const size_t count, F&& f)
+        {
+            std::vector<std::jthread> workers;
+            workers.reserve(count - 1);
+            for (size_t t = 1; t < count; t++) workers.emplace_back(f, t);
+            f(size_t{0});
+        }
+    }  // namespace
+
+    ////////////////////////////////////////////////////////////////
+    // Constructors.
+    ////////////////////////////////////////////////////////////////
+
+    TileBins::TileBins() = default;
+
+    TileBins::TileBins(const TileBins&) = default;
+
+    TileBins::TileBins(TileBins&&) noexcept = default;
+
+    TileBins::~TileBins() noexcept = default;
+
+    TileBins& TileBins::operator=(const TileBins&) = default;
+
+    TileBins& TileBins::operator=(TileBins&&) noexcept = default;
+
+    ////////////////////////////////////////////////////////////////
+    // Getters.
+    ////////////////////////////////////////////////////////////////
+
+    const BBox& TileBins::getArea() const noexcept { return area; }
+
+    int32_t TileBins::getTileWidth() const noexcept { return tileWidth; }
+
+    int32_t TileBins::getTileHeight() const noexcept { return tileHeight; }
+
+    size_t TileBins::getColumnCount() const noexcept { return columnCount; }
+
+    size_t TileBins::getRowCount() const noexcept { return rowCount; }
+
+    std::span<const size_t> TileBins::getOffsets() const noexcept { return offsets; }
+
+    std::span<const size_t> TileBins::getIndices() const noexcept { return indices; }
+
+    std::span<const size_t> TileBins::getTile(const size_t column, const size_t row) const
+    {
+        if (column >= columnCount || row >= rowCount) throw FloahError("Cannot get tile. Index is out of range.");
+
+        const auto k = row * columnCount + column;
+        return std::span(indices).subspan(offsets[k], offsets[k + 1] - offsets[k]);
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Modifiers.
+    ////////////////////////////////////////////////////////////////
+
+    void TileBins::build(const std::span<const Block> blocks,
+                         const BBox&                  bounds,
+                         const int32_t                width,
+                         const int32_t                height,
+                         const size_t                 threadCount)
+    {
+        if (width <= 0 || height <= 0) throw FloahError("Cannot build tile bins. Tile size must be positive.");
+
+        const auto columns = getTileCount(bounds.x0, bounds.x1, width);
+        const auto rows    = getTileCount(bounds.y0, bounds.y1, height);
+        if (columns * rows >= multiple) throw FloahError("Cannot build tile bins. Too many tiles.");
+
+        area        = bounds;
+        tileWidth   = width;
+        tileHeight  = height;
+        columnCount = static_cast<size_t>(columns);
+        rowCount    = static_cast<size_t>(rows);
+
+        // Find the blocks whose whole subtree falls into a single tile. Parents always have a smaller index than their
+        // children, so their label is known when the children are reached.
+        const auto count = blocks.size();
+        labels.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            const auto parent = blocks[i].parent;
+            assert(parent == Block::noParent || parent < i);
+            if (parent != Block::noParent && labels[parent] != multiple)
+            {
+                labels[i] = labels[parent];
+                continue;
+            }
+
+            // A subtree that sticks out of the area can contain blocks outside of it, so it cannot be binned at once.
+            const auto& bb = blocks[i].childBounds;
+            const auto  in = bb.x0 >= area.x0 && bb.x1 <= area.x1 && bb.y0 >= area.y0 && bb.y1 <= area.y1;
+            TileRange   range;
+            if (!getTileRange(bb, range))
+                labels[i] = outside;
+            else if (in && range.column0 == range.column1 && range.row0 == range.row1)
+                labels[i] = static_cast<uint32_t>(range.row0 * columnCount + range.column0);
+            else
+                labels[i] = multiple;
+        }
+
+        auto threads = threadCount > 0 ? threadCount : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        threads      = std::clamp<size_t>((count + minBlocksPerThread - 1) / minBlocksPerThread, 1, threads);
+
+        // Each thread handles a contiguous range of blocks, so that concatenating the per-thread lists of a tile keeps
+        // the blocks in order.
+        const auto tiles = columnCount * rowCount;
+        cursors.assign(threads * tiles, 0);
+        parallelFor(threads, [&](const size_t t) {
+            binRange(blocks, count * t / threads, count * (t + 1) / threads, cursors.data() + t * tiles, false);
+        });
+
+        offsets.resize(tiles + 1);
+        size_t total = 0;
+        for (size_t k = 0; k < tiles; k++)
+        {
+            offsets[k] = total;
+            for (size_t t = 0; t < threads; t++)
+            {
+                auto& cursor = cursors[t * tiles + k];
+                total += std::exchange(cursor, total);
+            }
+        }
+        offsets[tiles] = total;
+
+        indices.resize(total);
+        parallelFor(threads, [&](const size_t t) {
+            binRange(blocks, count * t / threads, count * (t + 1) / threads, cursors.data() + t * tiles, true);
+        });
+    }
+
+    void TileBins::clear() noexcept
+    {
+        area        = BBox{};
+        tileWidth   = 0;
+        tileHeight  = 0;
+        columnCount = 0;
+        rowCount    = 0;
+        offsets.clear();
+        indices.clear();
+        labels.clear();
+        cursors.clear();
+    }
+
+    bool TileBins::getTileRange(const BBox& bounds, TileRange& range) const noexcept
+    {
+        if (columnCount == 0 || rowCount == 0) return false;
+
+        if (bounds.x1 <= bounds.x0 || bounds.y1 <= bounds.y0) return false;
+        if (bounds.x0 >= area.x1 || bounds.x1 <= area.x0 || bounds.y0 >= area.y1 || bounds.y1 <= area.y0) return false;
+
+        range.column0 = static_cast<size_t>((std::max(bounds.x0, area.x0) - area.x0) / tileWidth);
+        range.row0    = static_cast<size_t>((std::max(bounds.y0, area.y0) - area.y0) / tileHeight);
+        range.column1 = static_cast<size_t>((std::min(bounds.x1, area.x1) - 1 - area.x0) / tileWidth);
+        range.row1    = static_cast<size_t>((std::min(bounds.y1, area.y1) - 1 - area.y0) / tileHeight);
+        return true;
+    }
+
+    void TileBins::binRange(const std::span<const Block> blocks,
+                            const size_t                 begin,
+                            const size_t                 end,
+                            size_t*                      tileCursors,
+                            const bool                   fill) noexcept
+    {
+        const auto add = [&](const size_t tile, const size_t index) {
+            if (fill) indices[tileCursors[tile]] = index;
+            tileCursors[tile]++;
+        };
+
+        for (size_t i = begin; i < end; i++)
+        {
+            const auto& block = blocks[i];
+            const auto  label = labels[i];
+            if (label == outside || any(block.flags, BlockFlags::Culled | BlockFlags::Clipped)) continue;
+            if (block.bounds.x1 <= block.bounds.x0 || block.bounds.y1 <= block.bounds.y0) continue;
+
+            // Subtree is inside a single tile.
+            if (label != multiple)
+            {
+                add(label, i);
+                continue;
+            }
+
+            TileRange range;
+            if (!getTileRange(block.bounds, range)) continue;
+            for (auto row = range.row0; row <= range.row1; row++)
+            {
+                for (auto column = range.column0; column <= range.column1; column++) add(row * columnCount + column, i);
+            }
+        }
+    }
+}  // namespace floah
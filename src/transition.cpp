@@ -0,0 +1,204 @@
+#include "floah-layout/transition.h"
+
+////////////////////////////////////////////////////////////////
+// Standard includes.
+////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cassert>
+
+namespace floah
+{
+    namespace
+    {
+        [[nodiscard]] BBox collapse(const BBox& bounds) noexcept
+        {
+            const auto x = bounds.x0 + ((bounds.x1 - bounds.x0) >> 1);
+            const auto y = bounds.y0 + ((bounds.y1 - bounds.y0) >> 1);
+            return BBox{.x0 = x, .y0 = y, .x1 = x, .y1 = y};
+        }
+    }  // namespace
+
+    float ease(const Easing easing, const float t) noexcept
+    {
+        switch (easing)
+        {
+        case Easing::Linear: return t;
+        case Easing::EaseIn: return t * t;
+        case Easing::EaseOut: return t * (2.0f - t);
+        case Easing::EaseInOut: return t * t * (3.0f - 2.0f * t);
+        }
+        return t;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Constructors.
+    ////////////////////////////////////////////////////////////////
+
+    Transition::Transition() = default;
+
+    Transition::Transition(const Transition&) = default;
+
+    Transition::Transition(Transition&&) noexcept = default;
+
+    Transition::~Transition() noexcept = default;
+
+    Transition& Transition::operator=(const Transition&) = default;
+
+    Transition& Transition::operator=(Transition&&) noexcept = default;
+
+    ////////////////////////////////////////////////////////////////
+    // Getters.
+    ////////////////////////////////////////////////////////////////
+
+    size_t Transition::size() const noexcept { return bounds.size(); }
+
+    size_t Transition::getMatchedCount() const noexcept { return matched; }
+
+    std::span<const size_t> Transition::getSourceIndices() const noexcept { return sources; }
+
+    std::span<const size_t> Transition::getLeavingIndices() const noexcept { return leaving; }
+
+    std::span<const BBox> Transition::getBounds() const noexcept { return bounds; }
+
+    ////////////////////////////////////////////////////////////////
+    // Modifiers.
+    ////////////////////////////////////////////////////////////////
+
+    void Transition::set(const std::span<const Block> from,
+                         const std::span<const Block> to,
+                         const TransitionOptions&     options)
+    {
+        clear();
+        easing = options.easing;
+
+        // Match end blocks to start blocks. If an identifier occurs more than once, only its first block is matched.
+        index.reserve(from.size());
+        for (size_t i = 0; i < from.size(); i++)
+        {
+            if (!from[i].id.is_nil()) index.insert(from[i].id, i);
+        }
+
+        targets.assign(from.size(), noIndex);
+        sources.resize(to.size());
+        for (size_t i = 0; i < to.size(); i++)
+        {
+            auto source = noIndex;
+            if (to[i].id.is_nil())
+            {
+                if (i < from.size() && from[i].id.is_nil()) source = i;
+            }
+            else if (const auto* j = index.find(to[i].id); j && targets[*j] == noIndex)
+                source = *j;
+
+            sources[i] = source;
+            if (source != noIndex)
+            {
+                targets[source] = i;
+                matched++;
+            }
+        }
+
+        // Nearest matched ancestor of each end block. Parents always have a smaller index than their children.
+        const auto mode = options.unmatched;
+        if (mode == UnmatchedMode::Parent)
+        {
+            ancestors.resize(to.size());
+            for (size_t i = 0; i < to.size(); i++)
+            {
+                const auto p = to[i].parent;
+                ancestors[i] = p == Block::noParent ? noIndex : sources[p] != noIndex ? p : ancestors[p];
+            }
+        }
+
+        starts.reserve(to.size());
+        deltas.reserve(to.size());
+        for (size_t i = 0; i < to.size(); i++)
+        {
+            const auto& end = to[i].bounds;
+            if (sources[i] != noIndex)
+                append(from[sources[i]].bounds, end);
+            else if (mode == UnmatchedMode::Snap)
+                append(end, end);
+            else if (mode == UnmatchedMode::Parent && ancestors[i] != noIndex)
+                append(from[sources[ancestors[i]]].bounds, end);
+            else
+                append(collapse(end), end);
+        }
+
+        // Nearest matched ancestor of each start block.
+        if (mode == UnmatchedMode::Parent)
+        {
+            ancestors.resize(from.size());
+            for (size_t i = 0; i < from.size(); i++)
+            {
+                const auto p = from[i].parent;
+                ancestors[i] = p == Block::noParent ? noIndex : targets[p] != noIndex ? p : ancestors[p];
+            }
+        }
+
+        // Start blocks that disappear follow after the end blocks.
+        for (size_t i = 0; i < from.size(); i++)
+        {
+            if (targets[i] != noIndex) continue;
+
+            const auto& start = from[i].bounds;
+            leaving.push_back(i);
+            if (mode == UnmatchedMode::Snap)
+                append(start, start);
+            else if (mode == UnmatchedMode::Parent && ancestors[i] != noIndex)
+                append(start, to[targets[ancestors[i]]].bounds);
+            else
+                append(start, collapse(start));
+        }
+
+        bounds = starts;
+        index.clear();
+    }
+
+    void Transition::clear() noexcept
+    {
+        matched = 0;
+        sources.clear();
+        leaving.clear();
+        starts.clear();
+        deltas.clear();
+        bounds.clear();
+    }
+
+    void Transition::append(const BBox& start, const BBox& end)
+    {
+        starts.push_back(start);
+        deltas.push_back(Delta{.x0 = static_cast<float>(end.x0 - start.x0),
+                               .y0 = static_cast<float>(end.y0 - start.y0),
+                               .x1 = static_cast<float>(end.x1 - start.x1),
+                               .y1 = static_cast<float>(end.y1 - start.y1)});
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Evaluate.
+    ////////////////////////////////////////////////////////////////
+
+    std::span<const BBox> Transition::evaluate(const float t) noexcept
+    {
+        assert(bounds.size() == starts.size());
+
+        // Written so that NaN is clamped to 0 as well.
+        const auto  e     = ease(easing, t > 0.0f ? std::min(t, 1.0f) : 0.0f);
+        const auto  count = bounds.size();
+        auto*       out   = bounds.data();
+        const auto* s     = starts.data();
+        const auto* d     = deltas.data();
+
+        // Branchless, so that the compiler can vectorize it.
+        for (size_t i = 0; i < count; i++)
+        {
+            out[i].x0 = s[i].x0 + static_cast<int32_t>(d[i].x0 * e);
+            out[i].y0 = s[i].y0 + static_cast<int32_t>(d[i].y0 * e);
+            out[i].x1 = s[i].x1 + static_cast<int32_t>(d[i].x1 * e);
+            out[i].y1 = s[i].y1 + static_cast<int32_t>(d[i].y1 * e);
+        }
+
+        return bounds;
+    }
+}  // namespace floah